@@ -3,9 +3,12 @@
 #include "serviceFuns.cpp"
 #include "BAMfunctions.h"
 #include "SequenceFuns.h"
+#include "radixSort.h"
 
-void BAMbinSortByCoordinate(uint32 iBin, uint binN, uint binS, uint nThreads, string dirBAMsort, Parameters &P, Genome &genome, Solo &solo) {
+void BAMbinSortByCoordinate(BAMsortBin &sortBin, uint nThreads, string dirBAMsort, Parameters &P, Solo &solo, ReadAlignChunk **RAchunk, int compressLevel, BAMsortThreads &sortThreads) {
 
+    uint32 iBin=sortBin.iBin;
+    uint binN=sortBin.binN, binS=sortBin.binS;
     if (binS==0) return; //nothing to do for empty bins
     //allocate arrays
     char *bamIn=new char[binS+1];
@@ -13,8 +16,18 @@ void BAMbinSortByCoordinate(uint32 iBin, uint binN, uint binS, uint nThreads, st
 
     uint bamInBytes=0;
     //load all aligns
-    for (uint it=0; it<nThreads; it++) {
-        string bamInFile=dirBAMsort+to_string(it)+"/"+to_string((uint) iBin);
+    vector <string> bamInFiles;
+    if (sortBin.iPart<0) {//aligns from all threads
+        for (uint it=0; it<nThreads; it++)
+            bamInFiles.push_back(dirBAMsort+to_string(it)+"/"+to_string((uint) iBin));
+    } else {//the part of the split bin was collected into one file
+        bamInFiles.push_back(dirBAMsort+"/s"+sortBin.name());
+    };
+    for (uint it=0; it<bamInFiles.size(); it++) {
+        if (sortBin.iPart<0)
+            bamInBytes += RAchunk[it]->chunkOutBAMcoord->coordBinMemLoad(iBin, bamIn+bamInBytes);//aligns kept in memory precede the aligns in the file
+
+        string bamInFile=bamInFiles[it];
         ifstream bamInStream;
         bamInStream.open(bamInFile.c_str(),std::ios::binary | std::ios::ate);//open at the end to get file size
         int64 s1=bamInStream.tellg();
@@ -23,7 +36,7 @@ void BAMbinSortByCoordinate(uint32 iBin, uint binN, uint binS, uint nThreads, st
             bamInStream.read(bamIn+bamInBytes,s1);//read the whole file
         } else if (s1<0) {
             ostringstream errOut;
-            errOut << "EXITING because of FATAL ERROR: failed reading from temporary file: " << dirBAMsort+to_string(it)+"/"+to_string((uint) iBin);
+            errOut << "EXITING because of FATAL ERROR: failed reading from temporary file: " << bamInFile;
             exitWithError(errOut.str(),std::cerr, P.inOut->logMain, 1, P);
         };
         bamInBytes += bamInStream.gcount();
@@ -33,7 +46,7 @@ void BAMbinSortByCoordinate(uint32 iBin, uint binN, uint binS, uint nThreads, st
     if (bamInBytes!=binS) {
         ostringstream errOut;
         errOut << "EXITING because of FATAL ERROR: number of bytes expected from the BAM bin does not agree with the actual size on disk: ";
-        errOut << "Expected bin size=" <<binS <<" ; size on disk="<< bamInBytes <<" ; bin number="<< iBin <<"\n";
+        errOut << "Expected bin size=" <<binS <<" ; size on disk="<< bamInBytes <<" ; bin number="<< sortBin.name() <<"\n";
         exitWithError(errOut.str(),std::cerr, P.inOut->logMain, 1, P);
     };
 
@@ -48,33 +61,65 @@ void BAMbinSortByCoordinate(uint32 iBin, uint binN, uint binS, uint nThreads, st
         ib+=sizeof(uint);
     };
 
-    //sort
-    qsort((void*) startPos, binN, sizeof(uint)*3, funCompareArrays<uint,3>);
-
-    BGZF *bgzfBin;
-    bgzfBin=bgzf_open((dirBAMsort+"/b"+to_string((uint) iBin)).c_str(),("w"+to_string((long long) P.outBAMcompression)).c_str());
-    if (bgzfBin==NULL) {
-        ostringstream errOut;
-        errOut <<"EXITING because of fatal ERROR: could not open temporary bam file: " << dirBAMsort+"/b"+to_string((uint) iBin) << "\n";
-        errOut <<"SOLUTION: check that the disk is not full, increase the max number of open files with Linux command ulimit -n before running STAR";
-        exitWithError(errOut.str(), std::cerr, P.inOut->logMain, EXIT_CODE_PARAMETER, P);
-    };
+    BAMbinWrite binOut(dirBAMsort+"/b"+sortBin.name(), compressLevel, sortThreads, sortBin.index, P);
 
-    outBAMwriteHeader(bgzfBin,P.samHeaderSortedCoord,genome.chrNameAll,genome.chrLengthAll);
-    //send ordered aligns to bgzf one-by-one
+    //send ordered aligns to the compressed bin one-by-one
     char bam1[BAM_ATTR_MaxSize];//temp array
-    for (uint ia=0;ia<binN;ia++) {
+    auto alignWrite = [&](uint64 ia) {
         char* bam0=bamIn+startPos[ia*3+2];
         uint32 size0=*((uint32*) bam0)+sizeof(uint32);
-        
+
         if (solo.pSolo.samAttrYes)
             solo.soloFeat[solo.pSolo.featureInd[solo.pSolo.samAttrFeature]]->addBAMtags(bam0,size0,bam1);
-        
-        bgzf_write(bgzfBin, bam0, size0);
+
+        binOut.write(bam0, size0);
+    };
+
+    if (P.outBAMsortingPresort.yes) {//the runs were sorted by the mapping threads: k-way merge
+        vector <array<uint64,2>> runs;//current and end align of each run
+        vector <uint64> runN=sortBin.runN;//runs of the split part, or the runs of all threads in the order of loading
+        if (sortBin.iPart<0) {
+            for (uint it=0; it<nThreads; it++)
+                runN.insert(runN.end(), RAchunk[it]->chunkOutBAMcoord->binRunN[iBin].begin(), RAchunk[it]->chunkOutBAMcoord->binRunN[iBin].end());
+        };
+        uint64 runEnd=0;
+        for (auto &n1 : runN) {
+            runs.push_back({runEnd, runEnd+n1});
+            runEnd+=n1;
+        };
+        if (runEnd!=binN) {
+            ostringstream errOut;
+            errOut << "BUG: number of aligns in the sorted runs does not agree with the number in the BAM bin: " << runEnd <<" "<< binN << " ; bin number="<< sortBin.name() <<"\n";
+            exitWithError(errOut.str(),std::cerr, P.inOut->logMain, EXIT_CODE_BUG, P);
+        };
+
+        //runs are ordered by their position in the bin, which resolves the ties in the same way as the full sort
+        auto runGreater = [&](uint64 r1, uint64 r2) {
+            return funCompareArrays<uint,3>((void*) (startPos+runs[r1][0]*3), (void*) (startPos+runs[r2][0]*3)) > 0;
+        };
+        vector <uint64> heap;
+        for (uint64 ir=0; ir<runs.size(); ir++) {
+            if (runs[ir][0]<runs[ir][1])
+                heap.push_back(ir);
+        };
+        std::make_heap(heap.begin(), heap.end(), runGreater);
+        while (heap.size()>0) {
+            std::pop_heap(heap.begin(), heap.end(), runGreater);
+            uint64 ir=heap.back();
+            alignWrite(runs[ir][0]);
+            if (++runs[ir][0] < runs[ir][1]) {
+                std::push_heap(heap.begin(), heap.end(), runGreater);
+            } else {
+                heap.pop_back();
+            };
+        };
+    } else {//sort by coordinate, then read order, then position in the bin
+        radixSortUint64(startPos, binN, 3, sortThreads.binThreads());
+        for (uint ia=0;ia<binN;ia++)
+            alignWrite(ia);
     };
 
-    bgzf_flush(bgzfBin);
-    bgzf_close(bgzfBin);
+    binOut.close();
     //release memory
     delete [] bamIn;
     delete [] startPos;
@@ -4,9 +4,23 @@
 #include "Parameters.h"
 #include "Genome.h"
 #include "Solo.h"
+#include "ReadAlignChunk.h"
+#include "BAMbinWrite.h"
 
 #include SAMTOOLS_BGZF_H
 
-void BAMbinSortByCoordinate(uint32 iBin, uint binN, uint binS, uint nThreads, string dirBAMsort, Parameters &P, Genome &mapGen, Solo &solo);
+struct BAMsortBin {//bin for sorting: a genomic bin collected from the mapping threads, or a part of a genomic bin that was split before sorting
+    uint32 iBin;//genomic bin
+    int32 iPart;//-1 for the whole genomic bin
+    uint binN, binS;//number and size of aligns
+    uint binM;//size of aligns kept in memory by the mapping threads, --limitBAMsortBinsRAM
+    vector <uint64> runN;//--outBAMsortingPresort: sorted runs of the part
+    BAMindexPiece *index;//--outBAMsortingIndex: index of the aligns of the bin
+    string name() {
+        return to_string((uint) iBin) + (iPart<0 ? "" : "."+to_string(iPart));
+    };
+};
+
+void BAMbinSortByCoordinate(BAMsortBin &sortBin, uint nThreads, string dirBAMsort, Parameters &P, Solo &solo, ReadAlignChunk **RAchunk, int compressLevel, BAMsortThreads &sortThreads);
 
 #endif
\ No newline at end of file
@@ -2,19 +2,9 @@
 #include "ErrorWarning.h"
 #include "BAMfunctions.h"
 
-void BAMbinSortUnmapped(uint32 iBin, uint nThreads, string dirBAMsort, Parameters &P, Genome &genome, Solo &solo) {
-
-    BGZF *bgzfBin;
-    bgzfBin=bgzf_open((dirBAMsort+"/b"+to_string((uint) iBin)).c_str(),("w"+to_string((long long) P.outBAMcompression)).c_str());
-    if (bgzfBin==NULL) {
-        ostringstream errOut;
-        errOut <<"EXITING because of fatal ERROR: could not open temporary bam file: " << dirBAMsort+"/b"+to_string((uint) iBin) << "\n";
-        errOut <<"SOLUTION: check that the disk is not full, increase the max number of open files with Linux command ulimit -n before running STAR";
-        exitWithError(errOut.str(), std::cerr, P.inOut->logMain, EXIT_CODE_PARAMETER, P);
-    };
-
-    outBAMwriteHeader(bgzfBin,P.samHeaderSortedCoord,genome.chrNameAll,genome.chrLengthAll);
+void BAMbinSortUnmapped(uint32 iBin, uint nThreads, string dirBAMsort, Parameters &P, Solo &solo, int compressLevel, BAMsortThreads &sortThreads, BAMindexPiece *index) {
 
+    BAMbinWrite binOut(dirBAMsort+"/b"+to_string((uint) iBin), compressLevel, sortThreads, index, P);
 
     vector<string> bamInFile;
     std::map <uint,uint> startPos;
@@ -45,7 +35,7 @@ void BAMbinSortUnmapped(uint32 iBin, uint nThreads, string dirBAMsort, Parameter
         };
     };
 
-    //send ordered aligns to bgzf one-by-one
+    //send ordered aligns to the compressed bin one-by-one
     char bam1[BAM_ATTR_MaxSize];//temp array
     while (startPos.size()>0) {
         uint it=startPos.begin()->second;
@@ -59,7 +49,7 @@ void BAMbinSortUnmapped(uint32 iBin, uint nThreads, string dirBAMsort, Parameter
             if (solo.pSolo.samAttrYes)
 	        solo.soloFeat[solo.pSolo.featureInd[solo.pSolo.samAttrFeature]]->addBAMtags(bam0,size0,bam1);
 
-            bgzf_write(bgzfBin, bam0, size0);
+            binOut.write(bam0, size0);
             bamInStream[it].read(bamIn[it],sizeof(int32));//read record size
             if (bamInStream[it].good()) {
                  bamSize[it]=((*(uint32*)bamIn[it])+sizeof(int32));
@@ -77,8 +67,7 @@ void BAMbinSortUnmapped(uint32 iBin, uint nThreads, string dirBAMsort, Parameter
         startPos.erase(startPos.begin());
     };
 
-    bgzf_flush(bgzfBin);
-    bgzf_close(bgzfBin);
+    binOut.close();
 
 
     for (uint it=0; it<bamInFile.size(); it++) {//destroy at the end
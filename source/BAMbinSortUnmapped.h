@@ -4,9 +4,10 @@
 #include "Parameters.h"
 #include "Genome.h"
 #include "Solo.h"
+#include "BAMbinWrite.h"
 
 #include SAMTOOLS_BGZF_H
 
-void BAMbinSortUnmapped(uint32 iBin, uint nThreads, string dirBAMsort, Parameters &P, Genome &genome, Solo &solo);
+void BAMbinSortUnmapped(uint32 iBin, uint nThreads, string dirBAMsort, Parameters &P, Solo &solo, int compressLevel, BAMsortThreads &sortThreads, BAMindexPiece *index);
 
 #endif
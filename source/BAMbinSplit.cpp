@@ -0,0 +1,95 @@
+#include "BAMbinSplit.h"
+#include "ErrorWarning.h"
+#include "streamFuns.h"
+
+void BAMbinSplit(uint32 iBin, vector <uint64> &partStart, uint nThreads, string dirBAMsort, Parameters &P, ReadAlignChunk **RAchunk, vector <BAMsortBin> &parts) {
+    //split the genomic bin into parts starting at partStart coordinates, each part is collected from all threads into one file
+    //the order of the aligns is preserved, and each sorted run is split into sorted runs of the parts
+
+    uint32 nParts=partStart.size()+1;
+    parts.resize(nParts);
+    vector <ofstream*> partStream(nParts);
+    vector <uint64> partRunN(nParts,0);
+    for (uint32 ip=0; ip<nParts; ip++) {
+        parts[ip].iBin=iBin;
+        parts[ip].iPart=ip;
+        parts[ip].binN=0;
+        parts[ip].binS=0;
+        parts[ip].binM=0;
+        parts[ip].runN.clear();
+        parts[ip].index=NULL;
+        partStream[ip]=&ofstrOpen(dirBAMsort+"/s"+parts[ip].name(), ERROR_OUT, P);
+    };
+
+    char *bamFile=new char [BAMoutput_oneAlignMaxBytes];
+    for (uint it=0; it<nThreads; it++) {
+        BAMoutput &bamOut=*RAchunk[it]->chunkOutBAMcoord;
+
+        char *bamMem=new char [bamOut.binMemBytes[iBin]+1];
+        uint64 bamMemN=bamOut.coordBinMemLoad(iBin, bamMem);//aligns kept in memory precede the aligns in the file
+        uint64 bamMemI=0;
+
+        string bamInFile=dirBAMsort+to_string(it)+"/"+to_string((uint) iBin);
+        ifstream bamInStream(bamInFile.c_str(), std::ios::binary);
+
+        vector <uint64> &runN=bamOut.binRunN[iBin];
+        uint64 iRun=0, runLeft=(runN.size()>0 ? runN[0] : 0);
+        while (true) {
+            char *bam0;
+            if (bamMemI<bamMemN) {
+                bam0=bamMem+bamMemI;
+                bamMemI += *(uint32*)bam0+sizeof(uint32)+sizeof(uint);
+            } else {
+                bam0=bamFile;
+                bamInStream.read(bam0,sizeof(uint32));
+                if (!bamInStream.good())
+                    break;
+                bamInStream.read(bam0+sizeof(uint32),*(uint32*)bam0+sizeof(uint));
+            };
+            uint32 *bamIn32=(uint32*) bam0;
+            uint64 size0=bamIn32[0]+sizeof(uint32)+sizeof(uint);//BAM record and iRead
+
+            uint64 alignG=( ((uint) bamIn32[1]) << 32 ) | ( (uint)bamIn32[2] );
+            uint32 ip=std::upper_bound(partStart.begin(), partStart.end(), alignG)-partStart.begin();
+            partStream[ip]->write(bam0, size0);
+            parts[ip].binN++;
+            parts[ip].binS+=size0;
+
+            if (P.outBAMsortingPresort.yes) {
+                partRunN[ip]++;
+                if (--runLeft==0) {//end of the sorted run
+                    for (uint32 ip1=0; ip1<nParts; ip1++) {
+                        if (partRunN[ip1]>0)
+                            parts[ip1].runN.push_back(partRunN[ip1]);
+                        partRunN[ip1]=0;
+                    };
+                    ++iRun;
+                    runLeft = iRun<runN.size() ? runN[iRun] : 0;
+                };
+            };
+        };
+
+        if (P.outBAMsortingPresort.yes && iRun!=runN.size()) {
+            ostringstream errOut;
+            errOut << "BUG: number of aligns in the sorted runs does not agree with the number in the BAM bin: " << iRun <<" runs of "<< runN.size() << " ; bin number="<< iBin <<"\n";
+            exitWithError(errOut.str(),std::cerr, P.inOut->logMain, EXIT_CODE_BUG, P);
+        };
+
+        delete [] bamMem;
+        bamInStream.close();
+        remove(bamInFile.c_str());
+    };
+    delete [] bamFile;
+
+    for (uint32 ip=0; ip<nParts; ip++) {
+        partStream[ip]->flush();
+        if (partStream[ip]->fail()) {
+            ostringstream errOut;
+            errOut <<"EXITING because of fatal ERROR: could not write to temporary file: " << dirBAMsort+"/s"+parts[ip].name() << "\n";
+            errOut <<"SOLUTION: check that the disk is not full";
+            exitWithError(errOut.str(), std::cerr, P.inOut->logMain, EXIT_CODE_FILE_WRITE, P);
+        };
+        partStream[ip]->close();
+        delete partStream[ip];
+    };
+};
@@ -0,0 +1,10 @@
+#ifndef CODE_BAMbinSplit
+#define CODE_BAMbinSplit
+#include "IncludeDefine.h"
+#include "Parameters.h"
+#include "ReadAlignChunk.h"
+#include "BAMbinSortByCoordinate.h"
+
+void BAMbinSplit(uint32 iBin, vector <uint64> &partStart, uint nThreads, string dirBAMsort, Parameters &P, ReadAlignChunk **RAchunk, vector <BAMsortBin> &parts);
+
+#endif
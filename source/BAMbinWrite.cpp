@@ -0,0 +1,75 @@
+#include "BAMbinWrite.h"
+#include "BAMfunctions.h"
+#include "ErrorWarning.h"
+#include "streamFuns.h"
+#include SAMTOOLS_BGZF_H
+
+#define BAM_BIN_BATCH_BLOCKS 64 //number of BGZF blocks compressed in one batch
+
+BAMbinWrite::BAMbinWrite(string fileNameIn, int compressLevelIn, BAMsortThreads &sortThreadsIn, BAMindexPiece *indexIn, Parameters &Pin)
+              : fileName(fileNameIn), compressLevel(compressLevelIn), sortThreads(sortThreadsIn), index(indexIn), P(Pin)
+{
+    binStream=&ofstrOpen(fileName, ERROR_OUT, P);
+    batchSize=BGZF_BLOCK_SIZE*BAM_BIN_BATCH_BLOCKS;
+    batchArray=new char[batchSize];
+    batchN=0;
+    bytesTotal=0;
+    compSize=BGZF_MAX_BLOCK_SIZE*BAM_BIN_BATCH_BLOCKS;
+    compArray=new char[compSize];
+};
+
+BAMbinWrite::~BAMbinWrite()
+{
+    delete [] batchArray;
+    delete [] compArray;
+    delete binStream;
+};
+
+void BAMbinWrite::write(const char *bamIn, uint64 bamSize)
+{//records may be split between the batches, the same as between the BGZF blocks
+    if (index!=NULL)
+        index->push(bamIn, bytesTotal);
+    bytesTotal+=bamSize;
+    while (bamSize>0) {
+        uint64 size1=min(bamSize, batchSize-batchN);
+        memcpy(batchArray+batchN, bamIn, size1);
+        batchN+=size1;
+        bamIn+=size1;
+        bamSize-=size1;
+        if (batchN==batchSize)
+            batchWrite();
+    };
+};
+
+void BAMbinWrite::batchWrite()
+{
+    if (batchN==0)
+        return;
+
+    uint64 compN=bgzfCompressArrayParallel(batchArray, batchN, compArray, compSize, compressLevel, sortThreads.binThreads());
+    if (compN==(uint64)-1) {
+        ostringstream errOut;
+        errOut <<"EXITING because of fatal ERROR: zlib failed to compress sorted BAM bin: " << fileName <<"\n";
+        errOut <<"SOLUTION: contact Alex Dobin at dobin@cshl.edu\n";
+        exitWithError(errOut.str(), std::cerr, P.inOut->logMain, EXIT_CODE_BUG, P);
+    };
+
+    if (index!=NULL)
+        index->blocksAdd(compArray, compN);
+    binStream->write(compArray, compN);
+    if (binStream->fail()) {
+        ostringstream errOut;
+        errOut <<"EXITING because of fatal ERROR: could not write to temporary bam file: " << fileName << "\n";
+        errOut <<"SOLUTION: check that the disk is not full";
+        exitWithError(errOut.str(), std::cerr, P.inOut->logMain, EXIT_CODE_FILE_WRITE, P);
+    };
+    batchN=0;
+};
+
+void BAMbinWrite::close()
+{
+    batchWrite();
+    binStream->close();
+    if (index!=NULL)
+        index->finish(bytesTotal);
+};
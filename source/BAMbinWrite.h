@@ -0,0 +1,42 @@
+#ifndef CODE_BAMbinWrite
+#define CODE_BAMbinWrite
+
+#include "IncludeDefine.h"
+#include "Parameters.h"
+#include "BAMindex.h"
+#include <atomic>
+
+struct BAMsortThreads {//sorting threads are shared by the bins: when no bins are waiting to start, the bins that are still sorting use the idle threads
+    int nThreads;
+    std::atomic<int> binsWaiting, binsSorting;
+    int binThreads() {
+        return binsWaiting>0 ? 1 : max(1, nThreads/max(1,(int) binsSorting));
+    };
+};
+
+class BAMbinWrite {//compressed output of one sorted bin: the aligns are collected into batches of BGZF blocks, which are compressed in parallel
+                   //the bin file contains only the BGZF blocks of the aligns, without the BAM header and the EOF block
+public:
+    BAMbinWrite(string fileNameIn, int compressLevelIn, BAMsortThreads &sortThreadsIn, BAMindexPiece *indexIn, Parameters &Pin);
+    ~BAMbinWrite();
+    void write(const char *bamIn, uint64 bamSize);//one align record
+    void close();
+
+private:
+    string fileName;
+    int compressLevel;
+    BAMsortThreads &sortThreads;
+    BAMindexPiece *index;//NULL if the sorted BAM is not indexed
+    Parameters &P;
+
+    ofstream *binStream;
+    char *batchArray;
+    uint64 batchN, batchSize;
+    uint64 bytesTotal;//uncompressed size of the bin
+    char *compArray;
+    uint64 compSize;
+
+    void batchWrite();
+};
+
+#endif
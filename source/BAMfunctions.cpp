@@ -1,5 +1,6 @@
 #include "BAMfunctions.h"
 #include "htslib/htslib/kstring.h"
+#include <zlib.h>
 
 
 string bam_cigarString (bam1_t *b) {//output CIGAR string
@@ -103,6 +104,96 @@ int reg2bin(int beg, int end)
     return 0;
 };
 
+uint64 bgzfCompressArray(const char *arrIn, uint64 arrInSize, char* &arrOut, uint64 &arrOutSize, int compressLevel)
+{//compress arrIn into a series of complete BGZF blocks in arrOut, which is grown if needed. Returns the number of compressed bytes.
+ //the blocks can be appended to a BGZF file with bgzf_raw_write, after the BGZF buffer was flushed
+    const uint32 headerL=18, footerL=8;
+    const char bgzfHeader[headerL]={31, (char)139, 8, 4, 0, 0, 0, 0, 0, (char)255, 6, 0, 66, 67, 2, 0, 0, 0};
+
+    z_stream zs;
+    zs.zalloc=NULL;
+    zs.zfree=NULL;
+    zs.opaque=NULL;
+    if (deflateInit2(&zs, compressLevel, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK) //-15: raw deflate, no zlib header/footer
+        return (uint64)-1;
+
+    uint64 outN=0;
+    for (uint64 inN=0; inN<arrInSize; ) {
+        uint32 blockL=(uint32) min((uint64) BGZF_BLOCK_SIZE, arrInSize-inN);
+
+        if (outN+BGZF_MAX_BLOCK_SIZE > arrOutSize) {//grow output array
+            uint64 arrOutSize1=max(arrOutSize*2, outN+BGZF_MAX_BLOCK_SIZE);
+            char *arrOut1=new char[arrOutSize1];
+            memcpy(arrOut1, arrOut, outN);
+            delete [] arrOut;
+            arrOut=arrOut1;
+            arrOutSize=arrOutSize1;
+        };
+
+        uint8 *blockOut=(uint8*) (arrOut+outN);
+        deflateReset(&zs);
+        zs.next_in=(Bytef*) (arrIn+inN);
+        zs.avail_in=blockL;
+        zs.next_out=blockOut+headerL;
+        zs.avail_out=BGZF_MAX_BLOCK_SIZE-headerL-footerL;
+        if (deflate(&zs, Z_FINISH) != Z_STREAM_END) {
+            deflateEnd(&zs);
+            return (uint64)-1;
+        };
+
+        uint32 blockOutL=zs.total_out+headerL+footerL;
+        memcpy(blockOut, bgzfHeader, headerL);
+        *(uint16*) (blockOut+16) = (uint16) (blockOutL-1); //BSIZE = total block size - 1
+        *(uint32*) (blockOut+blockOutL-8) = (uint32) crc32(crc32(0L, NULL, 0L), (Bytef*) (arrIn+inN), blockL);
+        *(uint32*) (blockOut+blockOutL-4) = blockL;
+
+        inN+=blockL;
+        outN+=blockOutL;
+    };
+
+    deflateEnd(&zs);
+    return outN;
+};
+
+uint64 bgzfCompressArrayParallel(const char *arrIn, uint64 arrInSize, char* &arrOut, uint64 &arrOutSize, int compressLevel, int nThreads)
+{//same as bgzfCompressArray, the BGZF blocks are compressed by nThreads threads, the output is identical
+    uint64 nBlocks=(arrInSize+BGZF_BLOCK_SIZE-1)/BGZF_BLOCK_SIZE;
+    nThreads=(int) min((uint64) nThreads, nBlocks);
+    if (nThreads<=1)
+        return bgzfCompressArray(arrIn, arrInSize, arrOut, arrOutSize, compressLevel);
+
+    vector <char*> outT(nThreads);
+    vector <uint64> outTsize(nThreads), outTn(nThreads);
+    #pragma omp parallel for num_threads(nThreads)
+    for (int it=0; it<nThreads; it++) {//each thread compresses a range of whole blocks
+        uint64 in1=nBlocks*it/nThreads*BGZF_BLOCK_SIZE;
+        uint64 in2=min(arrInSize, nBlocks*(it+1)/nThreads*BGZF_BLOCK_SIZE);
+        outTsize[it]=(in2-in1+BGZF_BLOCK_SIZE-1)/BGZF_BLOCK_SIZE*BGZF_MAX_BLOCK_SIZE;
+        outT[it]=new char[outTsize[it]];
+        outTn[it]=bgzfCompressArray(arrIn+in1, in2-in1, outT[it], outTsize[it], compressLevel);
+    };
+
+    uint64 outN=0;
+    for (int it=0; it<nThreads; it++) {
+        if (outTn[it]==(uint64)-1)
+            outN=(uint64)-1;
+        if (outN!=(uint64)-1) {
+            if (outN+outTn[it] > arrOutSize) {//grow output array
+                uint64 arrOutSize1=max(arrOutSize*2, outN+outTn[it]);
+                char *arrOut1=new char[arrOutSize1];
+                memcpy(arrOut1, arrOut, outN);
+                delete [] arrOut;
+                arrOut=arrOut1;
+                arrOutSize=arrOutSize1;
+            };
+            memcpy(arrOut+outN, outT[it], outTn[it]);
+            outN+=outTn[it];
+        };
+        delete [] outT[it];
+    };
+    return outN;
+};
+
 int bamAttrArrayWrite(int32 attr, const char* tagName, char* attrArray ) {
     attrArray[0]=tagName[0];attrArray[1]=tagName[1];
     attrArray[2]='i';
@@ -12,6 +12,8 @@ int bam_read1_fromArray(char *bamChar, bam1_t *b);
 string bam_cigarString (bam1_t *b);
         
 int reg2bin(int beg, int end);
+uint64 bgzfCompressArray(const char *arrIn, uint64 arrInSize, char* &arrOut, uint64 &arrOutSize, int compressLevel);
+uint64 bgzfCompressArrayParallel(const char *arrIn, uint64 arrInSize, char* &arrOut, uint64 &arrOutSize, int compressLevel, int nThreads);
 int bamAttrArrayWrite(int32 attr, const char* tagName, char* attrArray );
 int bamAttrArrayWrite(float attr, const char* tagName, char* attrArray );
 int bamAttrArrayWrite(char attr, const char* tagName, char* attrArray );
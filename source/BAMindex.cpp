@@ -0,0 +1,266 @@
+#include "BAMindex.h"
+#include "ErrorWarning.h"
+#include SAMTOOLS_BGZF_H
+
+static uint32 indexReg2bin(int64 beg, int64 end, int minShift, int nLvls)
+{//bin of the [beg,end) region, same as hts_reg2bin; with minShift=14, nLvls=5 same as reg2bin for BAI
+    int l, s=minShift, t=((1<<((nLvls<<1)+nLvls))-1)/7;
+    for (--end, l=nLvls; l>0; --l, s+=3, t-=1<<((l<<1)+l))
+        if (beg>>s == end>>s)
+            return t+(beg>>s);
+    return 0;
+};
+
+static uint32 indexBinBot(uint32 bin, int nLvls)
+{//first window of the bin, same as hts_bin_bot
+    int l=0;
+    for (uint32 b=bin; b>0; b=(b-1)>>3)
+        ++l;
+    return (bin-((1<<(3*l))-1)/7) << ((nLvls-l)*3);
+};
+
+BAMindexPiece::BAMindexPiece(int minShiftIn, int nLvlsIn) : minShift(minShiftIn), nLvls(nLvlsIn)
+{
+    nNoCoor=0;
+    bytesTotal=0;
+    bytesComp=0;
+    lastRef=-1;
+    curRef=NULL;
+};
+
+void BAMindexPiece::push(const char *bamIn, uint64 offset)
+{//same as hts_idx_push: the chunk of a bin continues while the consecutive aligns fall into the same bin
+    uint32 *bamIn32=(uint32*) bamIn;
+    int32 ref=(int32) bamIn32[1];
+    int64 pos=(int32) bamIn32[2];
+    uint16 flag=*(uint16*) (bamIn+18);
+
+    if (ref!=lastRef) {//new reference
+        if (lastRef>=0)
+            refFinish(offset);
+        lastRef=ref;
+        if (ref>=0) {
+            curRef=&refs[ref];
+            curRef->offBeg=offset;
+            curRef->nMapped=0;
+            curRef->nUnmapped=0;
+            lastBin=(uint32) -1;
+        };
+    };
+
+    if (ref<0) {
+        ++nNoCoor;
+        return;
+    };
+
+    int64 end=pos;
+    if ( (flag & 0x4) == 0 ) {//mapped: end from CIGAR
+        uint32 *cigar=(uint32*) (bamIn+36+*(uint8*) (bamIn+12));
+        uint16 nCigar=*(uint16*) (bamIn+16);
+        for (uint32 ic=0; ic<nCigar; ic++) {
+            uint32 op=cigar[ic] & 0xf;
+            if (op==0 || op==2 || op==3 || op==7 || op==8) //M D N = X consume reference
+                end += cigar[ic]>>4;
+        };
+        ++curRef->nMapped;
+    } else {
+        ++curRef->nUnmapped;
+    };
+    if (end==pos)
+        end=pos+1;
+
+    //linear index
+    uint64 w1=pos>>minShift, w2=(end-1)>>minShift;
+    if (curRef->linear.size()<w2+1)
+        curRef->linear.resize(w2+1, (uint64) -1);
+    for (uint64 iw=w1; iw<=w2; iw++) {
+        if (curRef->linear[iw]==(uint64) -1)
+            curRef->linear[iw]=offset;
+    };
+
+    uint32 bin=indexReg2bin(pos, end, minShift, nLvls);
+    if (bin!=lastBin) {//close the chunk of the previous bin
+        if (lastBin!=(uint32) -1)
+            curRef->bins[lastBin].push_back({saveOff, offset});
+        lastBin=bin;
+        saveOff=offset;
+    };
+};
+
+void BAMindexPiece::refFinish(uint64 offset)
+{
+    curRef->bins[lastBin].push_back({saveOff, offset});
+    curRef->offEnd=offset;
+};
+
+void BAMindexPiece::blocksAdd(const char *blocks, uint64 blocksSize)
+{
+    for (uint64 ib=0; ib<blocksSize; ib += *(uint16*) (blocks+ib+16)+1) //BSIZE = total block size - 1
+        blockStart.push_back(bytesComp+ib);
+    bytesComp += blocksSize;
+};
+
+void BAMindexPiece::finish(uint64 offset)
+{
+    if (lastRef>=0)
+        refFinish(offset);
+    lastRef=-1;
+    bytesTotal=offset;
+    blockStart.push_back(bytesComp);
+};
+
+uint64 BAMindexPiece::virtualOffset(uint64 offset, uint64 binOffset)
+{//the bin file was compressed in the BGZF_BLOCK_SIZE blocks
+    if (offset>=bytesTotal) //end of the bin is the start of the next bin
+        return (binOffset+blockStart.back())<<16;
+    return ( (binOffset+blockStart[offset/BGZF_BLOCK_SIZE])<<16 ) | (offset%BGZF_BLOCK_SIZE);
+};
+
+BAMindex::BAMindex(Parameters &Pin, Genome &genomeIn) : P(Pin), genome(genomeIn)
+{
+    uint64 maxLen=0;
+    for (auto &chrL : genome.chrLengthAll)
+        maxLen=max(maxLen, chrL);
+
+    if (P.outBAMsortingIndex.in=="BAI" && maxLen >= (1LLU<<29)) {
+        ostringstream errOut;
+        errOut <<"EXITING because of fatal PARAMETERS error: --outBAMsortingIndex BAI cannot index chromosomes longer than 2^29 bases, the longest chromosome length is " << maxLen <<"\n";
+        errOut <<"SOLUTION: re-run STAR with --outBAMsortingIndex CSI or Auto\n";
+        exitWithError(errOut.str(), std::cerr, P.inOut->logMain, EXIT_CODE_PARAMETER, P);
+    };
+    csi = P.outBAMsortingIndex.in=="CSI" || (P.outBAMsortingIndex.in=="Auto" && maxLen >= (1LLU<<29));
+
+    minShift=14;
+    if (csi) {//same as samtools index -c
+        maxLen+=256;
+        nLvls=0;
+        for (uint64 s=1LLU<<minShift; maxLen>s; s<<=3)
+            ++nLvls;
+    } else {
+        nLvls=5;
+    };
+};
+
+BAMindexPiece* BAMindex::newPiece()
+{
+    return new BAMindexPiece(minShift, nLvls);
+};
+
+void BAMindex::write(vector <BAMindexPiece*> &pieces, vector <uint64> &pieceOffset, string fileName)
+{
+    //merge the pieces, with virtual offsets
+    uint32 nRef=genome.chrNameAll.size();
+    vector <BAMindexRef> refs(nRef);
+    vector <bool> refYes(nRef, false);
+    uint64 nNoCoor=0;
+    for (uint64 ip=0; ip<pieces.size(); ip++) {
+        BAMindexPiece &pc=*pieces[ip];
+        nNoCoor += pc.nNoCoor;
+        for (auto &rr : pc.refs) {
+            BAMindexRef &r1=rr.second, &r=refs[rr.first];
+            if (!refYes[rr.first]) {
+                refYes[rr.first]=true;
+                r.offBeg=pc.virtualOffset(r1.offBeg, pieceOffset[ip]);
+                r.nMapped=0;
+                r.nUnmapped=0;
+            };
+            r.offEnd=pc.virtualOffset(r1.offEnd, pieceOffset[ip]);
+            r.nMapped += r1.nMapped;
+            r.nUnmapped += r1.nUnmapped;
+            for (auto &bb : r1.bins) {
+                for (auto &ch : bb.second)
+                    r.bins[bb.first].push_back({pc.virtualOffset(ch[0], pieceOffset[ip]), pc.virtualOffset(ch[1], pieceOffset[ip])});
+            };
+            if (r.linear.size()<r1.linear.size())
+                r.linear.resize(r1.linear.size(), (uint64) -1);
+            for (uint64 iw=0; iw<r1.linear.size(); iw++) {
+                if (r.linear[iw]==(uint64) -1 && r1.linear[iw]!=(uint64) -1)
+                    r.linear[iw]=pc.virtualOffset(r1.linear[iw], pieceOffset[ip]);
+            };
+        };
+        delete pieces[ip];
+    };
+
+    for (uint32 ir=0; ir<nRef; ir++) {
+        BAMindexRef &r=refs[ir];
+        for (auto &bb : r.bins) {//merge adjacent chunks that start in the same BGZF block, same as htslib
+            vector <array<uint64,2>> &ch=bb.second;
+            uint64 m=0;
+            for (uint64 ic=1; ic<ch.size(); ic++) {
+                if ( (ch[m][1]>>16) >= (ch[ic][0]>>16) ) {
+                    ch[m][1]=max(ch[m][1], ch[ic][1]);
+                } else {
+                    ch[++m]=ch[ic];
+                };
+            };
+            ch.resize(m+1);
+        };
+        for (uint64 iw=0; iw<r.linear.size(); iw++) {//fill the empty windows
+            if (r.linear[iw]==(uint64) -1)
+                r.linear[iw] = iw==0 ? r.offBeg : r.linear[iw-1];
+        };
+    };
+
+    //write out
+    BGZF *bgzfIndex=bgzf_open(fileName.c_str(), csi ? "w" : "wu");//CSI is BGZF-compressed, BAI is not
+    if (bgzfIndex==NULL) {
+        ostringstream errOut;
+        errOut <<"EXITING because of fatal ERROR: could not open output index file: " << fileName << "\n";
+        errOut <<"SOLUTION: check that the disk is not full, increase the max number of open files with Linux command ulimit -n before running STAR";
+        exitWithError(errOut.str(), std::cerr, P.inOut->logMain, EXIT_CODE_PARAMETER, P);
+    };
+
+    auto write32 = [&](int32 x) {bgzf_write(bgzfIndex, &x, sizeof(x));};
+    auto write64 = [&](uint64 x) {bgzf_write(bgzfIndex, &x, sizeof(x));};
+
+    if (csi) {
+        bgzf_write(bgzfIndex, "CSI\1", 4);
+        write32(minShift);
+        write32(nLvls);
+        write32(0);//no aux
+    } else {
+        bgzf_write(bgzfIndex, "BAI\1", 4);
+    };
+    write32(nRef);
+
+    uint32 metaBin=((1<<(3*nLvls+3))-1)/7+1;//pseudo-bin with the reference statistics
+    for (uint32 ir=0; ir<nRef; ir++) {
+        BAMindexRef &r=refs[ir];
+        write32(r.bins.size()+(refYes[ir] ? 1 : 0));
+        for (auto &bb : r.bins) {
+            write32(bb.first);
+            if (csi) {
+                uint32 binBot=indexBinBot(bb.first, nLvls);
+                write64(binBot<r.linear.size() ? r.linear[binBot] : 0);
+            };
+            write32(bb.second.size());
+            for (auto &ch : bb.second) {
+                write64(ch[0]);
+                write64(ch[1]);
+            };
+        };
+        if (refYes[ir]) {
+            write32(metaBin);
+            if (csi)
+                write64(0);
+            write32(2);
+            write64(r.offBeg);
+            write64(r.offEnd);
+            write64(r.nMapped);
+            write64(r.nUnmapped);
+        };
+        if (!csi) {
+            write32(r.linear.size());
+            for (auto &lo : r.linear)
+                write64(lo);
+        };
+    };
+    write64(nNoCoor);
+
+    if (bgzf_close(bgzfIndex)!=0) {
+        ostringstream errOut;
+        errOut <<"EXITING because of fatal ERROR: could not write output index file: " << fileName << "\n";
+        errOut <<"SOLUTION: check that the disk is not full";
+        exitWithError(errOut.str(), std::cerr, P.inOut->logMain, EXIT_CODE_FILE_WRITE, P);
+    };
+};
@@ -0,0 +1,55 @@
+#ifndef CODE_BAMindex
+#define CODE_BAMindex
+
+#include "IncludeDefine.h"
+#include "Parameters.h"
+#include "Genome.h"
+#include <map>
+#include <array>
+
+struct BAMindexRef {//index of the aligns of one reference
+    std::map <uint32, vector <array<uint64,2>>> bins;//chunks of each bin
+    vector <uint64> linear;//offset of the first align overlapping each 2^minShift window, -1 for the windows without aligns
+    uint64 offBeg, offEnd;//offsets of the first align and after the last align
+    uint64 nMapped, nUnmapped;
+};
+
+class BAMindexPiece {//index of the aligns of one sorted bin, in the order they are written into the bin file
+                     //the offsets are uncompressed offsets inside the bin, they are converted to virtual offsets when the pieces are merged
+public:
+    std::map <int32, BAMindexRef> refs;
+    uint64 nNoCoor;//aligns without coordinates
+    vector <uint64> blockStart;//compressed offsets of the BGZF blocks in the bin file, and the size of the bin file at the end
+    uint64 bytesTotal;//uncompressed size of the bin
+
+    BAMindexPiece(int minShiftIn, int nLvlsIn);
+    void push(const char *bamIn, uint64 offset);//align record (with the size field) that starts at offset
+    void blocksAdd(const char *blocks, uint64 blocksSize);//BGZF blocks appended to the bin file
+    void finish(uint64 offset);//offset at the end of the bin
+    uint64 virtualOffset(uint64 offset, uint64 binOffset);//virtual offset in the output file where the bin file starts at binOffset
+
+private:
+    int minShift, nLvls;
+    int32 lastRef;
+    BAMindexRef *curRef;
+    uint32 lastBin;
+    uint64 saveOff;//start of the current chunk
+    uint64 bytesComp;//compressed size of the bin
+    void refFinish(uint64 offset);
+};
+
+class BAMindex {//BAI or CSI index of the coordinate-sorted BAM, merged from the pieces of the sorted bins
+public:
+    bool csi;
+    int minShift, nLvls;
+
+    BAMindex(Parameters &Pin, Genome &genomeIn);
+    BAMindexPiece* newPiece();
+    void write(vector <BAMindexPiece*> &pieces, vector <uint64> &pieceOffset, string fileName);//merge the pieces written at pieceOffset in the BAM file
+
+private:
+    Parameters &P;
+    Genome &genome;
+};
+
+#endif
@@ -5,6 +5,10 @@
 #include "serviceFuns.cpp"
 #include "ThreadControl.h"
 #include "streamFuns.h"
+#include "BAMfunctions.h"
+#include "radixSort.h"
+
+std::atomic<uint64> BAMoutput::binMemTotal(0);
 
 BAMoutput::BAMoutput (int iChunk, string tmpDir, Parameters &Pin) : P(Pin){//allocate bam array
 
@@ -21,15 +25,22 @@ BAMoutput::BAMoutput (int iChunk, string tmpDir, Parameters &Pin) : P(Pin){//all
     binStream=new ofstream* [nBins];
     binTotalN=new uint [nBins];
     binTotalBytes=new uint [nBins];
+    binMemBytes=new uint64 [nBins];
+    binMem.resize(nBins);
+    binSpill.resize(nBins,false);
+    binRunN.resize(nBins);
+    binSortArray = P.outBAMsortingPresort.yes ? new char [binSize] : NULL;
     for (uint ii=0;ii<nBins;ii++) {
         binStart[ii]=bamArray+bamArraySize/nBins*ii;
         binBytes[ii]=0;
         binStream[ii]=&ofstrOpen((bamDir +"/"+to_string(ii)).c_str(), ERROR_OUT, P);    //open temporary files
         binTotalN[ii]=0;
         binTotalBytes[ii]=0;
+        binMemBytes[ii]=0;
     };
 
     binSize1=binStart[nBins-1]-binStart[0];
+    coordSketchBytes=0;
     nBins=1;//start with one bin to estimate genomic bin sizes
 };
 
@@ -39,12 +50,16 @@ BAMoutput::BAMoutput (BGZF *bgzfBAMin, Parameters &Pin) : P(Pin){//allocate BAM
     bamArray = new char [bamArraySize];
     binBytes1=0;
     bgzfBAM=bgzfBAMin;
+    bgzfArraySize=bamArraySize/4; //will be increased if needed
+    bgzfArray=new char [bgzfArraySize];
     //not used
     binSize=0;
     binStream=NULL;
     binStart=NULL;
     binBytes=NULL;
     binTotalBytes=NULL;
+    binMemBytes=NULL;
+    binSortArray=NULL;
     binTotalN=NULL;
     nBins=0;
 };
@@ -54,12 +69,7 @@ void BAMoutput::unsortedOneAlign (char *bamIn, uint bamSize, uint bamSize2) {//r
     if (bamSize==0) return; //no output, could happen if one of the mates is not mapped
 
     if (binBytes1+bamSize2 > bamArraySize) {//write out this buffer
-
-        if (g_threadChunks.threadBool) pthread_mutex_lock(&g_threadChunks.mutexOutSAM);
-        bgzf_write(bgzfBAM,bamArray,binBytes1);
-        if (g_threadChunks.threadBool) pthread_mutex_unlock(&g_threadChunks.mutexOutSAM);
-
-        binBytes1=0;//rewind the buffer
+        unsortedWrite();
     };
 
     memcpy(bamArray+binBytes1, bamIn, bamSize);
@@ -68,9 +78,34 @@ void BAMoutput::unsortedOneAlign (char *bamIn, uint bamSize, uint bamSize2) {//r
 };
 
 void BAMoutput::unsortedFlush () {//flush all alignments
+    unsortedWrite();
+};
+
+void BAMoutput::unsortedWrite () {//compress the buffer into BGZF blocks, and append them to the BAM file
+    if (binBytes1==0)
+        return;
+
+    if (!bgzfBAM->is_compressed) {//uncompressed output, write through bgzf
+        if (g_threadChunks.threadBool) pthread_mutex_lock(&g_threadChunks.mutexOutSAM);
+        bgzf_write(bgzfBAM,bamArray,binBytes1);
+        if (g_threadChunks.threadBool) pthread_mutex_unlock(&g_threadChunks.mutexOutSAM);
+        binBytes1=0;//rewind the buffer
+        return;
+    };
+
+    //compression is done outside of the mutex. The BAM header was flushed by outBAMwriteHeader, so complete blocks can be appended
+    uint64 bgzfBytes=bgzfCompressArray(bamArray, binBytes1, bgzfArray, bgzfArraySize, bgzfBAM->compress_level);
+    if (bgzfBytes==(uint64)-1) {
+        ostringstream errOut;
+        errOut <<"EXITING because of fatal ERROR: zlib failed to compress unsorted BAM output\n";
+        errOut <<"SOLUTION: contact Alex Dobin at dobin@cshl.edu\n";
+        exitWithError(errOut.str(), std::cerr, P.inOut->logMain, EXIT_CODE_BUG, P);
+    };
+
     if (g_threadChunks.threadBool) pthread_mutex_lock(&g_threadChunks.mutexOutSAM);
-    bgzf_write(bgzfBAM,bamArray,binBytes1);
+    bgzf_raw_write(bgzfBAM,bgzfArray,bgzfBytes);
     if (g_threadChunks.threadBool) pthread_mutex_unlock(&g_threadChunks.mutexOutSAM);
+
     binBytes1=0;//rewind the buffer
 };
 
@@ -96,8 +131,7 @@ void BAMoutput::coordOneAlign (char *bamIn, uint bamSize, uint iRead) {
     //write buffer is filled
     if (binBytes[iBin]+bamSize+sizeof(uint) > ( (iBin>0 || nBins>1) ? binSize : binSize1) ) {//write out this buffer
         if ( nBins>1 || iBin==(P.outBAMcoordNbins-1) ) {//normal writing, bins have already been determined
-            binStream[iBin]->write(binStart[iBin],binBytes[iBin]);
-            binBytes[iBin]=0;//rewind the buffer
+            coordBinWrite(iBin);
         } else {//the first chunk of reads was written in one bin, need to determine bin sizes, and re-distribute reads into bins
             coordBins();
             coordOneAlign (bamIn, bamSize, iRead);//record the current align into the new bins
@@ -112,6 +146,12 @@ void BAMoutput::coordOneAlign (char *bamIn, uint bamSize, uint iRead) {
     binBytes[iBin] += sizeof(uint);
     binTotalBytes[iBin] += bamSize+sizeof(uint);
     binTotalN[iBin] += 1;
+
+    if (iBin<P.outBAMcoordNbins-1) {//sample the mapped aligns for the coordinate sketch
+        coordSketchBytes += bamSize+sizeof(uint);
+        for (; coordSketchBytes>=BAM_SORT_SKETCH_STEP; coordSketchBytes-=BAM_SORT_SKETCH_STEP)
+            coordSketch.push_back(alignG);
+    };
     return;
 };
 
@@ -128,19 +168,27 @@ void BAMoutput::coordBins() {//define genomic starts for bins
             startPos[ia]  =( ((uint) bamIn32[1]) << 32) | ( (uint)bamIn32[2] );
             ib+=bamIn32[0]+sizeof(uint32)+sizeof(uint);//note that size of the BAM record does not include the size record itself
         };
-        qsort((void*) startPos, binTotalN[0], sizeof(uint), funCompareUint1);
+        radixSortUint64(startPos, binTotalN[0], 1, 1);
 
         //determine genomic starts of the bins
-        P.inOut->logMain << "BAM sorting: "<<binTotalN[0]<< " mapped reads\n";
-        P.inOut->logMain << "BAM sorting bins genomic start loci:\n";
+        ostringstream logOut;//logMain is shared with the reader thread, it is written under mutexLogMain below
+        logOut << "BAM sorting: "<<binTotalN[0]<< " mapped reads\n";
+        logOut << "BAM sorting bins genomic start loci:\n";
 
         P.outBAMsortingBinStart[0]=0;
         for (uint32 ib=1; ib<(nBins-1); ib++) {
             P.outBAMsortingBinStart[ib]=startPos[binTotalN[0]/(nBins-1)*ib];
-            P.inOut->logMain << ib <<"\t"<< (P.outBAMsortingBinStart[ib]>>32) << "\t" << ((P.outBAMsortingBinStart[ib]<<32)>>32) <<endl;
-            //how to deal with equal boundaries???
+            if (P.outBAMsortingBinStart[ib]<=P.outBAMsortingBinStart[ib-1]) {//equal boundaries: start the bin at the next coordinate, the bins that are too large are split before sorting
+                uint *s1=std::upper_bound(startPos, startPos+binTotalN[0], P.outBAMsortingBinStart[ib-1]);
+                P.outBAMsortingBinStart[ib] = s1<startPos+binTotalN[0] ? *s1 : P.outBAMsortingBinStart[ib-1]+1;
+            };
+            logOut << ib <<"\t"<< (P.outBAMsortingBinStart[ib]>>32) << "\t" << ((P.outBAMsortingBinStart[ib]<<32)>>32) <<"\n";
         };
         delete [] startPos;
+
+        pthread_mutex_lock(&g_threadChunks.mutexLogMain);
+        P.inOut->logMain << logOut.str() << flush;
+        pthread_mutex_unlock(&g_threadChunks.mutexLogMain);
     };
     //mutex here
     if (P.runThreadN>1) pthread_mutex_unlock(&g_threadChunks.mutexBAMsortBins);
@@ -153,6 +201,8 @@ void BAMoutput::coordBins() {//define genomic starts for bins
     binBytes[0]=0;
     binTotalN[0]=0;
     binTotalBytes[0]=0;
+    coordSketch.clear();//the aligns are sampled again when re-binned
+    coordSketchBytes=0;
 
     //re-bin all aligns
     for (uint ib=0,ia=0;ia<binTotalNold;ia++) {
@@ -170,12 +220,76 @@ void BAMoutput::coordFlush () {//flush all alignments
         coordBins();
     };
     for (uint32 iBin=0; iBin<nBins; iBin++) {
-        binStream[iBin]->write(binStart[iBin],binBytes[iBin]);
+        coordBinWrite(iBin);
         binStream[iBin]->flush();
-        binBytes[iBin]=0;//rewind the buffer
     };
 };
 
+void BAMoutput::coordBinWrite(uint32 iBin) {//move the bin buffer into the in-memory bin if it fits into --limitBAMsortBinsRAM, otherwise write it to the temporary file
+    if (binBytes[iBin]==0)
+        return;
+
+    char *binOut=binStart[iBin];
+    if (P.outBAMsortingPresort.yes && iBin<P.outBAMcoordNbins-1)
+        binOut=coordBinPresort(iBin);
+
+    if (P.limitBAMsortBinsRAM>0 && iBin<P.outBAMcoordNbins-1 && !binSpill[iBin]) {//the last bin (unmapped reads) is always written to the file
+        if (binMemTotal.fetch_add(binBytes[iBin]) + binBytes[iBin] <= P.limitBAMsortBinsRAM) {
+            char *block=new char [binBytes[iBin]];
+            memcpy(block, binOut, binBytes[iBin]);
+            binMem[iBin].push_back({block, binBytes[iBin]});
+            binMemBytes[iBin] += binBytes[iBin];
+            binBytes[iBin]=0;//rewind the buffer
+            return;
+        };
+        binMemTotal -= binBytes[iBin];
+        binSpill[iBin]=true;//the order of the aligns is preserved: the file follows the in-memory blocks
+    };
+
+    binStream[iBin]->write(binOut,binBytes[iBin]);
+    binBytes[iBin]=0;//rewind the buffer
+};
+
+char* BAMoutput::coordBinPresort(uint32 iBin) {//sort the aligns by coordinate and read order, same as in BAMbinSortByCoordinate; the buffer order resolves ties
+    uint64 nAligns=0;
+    for (uint64 ib=0; ib<binBytes[iBin]; nAligns++) {
+        uint32 *bamIn32=(uint32*) (binStart[iBin]+ib);
+        if (binSortKeys.size()<nAligns*3+3)
+            binSortKeys.resize(binSortKeys.size()*2+3);
+        binSortKeys[nAligns*3]=( ((uint) bamIn32[1]) << 32) | ( (uint)bamIn32[2] );
+        binSortKeys[nAligns*3+2]=ib;
+        ib+=bamIn32[0]+sizeof(uint32);//note that size of the BAM record does not include the size record itself
+        binSortKeys[nAligns*3+1]=*( (uint*) (binStart[iBin]+ib) ); //read order
+        ib+=sizeof(uint);
+    };
+
+    radixSortUint64(binSortKeys.data(), nAligns, 3, 1);
+
+    uint64 nBytes=0;
+    for (uint64 ia=0; ia<nAligns; ia++) {
+        char *bam0=binStart[iBin]+binSortKeys[ia*3+2];
+        uint64 size0=*((uint32*) bam0)+sizeof(uint32)+sizeof(uint);//BAM record and iRead
+        memcpy(binSortArray+nBytes, bam0, size0);
+        nBytes+=size0;
+    };
+
+    binRunN[iBin].push_back(nAligns);
+    return binSortArray;
+};
+
+uint64 BAMoutput::coordBinMemLoad(uint32 iBin, char *bamOut) {
+    uint64 nBytes=0;
+    for (auto &block : binMem[iBin]) {
+        memcpy(bamOut+nBytes, block.first, block.second);
+        nBytes += block.second;
+        delete [] block.first;
+    };
+    binMem[iBin].clear();
+    binMemTotal -= binMemBytes[iBin];
+    binMemBytes[iBin]=0;
+    return nBytes;
+};
+
 void BAMoutput::coordUnmappedPrepareBySJout () {//flush all alignments
     uint iBin=P.outBAMcoordNbins-1;
     binStream[iBin]->write(binStart[iBin],binBytes[iBin]);
@@ -4,6 +4,9 @@
 #include "IncludeDefine.h"
 #include SAMTOOLS_BGZF_H
 #include "Parameters.h"
+#include <atomic>
+
+#define BAM_SORT_SKETCH_STEP 65536 //bytes of aligns per one coordinate in the sketch
 
 class BAMoutput {//
 public:
@@ -16,11 +19,17 @@ public:
     BAMoutput (BGZF *bgzfBAMin, Parameters &Pin);
     void unsortedOneAlign (char *bamIn, uint bamSize, uint bamSize2);
     void unsortedFlush ();
+    void unsortedWrite ();
     void coordUnmappedPrepareBySJout();
+    uint64 coordBinMemLoad(uint32 iBin, char *bamOut);//copy the in-memory part of the bin into bamOut and release it, returns number of bytes
 
     uint32 nBins; //number of bins to split genome into
     uint* binTotalN; //total number of aligns in each bin
     uint* binTotalBytes;//total size of aligns in each bin
+    uint64* binMemBytes;//size of aligns kept in memory for each bin, --limitBAMsortBinsRAM
+    static std::atomic<uint64> binMemTotal;//memory used by the in-memory bins of all threads
+    vector <vector <uint64>> binRunN;//--outBAMsortingPresort: number of aligns in each sorted run of each bin, in the order they were written
+    vector <uint64> coordSketch;//coordinates of the mapped aligns sampled every BAM_SORT_SKETCH_STEP bytes, used to split the bins before sorting
 private:
     uint64 bamArraySize; //this size will be allocated
     char* bamArray; //large array to store the bam alignments, pre-sorted
@@ -29,7 +38,16 @@ private:
     char **binStart; //pointers to starts of the bins
     uint64 *binBytes, binBytes1;//number of bytes currently written to each bin
     ofstream **binStream;//output streams for each bin
+    vector <vector <pair<char*,uint64>>> binMem;//blocks of aligns kept in memory for each bin, in the order they were written
+    vector <bool> binSpill;//bin did not fit into memory, all further aligns of this bin are written to the temporary file
+    void coordBinWrite(uint32 iBin);
+    char* coordBinPresort(uint32 iBin);//sort the aligns of the bin buffer into binSortArray
+    char *binSortArray;
+    vector <uint64> binSortKeys;
+    uint64 coordSketchBytes;//bytes of aligns since the last coordinate recorded in the sketch
     BGZF *bgzfBAM;
+    char *bgzfArray; //compressed BGZF blocks for unsorted output, compressed by each thread outside of the output mutex
+    uint64 bgzfArraySize;
     Parameters &P;
     string bamDir;
 };
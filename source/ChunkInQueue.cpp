@@ -0,0 +1,89 @@
+#include "ChunkInQueue.h"
+#include <sched.h>
+#include <unistd.h>
+
+ChunkInQueue::ChunkInQueue(uint64 capacityIn)
+{
+    uint64 capacity=2;
+    while (capacity<capacityIn)
+        capacity*=2;
+    mask=capacity-1;
+
+    cells=new Cell[capacity];
+    for (uint64 ii=0; ii<capacity; ii++) {
+        cells[ii].seq.store(ii, std::memory_order_relaxed);
+        cells[ii].chunk=NULL;
+    };
+    pushPos.store(0, std::memory_order_relaxed);
+    popPos.store(0, std::memory_order_relaxed);
+};
+
+ChunkInQueue::~ChunkInQueue()
+{
+    delete [] cells;
+};
+
+bool ChunkInQueue::push(ChunkIn *chunk)
+{
+    uint64 pos=pushPos.load(std::memory_order_relaxed);
+    Cell *cell;
+    while (true) {
+        cell=&cells[pos & mask];
+        int64 dif=(int64) cell->seq.load(std::memory_order_acquire) - (int64) pos;
+        if (dif==0) {//cell is free, try to claim it
+            if (pushPos.compare_exchange_weak(pos, pos+1, std::memory_order_relaxed))
+                break;
+        } else if (dif<0) {//queue is full
+            return false;
+        } else {//another producer claimed this cell
+            pos=pushPos.load(std::memory_order_relaxed);
+        };
+    };
+    cell->chunk=chunk;
+    cell->seq.store(pos+1, std::memory_order_release);
+    return true;
+};
+
+bool ChunkInQueue::pop(ChunkIn* &chunk)
+{
+    uint64 pos=popPos.load(std::memory_order_relaxed);
+    Cell *cell;
+    while (true) {
+        cell=&cells[pos & mask];
+        int64 dif=(int64) cell->seq.load(std::memory_order_acquire) - (int64) (pos+1);
+        if (dif==0) {//cell is filled, try to claim it
+            if (popPos.compare_exchange_weak(pos, pos+1, std::memory_order_relaxed))
+                break;
+        } else if (dif<0) {//queue is empty
+            return false;
+        } else {//another consumer claimed this cell
+            pos=popPos.load(std::memory_order_relaxed);
+        };
+    };
+    chunk=cell->chunk;
+    cell->seq.store(pos+mask+1, std::memory_order_release);
+    return true;
+};
+
+void ChunkInQueue::pushWait(ChunkIn *chunk)
+{
+    for (uint32 iWait=0; !push(chunk); iWait++)
+        waitBackoff(iWait);
+};
+
+ChunkIn* ChunkInQueue::popWait()
+{
+    ChunkIn *chunk;
+    for (uint32 iWait=0; !pop(chunk); iWait++)
+        waitBackoff(iWait);
+    return chunk;
+};
+
+void ChunkInQueue::waitBackoff(uint32 iWait)
+{//yield first, then sleep: waiting for input files or for mapping can be long
+    if (iWait<64) {
+        sched_yield();
+    } else {
+        usleep(100);
+    };
+};
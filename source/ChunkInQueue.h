@@ -0,0 +1,48 @@
+#ifndef CODE_ChunkInQueue
+#define CODE_ChunkInQueue
+
+#include "IncludeDefine.h"
+#include <array>
+#include <atomic>
+
+struct ChunkInRead {//one read (one mate) in the chunk: positions of the read lines in the chunk array, and read metadata
+    uint64 nameStart, seqStart, qualStart, extraStart; //the name includes the leading @ or >
+    uint32 nameLen, seqLen, qualLen, extraLen;
+    uint64 iReadAll;
+    uint32 readFilesIndex;
+    char readFilter; //Illumina pass filter: Y or N
+    char fileType; //1: fasta, 2: fastq
+};
+
+struct ChunkIn {//one chunk of input reads, for all mates
+    char *data[MAX_N_MATES];
+    array<uint64, MAX_N_MATES> sizeBytes;
+    vector <ChunkInRead> reads[MAX_N_MATES]; //index of the reads in data
+    uint64 iChunk; //chunk number in the order of the input reads
+};
+
+class ChunkInQueue {//bounded lock-free multi-producer/multi-consumer queue of chunk pointers
+public:
+    ChunkInQueue(uint64 capacityIn);
+    ~ChunkInQueue();
+    bool push(ChunkIn *chunk); //returns false if the queue is full
+    bool pop(ChunkIn* &chunk); //returns false if the queue is empty
+    void pushWait(ChunkIn *chunk); //wait until there is space in the queue
+    ChunkIn* popWait(); //wait until a chunk is available
+
+private:
+    struct Cell {
+        std::atomic<uint64> seq; //sequence number: tells producers and consumers whether the cell is free or filled
+        ChunkIn *chunk;
+    };
+    Cell *cells;
+    uint64 mask; //capacity-1, capacity is a power of 2
+
+    std::atomic<uint64> pushPos;
+    char padPos[64]; //producer and consumer positions are kept on different cache lines
+    std::atomic<uint64> popPos;
+
+    static void waitBackoff(uint32 iWait);
+};
+
+#endif
@@ -0,0 +1,73 @@
+#include "ChunkInReader.h"
+#include "GlobalVariables.h"
+
+#define CHUNK_IN_READ_AHEAD 2 //number of chunks that can be read ahead of the mapping threads
+
+ChunkInReader::ChunkInReader(Parameters &Pin) : P(Pin)
+{
+    //each mapping thread owns one chunk at a time, the extra chunks are filled while the mapping threads are busy
+    queueFull = new ChunkInQueue(P.runThreadN+CHUNK_IN_READ_AHEAD);
+    queueFree = new ChunkInQueue(P.runThreadN+CHUNK_IN_READ_AHEAD);
+
+    for (uint32 ic=0; ic<CHUNK_IN_READ_AHEAD; ic++) {
+        ChunkIn *chunk = new ChunkIn;
+        for (uint imate=0; imate<P.readNends; imate++) {
+            chunk->data[imate]=new char[P.chunkInSizeBytesArray];
+            memset(chunk->data[imate],'\n',P.chunkInSizeBytesArray);
+        };
+        chunk->sizeBytes={0,0};
+        chunkAll.push_back(chunk);
+        queueFree->pushWait(chunk);
+    };
+};
+
+ChunkInReader::~ChunkInReader()
+{//only the chunk structures are owned by the reader, the data arrays are swapped with mapping threads: delete the arrays that are still in the free queue
+    ChunkIn *chunk;
+    while (queueFree->pop(chunk)) {
+        for (uint imate=0; imate<P.readNends; imate++)
+            delete [] chunk->data[imate];
+    };
+    for (auto &chunk1 : chunkAll)
+        delete chunk1;
+    delete queueFull;
+    delete queueFree;
+};
+
+void ChunkInReader::readChunks()
+{
+    while (true) {
+        ChunkIn *chunk = queueFree->popWait();
+        readChunk(*chunk);
+        chunk->iChunk=g_threadChunks.chunkInN;
+        g_threadChunks.chunkInN++;
+        queueFull->pushWait(chunk);
+        if (chunk->sizeBytes[0]==0)
+            break;
+    };
+
+    //all mapping threads have to receive an empty chunk to finish
+    for (int ithread=1; ithread<P.runThreadN; ithread++) {
+        ChunkIn *chunk = queueFree->popWait();
+        chunk->sizeBytes={0,0};
+        for (uint imate=0; imate<P.readNends; imate++) {
+            chunk->data[imate][0]='\n';
+            chunk->reads[imate].clear();
+        };
+        chunk->iChunk=g_threadChunks.chunkInN;
+        g_threadChunks.chunkInN++;
+        queueFull->pushWait(chunk);
+    };
+};
+
+void ChunkInReader::exchangeChunk(char **chunkIn, vector<ChunkInRead> *chunkInReads, array<uint64, MAX_N_MATES> &chunkInSizeBytesTotal, uint &iChunkIn)
+{
+    ChunkIn *chunk = queueFull->popWait();
+    for (uint imate=0; imate<P.readNends; imate++) {
+        swap(chunkIn[imate], chunk->data[imate]);
+        chunkInReads[imate].swap(chunk->reads[imate]);
+    };
+    chunkInSizeBytesTotal=chunk->sizeBytes;
+    iChunkIn=chunk->iChunk;
+    queueFree->pushWait(chunk); //now contains the arrays of the already mapped chunk
+};
@@ -0,0 +1,30 @@
+#ifndef CODE_ChunkInReader
+#define CODE_ChunkInReader
+
+#include "IncludeDefine.h"
+#include "Parameters.h"
+#include "ChunkInQueue.h"
+
+class ChunkInReader {//reads the input files into chunks in a dedicated thread, passes them to the mapping threads via lock-free queues
+public:
+    ChunkInReader(Parameters &Pin);
+    ~ChunkInReader();
+
+    void readChunks(); //fill chunks until the end of input, then send one empty chunk to each mapping thread
+    void exchangeChunk(char **chunkIn, vector<ChunkInRead> *chunkInReads, array<uint64, MAX_N_MATES> &chunkInSizeBytesTotal, uint &iChunkIn); //mapping thread: give away the mapped chunk, get the next chunk
+
+    static void* threadReadChunks(void *reader) {
+        ( (ChunkInReader*) reader )->readChunks();
+        pthread_exit(0);
+        return NULL;
+    };
+
+private:
+    Parameters &P;
+    ChunkInQueue *queueFull, *queueFree; //chunks filled with reads, and chunks that can be re-filled
+    vector <ChunkIn*> chunkAll;
+
+    void readChunk(ChunkIn &chunk); //load one chunk from the input files
+};
+
+#endif
@@ -0,0 +1,272 @@
+#include "ChunkInReader.h"
+#include "GlobalVariables.h"
+#include "ErrorWarning.h"
+#include "SequenceFuns.h"
+
+inline uint64 fastqReadOneLine(ifstream &streamIn, char *arrIn);
+inline void removeStringEndControl(string &str);
+
+void ChunkInReader::readChunk(ChunkIn &chunk)
+{//read one chunk of reads from the input files
+    bool newFile=false; //new file marker in the input stream
+
+    chunk.sizeBytes={0,0};
+    for (uint imate=0; imate<P.readNends; imate++)
+        chunk.reads[imate].clear();
+    
+    while (chunk.sizeBytes[0] < P.chunkInSizeBytes && chunk.sizeBytes[1] < P.chunkInSizeBytes && P.inOut->readIn[0].good() && P.inOut->readIn[1].good()) {
+        char nextChar=P.inOut->readIn[0].peek();
+        if (P.iReadAll==P.readMapNumber) {//do not read any more reads
+            break;
+            
+        ///////////////////////////////////////////////////////////////////////////////////// SAM                        
+        } else if (P.readFilesTypeN==10 && P.inOut->readIn[0].good() && P.outFilterBySJoutStage!=2) {//SAM input && not eof && not 2nd stage
+
+
+            if (nextChar=='@') {//with SAM input linest that start with @ are headers
+                P.inOut->readIn[0].ignore(DEF_readNameSeqLengthMax,'\n'); //read line and skip it
+                continue;
+            };
+
+            string str1;
+            P.inOut->readIn[0] >> str1;
+            if (str1=="FILE") {
+                newFile=true;
+            } else {
+                P.iReadAll++; //increment read number
+
+                uint64 flag1; 
+                P.inOut->readIn[0] >> flag1;
+                uint imate1=0;
+                for (uint imate=0;imate<P.readNmates;imate++) {//not readNends: this is SAM input
+                    if (imate>0) {
+                        string str2;
+                        uint64 flag2;
+                        P.inOut->readIn[0] >> str2; //for imate=0 str1 was already read
+                        P.inOut->readIn[0] >> flag2; //read name and flag
+                        
+                        if ( str1 != str2 ) {
+                            ostringstream errOut;
+                            errOut << ERROR_OUT <<" EXITING because of FATAL ERROR in input BAM file: the consecutive lines in paired-end BAM have different read IDs:\n"
+                                   << str1 <<"   vs   "<< str2 << '\n'
+                                   << "\n SOLUTION: fix BAM file formatting. Paired-end reads should be always consecutive lines, with exactly 2 lines per paired-end read" ;
+                            exitWithError(errOut.str(),std::cerr, P.inOut->logMain, EXIT_CODE_INPUT_FILES, P);
+                        };
+                        
+                        if (! ( ((flag1 & 0x40) && (flag2 & 0x80)) || ((flag2 & 0x40) && (flag1 & 0x80)) ) ) {
+                            ostringstream errOut;
+                            errOut << ERROR_OUT <<" EXITING because of FATAL ERROR in input BAM file: the consecutive lines in paired-end BAM have wrong mate FLAG bits:\n"
+                                   << str1 <<"   "<< flag1 <<"   vs   "<< str2 <<"   "<< flag2 << '\n'
+                                   << "\n SOLUTION: fix BAM file formatting. Paired-end reads should be always consecutive lines, with exactly 2 lines per paired-end read."
+                                   << " Mate1 should have 0x40 bit set in the FLAG, Mate2 should have 0x80 bit set in the FLAG";
+                            exitWithError(errOut.str(),std::cerr, P.inOut->logMain, EXIT_CODE_INPUT_FILES, P);
+                        };
+                        
+                        str1 = str2;   //used below for both mates
+                        flag1 = flag2; //used below for both mates
+                    };
+                    char passFilterIllumina=(flag1 & 0x800 ? 'Y' : 'N');
+
+                    if (imate==1) {//2nd line is always opposite of the 1st one
+                        imate1=1-imate1;
+                    } else if (P.readNmates==2 && (flag1 & 0x80)) {//not readNends: this is SAM input
+                        imate1=1;
+                    } else {
+                        imate1=0;
+                    };
+
+                    ChunkInRead read1 = {};
+                    read1.iReadAll=P.iReadAll;
+                    read1.readFilter=passFilterIllumina;
+                    read1.readFilesIndex=P.readFilesIndex;
+                    read1.fileType=2;
+
+                    //read ID or number
+                    read1.nameStart=chunk.sizeBytes[imate1];
+                    if (P.outSAMreadID=="Number") {
+                        chunk.sizeBytes[imate1] += sprintf(chunk.data[imate1] + chunk.sizeBytes[imate1], "@%llu", P.iReadAll);
+                    } else {
+                        chunk.sizeBytes[imate1] += sprintf(chunk.data[imate1] + chunk.sizeBytes[imate1], "@%s", str1.c_str());
+                    };
+                    read1.nameLen=chunk.sizeBytes[imate1]-read1.nameStart;
+
+                    string dummy;
+                    for (int ii=3; ii<=9; ii++)
+                        P.inOut->readIn[0] >> dummy; //skip fields until sequence
+
+                    string seq1,qual1;
+                    P.inOut->readIn[0]  >> seq1 >> qual1;
+                    if (flag1 & 0x10) {//sequence reverse-coomplemented
+                        revComplementNucleotides(seq1);
+                        reverse(qual1.begin(),qual1.end());
+                    };
+                    
+                    string attrs;
+                    getline(P.inOut->readIn[0], attrs); //rest of the SAM line: str1 is now all SAM attributes - it's added to the read ID line (1st "fastq" line)
+                    uint64 attrs1=attrs.find_first_not_of(" \t\n\v\f\r"); //leading whitespace is not recorded
+                    read1.extraStart=chunk.sizeBytes[imate1] + (attrs1==string::npos ? attrs.size() : attrs1);
+                    read1.extraLen=(uint32) (attrs1==string::npos ? 0 : attrs.size()-attrs1);
+                    read1.seqStart=chunk.sizeBytes[imate1] + attrs.size() + 1;
+                    read1.seqLen=(uint32) seq1.size();
+                    read1.qualStart=read1.seqStart + seq1.size() + 3;
+                    read1.qualLen=(uint32) qual1.size();
+                    chunk.sizeBytes[imate1] += sprintf(chunk.data[imate1] + chunk.sizeBytes[imate1], "%s\n%s\n+\n%s\n", attrs.c_str(), seq1.c_str(), qual1.c_str());
+                    chunk.reads[imate1].push_back(read1);
+                };
+            };
+            
+        ///////////////////////////////////////////////////////////////////////////////////// FASTQ    
+        } else if (nextChar=='@') {//fastq, not multi-line
+            P.iReadAll++; //increment read number
+            //read ID from the 1st read
+            string readID;
+            P.inOut->readIn[0] >> readID;
+            removeStringEndControl(readID);
+            if (P.outSAMreadIDnumber) {
+                readID="@"+to_string(P.iReadAll);
+            };
+            //read the second field of the read name line
+            char passFilterIllumina='N';
+            if (P.inOut->readIn[0].peek()!='\n') {//2nd field exists
+                string field2;
+                P.inOut->readIn[0] >> field2;
+                if (field2.length()>=3 && field2[1]==':' && field2[2]=='Y' && field2[3]==':' )
+                    passFilterIllumina='Y';
+            };
+            
+            //ignore the rest of the read name for both mates
+            for (uint imate=0; imate<P.readNends; imate++)
+                P.inOut->readIn[imate].ignore(DEF_readNameSeqLengthMax,'\n');
+
+            //copy the same readID to both mates, the read number and filter are recorded in the read index
+            for (uint imate=0; imate<P.readNends; imate++) {
+                ChunkInRead read1 = {};
+                read1.iReadAll=P.iReadAll;
+                read1.readFilter=passFilterIllumina;
+                read1.readFilesIndex=P.readFilesIndex;
+                read1.fileType=2;
+                read1.nameStart=chunk.sizeBytes[imate];
+                read1.nameLen=(uint32) readID.size();
+                chunk.reads[imate].push_back(read1);
+
+                chunk.sizeBytes[imate] += 1 + readID.copy(chunk.data[imate] + chunk.sizeBytes[imate], readID.size(),0);
+                chunk.data[imate][chunk.sizeBytes[imate]-1]='\n';
+            };
+            //copy 3 lines: sequence, dummy, quality
+            for (uint imate=0; imate<P.readNends; imate++) {
+                ChunkInRead &read1 = chunk.reads[imate].back();
+                //sequence
+                read1.seqStart=chunk.sizeBytes[imate];
+                chunk.sizeBytes[imate] += fastqReadOneLine(P.inOut->readIn[imate], chunk.data[imate] + chunk.sizeBytes[imate]);
+                read1.seqLen=(uint32) (chunk.sizeBytes[imate]-read1.seqStart-1);
+                //skip 3rd line, record '+'
+                P.inOut->readIn[imate].ignore(DEF_readNameSeqLengthMax, '\n');
+                chunk.data[imate][chunk.sizeBytes[imate]] = '+';
+                chunk.data[imate][chunk.sizeBytes[imate]+1] = '\n';
+                chunk.sizeBytes[imate] += 2;
+                //quality
+                read1.qualStart=chunk.sizeBytes[imate];
+                uint64 lenIn = fastqReadOneLine(P.inOut->readIn[imate], chunk.data[imate] + chunk.sizeBytes[imate]);
+                chunk.sizeBytes[imate] += lenIn;
+                read1.qualLen=(uint32) (lenIn-1);
+            };
+        } else if (nextChar=='>') {//fasta, can be multiline, which is converted to single line
+            P.iReadAll++; //increment read number
+            for (uint imate=0; imate<P.readNends; imate++) {
+                ChunkInRead read1 = {};
+                read1.iReadAll=P.iReadAll;
+                read1.readFilter='N';
+                read1.readFilesIndex=P.readFilesIndex;
+                read1.fileType=1;
+                read1.nameStart=chunk.sizeBytes[imate];
+                if (P.outSAMreadID=="Number") {
+                    chunk.sizeBytes[imate] += sprintf(chunk.data[imate] + chunk.sizeBytes[imate], ">%llu", P.iReadAll);
+                } else {
+                    P.inOut->readIn[imate] >> (chunk.data[imate] + chunk.sizeBytes[imate]);
+                    chunk.sizeBytes[imate] += strlen(chunk.data[imate] + chunk.sizeBytes[imate]);
+                };
+                read1.nameLen=(uint32) (chunk.sizeBytes[imate]-read1.nameStart);
+
+                P.inOut->readIn[imate].ignore(DEF_readNameSeqLengthMax,'\n');
+
+                chunk.data[imate][chunk.sizeBytes[imate]]='\n';
+                chunk.sizeBytes[imate]++;
+                
+                //read multi-line fasta
+                read1.seqStart=chunk.sizeBytes[imate];
+                nextChar=P.inOut->readIn[imate].peek();
+                while (nextChar!='@' && nextChar!='>' && nextChar!=' ' && nextChar!='\n' && P.inOut->readIn[imate].good()) {
+                    P.inOut->readIn[imate].getline(chunk.data[imate] + chunk.sizeBytes[imate], DEF_readSeqLengthMax + 1 );
+                    if (P.inOut->readIn[imate].gcount()<2) 
+                        break; //no more input
+                        
+                    chunk.sizeBytes[imate] += P.inOut->readIn[imate].gcount()-1; //-1 because \n was counted, bu wee need to remove it
+                    if ( int(chunk.data[imate][chunk.sizeBytes[imate]-1]) < 33 ) {//remove control char at the end if present
+                        chunk.sizeBytes[imate]--;
+                    };
+                    
+                    nextChar=P.inOut->readIn[imate].peek();
+                };
+                read1.seqLen=(uint32) (chunk.sizeBytes[imate]-read1.seqStart);
+                chunk.reads[imate].push_back(read1);
+                chunk.data[imate][chunk.sizeBytes[imate]]='\n';
+                chunk.sizeBytes[imate] ++;
+            };
+        } else if (nextChar==' ' || nextChar=='\n' || !P.inOut->readIn[0].good()) {//end of stream
+            pthread_mutex_lock(&g_threadChunks.mutexLogMain);
+            P.inOut->logMain << "Input reader: end of input stream, nextChar="<<int(nextChar) <<endl;
+            pthread_mutex_unlock(&g_threadChunks.mutexLogMain);
+            break;
+        } else {
+            string word1;
+            P.inOut->readIn[0] >> word1;
+            if (word1=="FILE") {//new file marker
+                newFile=true;
+            } else {//error
+                ostringstream errOut;
+                string str1;
+                std::getline(P.inOut->readIn[0], str1);
+                errOut << ERROR_OUT <<" EXITING because of FATAL ERROR in input reads: wrong read ID line format: the read ID lines should start with @ or > \n";
+                errOut << "Offending line for read # " << P.iReadAll+1 << "\n" << word1 <<" "<< str1 << "\n";
+                errOut << "SOLUTION: verify and correct the input read files\n";
+                exitWithError(errOut.str(),std::cerr, P.inOut->logMain, EXIT_CODE_INPUT_FILES, P);
+            };
+        };
+
+        if (newFile) {
+                P.inOut->readIn[0] >> P.readFilesIndex;
+                pthread_mutex_lock(&g_threadChunks.mutexLogMain);
+                P.inOut->logMain << "Starting to map file # " << P.readFilesIndex<<"\n";
+                for (uint imate=0; imate<P.readFilesNames.size(); imate++) {
+                    P.inOut->logMain << "mate " <<imate+1 <<":   "<<P.readFilesNames.at(imate).at(P.readFilesIndex) <<"\n";
+                    P.inOut->readIn[imate].ignore(numeric_limits<streamsize>::max(),'\n');
+                };
+                P.inOut->logMain<<flush;
+                pthread_mutex_unlock(&g_threadChunks.mutexLogMain);
+                newFile=false;
+        };
+    };
+    //TODO: check here that both mates are zero or non-zero
+    for (uint imate=0; imate<P.readNends; imate++) 
+        chunk.data[imate][chunk.sizeBytes[imate]]='\n';//extra empty line at the end of the chunks
+};
+
+inline uint64 fastqReadOneLine(ifstream &streamIn, char *arrIn)
+{
+    uint64 lenIn;
+    streamIn.getline(arrIn, DEF_readNameSeqLengthMax+1 );
+    lenIn = streamIn.gcount(); //=seqLength+1: includes \0 but not \n. We will replace \0 with \n
+    
+    if ( int(arrIn[lenIn-2]) < 33 ) {//remove control char at the end if present
+        --lenIn;
+    };
+    
+    arrIn[lenIn-1]='\n'; //replace \0 with \n
+    return lenIn; //lenIn contains \n at the end
+};
+
+inline void removeStringEndControl(string &str)
+{//removes control character (including space) from the end of the string
+    if (int(str.back())<33)
+        str.pop_back();
+};
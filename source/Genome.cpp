@@ -14,6 +14,7 @@
 
 Genome::Genome (Parameters &P, ParametersGenome &pGe): shmStart(NULL), P(P), pGe(pGe), sharedMemory(NULL)
 {
+    numa.init=false;
     struct stat stbuf;
     stat(pGe.gDir.c_str(), &stbuf);
     shmKey=stbuf.st_ino;
@@ -32,6 +33,15 @@ Genome::Genome (Parameters &P, ParametersGenome &pGe): shmStart(NULL), P(P), pGe
 
 void Genome::freeMemory(){//free big chunks of memory used by genome and suffix array
 
+    for (auto &g1 : numa.nodeGenome) {//NUMA replicas
+        if (g1==NULL)
+            continue;
+        for (auto &mr : g1->mmapRegions)
+            munmap((void*) mr[0], mr[1]);
+        delete g1;
+    };
+    numa.nodeGenome.clear();
+
     if (pGe.gLoad=="NoSharedMemory") {//can deallocate only for non-shared memory
         delete[] G1;
         G1=NULL;
@@ -42,6 +52,13 @@ void Genome::freeMemory(){//free big chunks of memory used by genome and suffix
         P.inOut->logMain << "RAM after freeing genome index memory:\n"
                          <<  linuxProcMemory() << flush;
 
+    } else if (pGe.gLoad=="Mmap") {//unmap the files, the pages stay in the page cache for other jobs
+        for (auto &mr : mmapRegions)
+            munmap((void*) mr[0], mr[1]);
+        mmapRegions.clear();
+        G1=NULL;
+        SA.pointArray(NULL);
+        SAi.pointArray(NULL);
     };
 };
 
@@ -78,6 +95,79 @@ uint Genome::OpenStream(string name, ifstream & stream, uint size)
     return size;
 };
 
+char* Genome::mmapFile(string name, uint64 sizeMin, uint64 lengthMap, uint64 padBefore, bool padWrite)
+{//map genome file read-only and shared with other processes through the page cache
+ //the file is preceded by padBefore bytes and followed by zeros up to lengthMap bytes, these bytes are private and writable
+ //if padWrite, the last (partial) page of the file is also made writable (copy-on-write), to allow filling the padding after the file end
+    string fileName=pGe.gDir+ "/" +name;
+    int fd=open(fileName.c_str(), O_RDONLY);
+    struct stat fileStat;
+    if (fd<0 || fstat(fd, &fileStat)!=0) {
+        ostringstream errOut;
+        errOut << "EXITING because of FATAL ERROR: could not open genome file: "<< fileName <<"\n";
+        errOut << "SOLUTION: check that the path to genome files, specified in --genomeDir is correct and the files are present, and have user read permissions\n" <<flush;
+        exitWithError(errOut.str(),std::cerr, P.inOut->logMain, EXIT_CODE_GENOME_FILES, P);
+    };
+
+    uint64 fileSize=(uint64) fileStat.st_size;
+    if (fileSize==0 || fileSize<sizeMin) {
+        ostringstream errOut;
+        errOut << "EXITING because of FATAL ERROR: genome file "<< fileName <<" is too small: " << fileSize << " bytes, expected at least " << sizeMin << " bytes\n";
+        errOut << "SOLUTION: re-generate the genome index\n";
+        exitWithError(errOut.str(),std::cerr, P.inOut->logMain, EXIT_CODE_GENOME_FILES, P);
+    };
+
+    uint64 pageSize=(uint64) sysconf(_SC_PAGESIZE);
+    padBefore = ((padBefore+pageSize-1)/pageSize)*pageSize;
+    lengthMap = ((max(lengthMap,fileSize)+pageSize-1)/pageSize)*pageSize;
+
+    //reserve the whole region with anonymous memory, then map the file over it
+    int mapFlags = MAP_PRIVATE | MAP_FIXED;
+    #ifdef MAP_POPULATE
+    if (pGe.gHugePages!="Transparent")//with huge pages, the pages are pre-faulted after madvise below
+        mapFlags |= MAP_POPULATE; //pre-fault the pages: reads the file into page cache, or simply maps the pages if they are already cached
+    #endif
+
+    bool numaPolicy=numaInterleaveYes();
+    if (numaPolicy)//page cache pages are allocated according to the policy of the thread that reads them
+        linuxNumaThreadInterleave(numa.nodes);
+
+    void *regionMap = mmap(NULL, padBefore+lengthMap, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    char *regionStart = (char*) regionMap;
+    char *fileStart = regionStart+padBefore;
+
+    if (regionMap==MAP_FAILED || mmap(fileStart, fileSize, PROT_READ, mapFlags, fd, 0)==MAP_FAILED) {
+        ostringstream errOut;
+        errOut << "EXITING because of FATAL ERROR: could not mmap genome file: "<< fileName << " : " << strerror(errno) <<"\n";
+        errOut << "SOLUTION: check that virtual memory is not limited with ulimit -v, OR run STAR with --genomeLoad NoSharedMemory\n" <<flush;
+        exitWithError(errOut.str(),std::cerr, P.inOut->logMain, EXIT_CODE_MEMORY_ALLOCATION, P);
+    };
+    close(fd);
+
+    hugePagesAdvise(regionStart, padBefore+lengthMap);
+    madvise(fileStart, fileSize, MADV_WILLNEED);
+    #if defined(MADV_POPULATE_READ) && defined(MAP_POPULATE)
+    if (pGe.gHugePages=="Transparent")
+        madvise(fileStart, fileSize, MADV_POPULATE_READ);
+    #endif
+
+    if (numaPolicy) {
+        numaInterleave(regionStart, padBefore);
+        numaInterleave(fileStart+fileSize, lengthMap-fileSize);
+        linuxNumaThreadInterleave(vector<int>());
+    };
+
+    uint64 fileSizeFullPages=(fileSize/pageSize)*pageSize;
+    if (padWrite && fileSizeFullPages<fileSize)
+        mprotect(fileStart+fileSizeFullPages, pageSize, PROT_READ | PROT_WRITE);
+
+    mmapRegions.push_back({(uint64) regionStart, padBefore+lengthMap});
+
+    P.inOut->logMain << "Mapped genome file " << fileName << " : " << fileSize << " bytes\n" << flush;
+
+    return fileStart;
+};
+
 
 
 void Genome::HandleSharedMemoryException(const SharedMemoryException & exc, uint64 shmSize)
@@ -232,3 +322,20 @@ void Genome::genomeSequenceAllocate(uint64 nGenomeIn, uint64 &nG1allocOut, char*
 
     memset(G1out,GENOME_spacingChar,nG1allocOut);//initialize to K-1 all bytes
 };
+
+void Genome::hugePagesAdvise(char *memStart, uint64 memLength)
+{//request transparent huge pages for a genome array, has to be called before the memory is filled
+    if (pGe.gHugePages!="Transparent" || memStart==NULL)
+        return;
+
+    #ifdef MADV_HUGEPAGE
+    //madvise needs page-aligned range: use the pages that are fully inside the array
+    uint64 pageSize=(uint64) sysconf(_SC_PAGESIZE);
+    uint64 a1=(((uint64) memStart+pageSize-1)/pageSize)*pageSize;
+    uint64 a2=(((uint64) memStart+memLength)/pageSize)*pageSize;
+    if (a2>a1 && madvise((void*) a1, a2-a1, MADV_HUGEPAGE)!=0)
+        P.inOut->logMain << "WARNING: madvise(MADV_HUGEPAGE) failed: " << strerror(errno) << "; check /sys/kernel/mm/transparent_hugepage/enabled\n" << flush;
+    #else
+    P.inOut->logMain << "WARNING: transparent huge pages are not supported on this system, --genomeHugePages Transparent is ignored\n" << flush;
+    #endif
+};
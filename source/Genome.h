@@ -15,6 +15,12 @@ private:
     key_t shmKey;
     char *shmStart;
     uint OpenStream(string name, ifstream & stream, uint size);
+    vector <array<uint64,2>> mmapRegions; //start and length of the memory-mapped genome files, for --genomeLoad Mmap
+    char* mmapFile(string name, uint64 sizeMin, uint64 lengthMap, uint64 padBefore, bool padWrite);
+    void hugePagesAdvise(char *memStart, uint64 memLength);
+    void numaInterleave(char *memStart, uint64 memLength);
+    bool numaInterleaveYes();
+    string numaPagesNodes(const char *memStart, uint64 memLength);
     void HandleSharedMemoryException(const SharedMemoryException & exc, uint64 shmSize);
 public:
     Parameters &P;
@@ -62,6 +68,17 @@ public:
     //SuperTranscriptome genome
     SuperTranscriptome *superTr;
 
+    //NUMA placement of the genome arrays, --genomeNUMA
+    struct {
+        bool init; //true if the nodes were read from the system
+        vector <int> nodes; //NUMA nodes
+        vector <vector<int>> nodeCPUs; //CPUs of each node allowed for this process
+        vector <Genome*> nodeGenome; //genome replica on each node, NULL: this genome is used on the node
+    } numa;
+    void numaReplicate();
+    Genome& numaChunkGenome(int iChunk);
+    vector<int> numaChunkCPUs(int iChunk);
+
     Genome (Parameters &P, ParametersGenome &pGe);
     //~Genome();
 
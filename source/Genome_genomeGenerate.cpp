@@ -16,76 +16,27 @@
 #include "sjdbInsertJunctions.h"
 #include "genomeScanFastaFiles.h"
 #include "genomeSAindex.h"
+#include "suffixArraySort.h"
 
 #include "serviceFuns.cpp"
 #include "streamFuns.h"
 #include "SequenceFuns.h"
 
 
-char* globalG;
-uint globalL;
-
-
-inline int funCompareSuffixes ( const void *a, const void *b){
-
-    uint *ga=(uint*)((globalG-7LLU)+(*((uint*)a)));
-    uint *gb=(uint*)((globalG-7LLU)+(*((uint*)b)));
-
-    uint jj=0;
-    int  ii=0;
-    uint va=0,vb=0;
-    uint8 *va1, *vb1;
-
-    while (jj < globalL) {
-        va=*(ga-jj);
-        vb=*(gb-jj);
-
-        #define has5(v) ((((v)^0x0505050505050505) - 0x0101010101010101) & ~((v)^0x0505050505050505) & 0x8080808080808080)
-
-        if (has5(va) && has5(vb))
-        {//there is 5 in the sequence - only compare bytes before 5
-            va1=(uint8*) &va;
-            vb1=(uint8*) &vb;
-            for (ii=7;ii>=0;ii--)
-            {
-                if (va1[ii]>vb1[ii])
-                {
-                    return 1;
-                } else if (va1[ii]<vb1[ii])
-                {
-                    return -1;
-                } else if (va1[ii]==5)
-                {//va=vb at the end of chr
-                    if ( *((uint*)a) > *((uint*)b) )
-                    {//anti-stable order,since indexes are sorted in the reverse order
-                        return  -1;
-                    } else
-                    {//a cannot be equal to b
-                        return 1;
-                    };
-                };
-            };
-        } else
-        {//no 5, simple comparison
-            if (va>vb)
-            {
-                return 1;
-            } else if (va<vb)
-            {
-                return -1;
-            };
-        };
-        jj++;
-    };
+#define SA_PREFIX_NT 5 //suffixes are bucketed by the prefix of this length
+#define SA_CHUNK_BLOCK_SIZE 10000000 //max number of indexes read from the chunk files at once
+#define SA_CHUNK_BLOCK_MIN 1024
 
-    //suffixes are equal up to globalL, no simply compare the indexes
-    if ( *((uint*)a) > *((uint*)b) )
-    {//anti-stable order,since indexes are sorted in the reverse order
-        return  -1;
-    } else
-    {//a cannot be equal to b
-        return 1;
+static inline uint saPrefix(const char *G, uint ii)
+{//prefix of the suffix ii of the reversed genome, 3 bits per base, the bases after the spacer are zeroed so that the suffixes equal up to the spacer share the prefix
+    uint p=0;
+    bool spacer=false;
+    for (int ib=0; ib<SA_PREFIX_NT; ib++) {
+        uint b1 = spacer ? 0 : (uint) G[ii-ib];
+        spacer = spacer || b1==GENOME_spacingChar;
+        p=(p<<3) | b1;
     };
+    return p;
 };
 
 inline uint funG2strLocus (uint SAstr, uint const N, char const GstrandBit, uint const GstrandMask) {
@@ -215,120 +166,265 @@ void Genome::genomeGenerate() {
         for (uint ii=0;ii<nGenome;ii++) {//re-fill the array backwards for sorting
             swap(G[2*nGenome-1-ii],G[ii]);
         };
-        globalG=G;
-        globalL=pGe.gSuffixLengthMax/sizeof(uint);
-        //count the number of indices with 4nt prefix
-        uint indPrefN=1LLU << 16;
+        uint suffixL=pGe.gSuffixLengthMax/sizeof(uint); //max number of 8-byte words to compare
+        //count the number of indices with each prefix
+        uint indPrefN=1LLU << (3*SA_PREFIX_NT);
         uint* indPrefCount = new uint [indPrefN];
         memset(indPrefCount,0,indPrefN*sizeof(indPrefCount[0]));
         nSA=0;
         for (uint ii=0;ii<2*nGenome;ii+=pGe.gSAsparseD) {
             if (G[ii]<4) {
-                uint p1=(G[ii]<<12) + (G[ii-1]<<8) + (G[ii-2]<<4) + G[ii-3];
-                indPrefCount[p1]++;
+                indPrefCount[saPrefix(G,ii)]++;
                 nSA++;
             };
         };
 
-        uint saChunkSize=(P.limitGenomeGenerateRAM-nG1alloc)/8/P.runThreadN; //number of SA indexes per chunk
-        saChunkSize=saChunkSize*6/10; //allow extra space for qsort
-        //uint saChunkN=((nSA/saChunkSize+1)/P.runThreadN+1)*P.runThreadN;//ensure saChunkN is divisible by P.runThreadN
-        //saChunkSize=nSA/saChunkN+100000;//final chunk size
-        if (P.runThreadN>1) saChunkSize=min(saChunkSize,nSA/(P.runThreadN-1));
-        uint saChunkN = nSA / saChunkSize + 1;//estimate
-        uint* indPrefStart = new uint [saChunkN*2]; //start and stop, *2 just in case
-        uint* indPrefChunkCount = new uint [saChunkN*2];
-        indPrefStart[0]=0;
-        saChunkN=0;//start counting chunks
-        uint chunkSize1=indPrefCount[0];
-        for (uint ii=1; ii<indPrefN; ii++) {
-            chunkSize1 += indPrefCount[ii];
-            if (chunkSize1 > saChunkSize) {
-                saChunkN++;
-                indPrefStart[saChunkN]=ii;
-                indPrefChunkCount[saChunkN-1]=chunkSize1-indPrefCount[ii];
-                chunkSize1=indPrefCount[ii];
+        uint N2bit= 1LLU << GstrandBit;
+        uint packedInd=0;
+        uint nThreads=P.runThreadN;
+        uint partLength=(2*nGenome/nThreads/pGe.gSAsparseD+1)*pGe.gSAsparseD; //each thread scans its part of the genome
+
+        if (nG1alloc + nSA*sizeof(uint) + SApass1.lengthByte <= P.limitGenomeGenerateRAM) {//sort the whole SA in memory
+            P.inOut->logMain  << "Sorting Suffix Array in memory: " << nSA*sizeof(uint) <<" bytes\n" <<flush;
+
+            //bucket the indices by the prefix
+            vector <uint> threadPrefStart(indPrefN*nThreads,0);
+            #pragma omp parallel for num_threads(nThreads)
+            for (uint it=0; it<nThreads; it++) {
+                uint *prefStart1=threadPrefStart.data()+it*indPrefN;
+                for (uint ii=it*partLength; ii<min((it+1)*partLength,2*nGenome); ii+=pGe.gSAsparseD) {
+                    if (G[ii]<4)
+                        prefStart1[saPrefix(G,ii)]++;
+                };
             };
-        };
-        saChunkN++;
-        indPrefStart[saChunkN]=indPrefN+1;
-        indPrefChunkCount[saChunkN-1]=chunkSize1;
-
-        P.inOut->logMain  << "Number of chunks: " << saChunkN <<";   chunks size limit: " << saChunkSize*8 <<" bytes\n" <<flush;
-
-        time ( &rawTime );
-        P.inOut->logMain     << timeMonthDayTime(rawTime) <<" ... sorting Suffix Array chunks and saving them to disk...\n" <<flush;
-        *P.inOut->logStdOut  << timeMonthDayTime(rawTime) <<" ... sorting Suffix Array chunks and saving them to disk...\n" <<flush;
-
-        #pragma omp parallel for num_threads(P.runThreadN) ordered schedule(dynamic,1)
-        for (int iChunk=0; iChunk < (int) saChunkN; iChunk++) {//start the chunk cycle: sort each chunk with qsort and write to a file
-            uint* saChunk=new uint [indPrefChunkCount[iChunk]];//allocate local array for each chunk
-            for (uint ii=0,jj=0;ii<2*nGenome;ii+=pGe.gSAsparseD) {//fill the chunk with SA indices
-                if (G[ii]<4) {
-                    uint p1=(G[ii]<<12) + (G[ii-1]<<8) + (G[ii-2]<<4) + G[ii-3];
-                    if (p1>=indPrefStart[iChunk] && p1<indPrefStart[iChunk+1]) {
-                        saChunk[jj]=ii;
-                        jj++;
+            uint* indPrefStartAll = new uint [indPrefN+1];
+            indPrefStartAll[0]=0;
+            for (uint ip=0; ip<indPrefN; ip++) {
+                uint start1=indPrefStartAll[ip];
+                for (uint it=0; it<nThreads; it++) {//counts to starts
+                    uint count1=threadPrefStart[it*indPrefN+ip];
+                    threadPrefStart[it*indPrefN+ip]=start1;
+                    start1+=count1;
+                };
+                indPrefStartAll[ip+1]=start1;
+            };
+
+            uint* saAll=new uint [nSA];
+            #pragma omp parallel for num_threads(nThreads)
+            for (uint it=0; it<nThreads; it++) {
+                uint *prefStart1=threadPrefStart.data()+it*indPrefN;
+                for (uint ii=it*partLength; ii<min((it+1)*partLength,2*nGenome); ii+=pGe.gSAsparseD) {
+                    if (G[ii]<4)
+                        saAll[prefStart1[saPrefix(G,ii)]++]=ii;
+                };
+            };
+            vector<uint>().swap(threadPrefStart);
+
+            time ( &rawTime );
+            P.inOut->logMain     << timeMonthDayTime(rawTime) <<" ... sorting Suffix Array buckets in memory...\n" <<flush;
+            *P.inOut->logStdOut  << timeMonthDayTime(rawTime) <<" ... sorting Suffix Array buckets in memory...\n" <<flush;
+
+            #pragma omp parallel num_threads(nThreads)
+            #pragma omp single
+            for (uint ip=0; ip<indPrefN; ip++) {//large buckets are split into more tasks by suffixArraySort
+                if (indPrefStartAll[ip+1]-indPrefStartAll[ip]>1) {
+                    #pragma omp task
+                    suffixArraySort(saAll+indPrefStartAll[ip], indPrefStartAll[ip+1]-indPrefStartAll[ip], G, suffixL);
+                };
+            };
+
+            time ( &rawTime );
+            P.inOut->logMain     << timeMonthDayTime(rawTime) <<" ... packing SA...\n" <<flush;
+            *P.inOut->logStdOut  << timeMonthDayTime(rawTime) <<" ... packing SA...\n" <<flush;
+
+            SApass1.allocateArray();
+            SA.pointArray(SApass1.charArray + SApass1.lengthByte-SA.lengthByte); //SA is shifted to have space for junction insertion
+
+            //writePacked modifies 8 bytes: the last indices of each block overlap the next block and are packed after the parallel cycle
+            #define SA_PACK_BLOCK_SIZE 1048576
+            #define SA_PACK_BLOCK_OVERLAP 8
+            auto packOne = [&](uint ii) {
+                uint ind1=2*nGenome-1-saAll[ii];
+                SA.writePacked( ii, (ind1<nGenome) ? ind1 : ( (ind1-nGenome) | N2bit ) );
+            };
+            uint packBlockN=(nSA+SA_PACK_BLOCK_SIZE-1)/SA_PACK_BLOCK_SIZE;
+            #pragma omp parallel for num_threads(nThreads) schedule(dynamic,1)
+            for (uint ib=0; ib<packBlockN; ib++) {
+                uint ii2=min((ib+1)*SA_PACK_BLOCK_SIZE, nSA);
+                if (ib+1<packBlockN)
+                    ii2-=SA_PACK_BLOCK_OVERLAP;
+                for (uint ii=ib*SA_PACK_BLOCK_SIZE; ii<ii2; ii++)
+                    packOne(ii);
+            };
+            for (uint ib=1; ib<packBlockN; ib++) {
+                for (uint ii=ib*SA_PACK_BLOCK_SIZE-SA_PACK_BLOCK_OVERLAP; ii<ib*SA_PACK_BLOCK_SIZE; ii++)
+                    packOne(ii);
+            };
+            packedInd=nSA;
+
+            delete [] saAll;
+            delete [] indPrefStartAll;
+
+        } else {//sort SA chunks and save them to the temporary directory
+            //RAM: the genome and the chunks sorted at the same time, then the genome, the packed SA and the block of indexes read from the chunk files
+            uint saBlockSize=0;
+            if (nG1alloc + SApass1.lengthByte < P.limitGenomeGenerateRAM)
+                saBlockSize=min((uint) SA_CHUNK_BLOCK_SIZE, (P.limitGenomeGenerateRAM - nG1alloc - SApass1.lengthByte)/sizeof(uint));
+            uint sortRAM=0;
+            if (nG1alloc + indPrefN*sizeof(uint) < P.limitGenomeGenerateRAM)
+                sortRAM=(P.limitGenomeGenerateRAM - nG1alloc - indPrefN*sizeof(uint))/nThreads; //per thread
+            //each thread needs 8 bytes per index of its chunk and up to 16 bytes per index for radix sorting
+            uint saChunkSize = sortRAM >= 24*SA_SORT_RADIX_MAX ? (sortRAM - 16*SA_SORT_RADIX_MAX)/sizeof(uint) : sortRAM/24; //number of SA indexes per chunk
+            if (saBlockSize < SA_CHUNK_BLOCK_MIN || saChunkSize < SA_CHUNK_BLOCK_MIN) {
+                ostringstream errOut;
+                errOut << "EXITING because of FATAL PARAMETER ERROR: limitGenomeGenerateRAM="<< P.limitGenomeGenerateRAM <<" is too small to hold the genome and the packed suffix array\n";
+                errOut << "SOLUTION: please specify --limitGenomeGenerateRAM not less than "
+                       << max(nG1alloc + SApass1.lengthByte + SA_CHUNK_BLOCK_MIN*sizeof(uint), nG1alloc + indPrefN*sizeof(uint) + nThreads*24*SA_CHUNK_BLOCK_MIN)
+                       <<" and make that much RAM available, or increase --genomeSAsparseD\n";
+                exitWithError(errOut.str(),std::cerr, P.inOut->logMain, EXIT_CODE_PARAMETER, P);
+            };
+            if (nThreads>1) saChunkSize=min(saChunkSize,nSA/(nThreads-1));
+
+            //chunks are ranges of prefixes
+            vector <uint32> indPrefChunk(indPrefN);
+            vector <uint> indPrefChunkCount(1,0);
+            uint chunkSizeMax=0;
+            for (uint ip=0; ip<indPrefN; ip++) {
+                if (indPrefChunkCount.back()>0 && indPrefChunkCount.back()+indPrefCount[ip] > saChunkSize)
+                    indPrefChunkCount.push_back(0);
+                indPrefChunk[ip]=indPrefChunkCount.size()-1;
+                indPrefChunkCount.back() += indPrefCount[ip];
+                chunkSizeMax=max(chunkSizeMax,indPrefChunkCount.back());
+            };
+            uint saChunkN=indPrefChunkCount.size();
+
+            P.inOut->logMain  << "Number of chunks: " << saChunkN <<";   chunks size limit: " << saChunkSize*sizeof(uint) <<" bytes\n" <<flush;
+
+            //rounds of up to nThreads chunks are sorted at the same time: the chunks and the radix sort memory of the sorting threads fit into the sorting RAM
+            //a chunk of one prefix that is larger than the chunk size limit is sorted with fewer other chunks in its round, or alone with fewer threads
+            auto roundRAM = [](uint chunkSum, uint chunkMax, uint nThreadsSort) {return chunkSum*sizeof(uint) + nThreadsSort*16*min((uint) SA_SORT_RADIX_MAX, chunkMax);};
+            if (roundRAM(chunkSizeMax,chunkSizeMax,1) > nThreads*sortRAM) {
+                ostringstream errOut;
+                errOut << "EXITING because of FATAL PARAMETER ERROR: limitGenomeGenerateRAM="<< P.limitGenomeGenerateRAM <<" is too small to sort the largest suffix array chunk of one prefix, "
+                       << chunkSizeMax*sizeof(uint) << " bytes\n";
+                errOut << "SOLUTION: please specify --limitGenomeGenerateRAM not less than " << nG1alloc + indPrefN*sizeof(uint) + roundRAM(chunkSizeMax,chunkSizeMax,1)
+                       <<" and make that much RAM available, or increase --genomeSAsparseD\n";
+                exitWithError(errOut.str(),std::cerr, P.inOut->logMain, EXIT_CODE_PARAMETER, P);
+            };
+            vector <uint> roundStart(1,0), roundThreads;
+            for (uint ic=0, chunkSum=0, chunkMax=0; ic<=saChunkN; ic++) {
+                if (ic==saChunkN || (ic>roundStart.back() && (ic-roundStart.back()>=nThreads
+                                     || roundRAM(chunkSum+indPrefChunkCount[ic],max(chunkMax,indPrefChunkCount[ic]),nThreads) > nThreads*sortRAM))) {//close the round
+                    uint nThreadsSort=nThreads;
+                    if (roundRAM(chunkSum,chunkMax,nThreads) > nThreads*sortRAM) {//one large chunk
+                        nThreadsSort=(nThreads*sortRAM-chunkSum*sizeof(uint))/(16*min((uint) SA_SORT_RADIX_MAX, chunkMax));
+                        P.inOut->logMain  << "Chunk " << ic-1 << " of " << chunkSum*sizeof(uint) <<" bytes is sorted alone by " << nThreadsSort << " threads\n" <<flush;
                     };
-                    //TODO: if (jj==indPrefChunkCount[iChunk]) break;
+                    roundThreads.push_back(nThreadsSort);
+                    roundStart.push_back(ic);
+                    chunkSum=0;
+                    chunkMax=0;
+                };
+                if (ic<saChunkN) {
+                    chunkSum+=indPrefChunkCount[ic];
+                    chunkMax=max(chunkMax,indPrefChunkCount[ic]);
                 };
             };
 
+            time ( &rawTime );
+            P.inOut->logMain     << timeMonthDayTime(rawTime) <<" ... sorting Suffix Array chunks and saving them to disk...\n" <<flush;
+            *P.inOut->logStdOut  << timeMonthDayTime(rawTime) <<" ... sorting Suffix Array chunks and saving them to disk...\n" <<flush;
+
+            //number of indices of each chunk in each part of the genome
+            vector <uint> threadChunkStart(saChunkN*nThreads,0);
+            #pragma omp parallel for num_threads(nThreads)
+            for (uint it=0; it<nThreads; it++) {
+                uint *chunkStart1=threadChunkStart.data()+it*saChunkN;
+                for (uint ii=it*partLength; ii<min((it+1)*partLength,2*nGenome); ii+=pGe.gSAsparseD) {
+                    if (G[ii]<4)
+                        chunkStart1[indPrefChunk[saPrefix(G,ii)]]++;
+                };
+            };
+            for (uint ic=0; ic<saChunkN; ic++) {//counts to starts
+                uint start1=0;
+                for (uint it=0; it<nThreads; it++) {
+                    uint count1=threadChunkStart[it*saChunkN+ic];
+                    threadChunkStart[it*saChunkN+ic]=start1;
+                    start1+=count1;
+                };
+            };
+
+            //each round fills its chunks in one scan of the genome, and sorts them in parallel
+            for (uint iRound=0; iRound<roundThreads.size(); iRound++) {
+                uint iChunk1=roundStart[iRound], iChunk2=roundStart[iRound+1];
+                vector <uint*> saChunk(iChunk2-iChunk1);
+                for (uint ic=iChunk1; ic<iChunk2; ic++)
+                    saChunk[ic-iChunk1]=new uint [indPrefChunkCount[ic]];
+
+                #pragma omp parallel for num_threads(nThreads)
+                for (uint it=0; it<nThreads; it++) {
+                    uint *chunkStart1=threadChunkStart.data()+it*saChunkN;
+                    for (uint ii=it*partLength; ii<min((it+1)*partLength,2*nGenome); ii+=pGe.gSAsparseD) {
+                        if (G[ii]<4) {
+                            uint ic=indPrefChunk[saPrefix(G,ii)];
+                            if (ic>=iChunk1 && ic<iChunk2)
+                                saChunk[ic-iChunk1][chunkStart1[ic]++]=ii;
+                        };
+                    };
+                };
 
-            //sort the chunk
-            qsort(saChunk,indPrefChunkCount[iChunk],sizeof(saChunk[0]),funCompareSuffixes);
-            for (uint ii=0;ii<indPrefChunkCount[iChunk];ii++) {
-                saChunk[ii]=2*nGenome-1-saChunk[ii];
+                #pragma omp parallel for num_threads(roundThreads[iRound]) schedule(dynamic,1)
+                for (uint ic=iChunk1; ic<iChunk2; ic++) {
+                    uint *sa1=saChunk[ic-iChunk1];
+                    suffixArraySort(sa1,indPrefChunkCount[ic],G,suffixL);
+                    for (uint ii=0;ii<indPrefChunkCount[ic];ii++) {
+                        sa1[ii]=2*nGenome-1-sa1[ii];
+                    };
+                    string chunkFileName=P.outFileTmp+"/SA_"+to_string(ic);
+                    ofstream & saChunkFile = ofstrOpen(chunkFileName,ERROR_OUT, P);
+                    fstreamWriteBig(saChunkFile, (char*) sa1, sizeof(sa1[0])*indPrefChunkCount[ic],chunkFileName,ERROR_OUT,P);
+                    saChunkFile.close();
+                    delete [] sa1;
+                };
             };
-            //write files
-            string chunkFileName=pGe.gDir+"/SA_"+to_string( (uint) iChunk);
-            ofstream & saChunkFile = ofstrOpen(chunkFileName,ERROR_OUT, P);
-            fstreamWriteBig(saChunkFile, (char*) saChunk, sizeof(saChunk[0])*indPrefChunkCount[iChunk],chunkFileName,ERROR_OUT,P);
-            saChunkFile.close();
-            delete [] saChunk;
-            saChunk=NULL;
-        };
 
-        time ( &rawTime );
-        P.inOut->logMain     << timeMonthDayTime(rawTime) <<" ... loading chunks from disk, packing SA...\n" <<flush;
-        *P.inOut->logStdOut  << timeMonthDayTime(rawTime) <<" ... loading chunks from disk, packing SA...\n" <<flush;
+            time ( &rawTime );
+            P.inOut->logMain     << timeMonthDayTime(rawTime) <<" ... loading chunks from disk, packing SA...\n" <<flush;
+            *P.inOut->logStdOut  << timeMonthDayTime(rawTime) <<" ... loading chunks from disk, packing SA...\n" <<flush;
 
-        //read chunks and pack into full SA
-        SApass1.allocateArray();
-        SA.pointArray(SApass1.charArray + SApass1.lengthByte-SA.lengthByte); //SA is shifted to have space for junction insertion
-        uint N2bit= 1LLU << GstrandBit;
-        uint packedInd=0;
+            //read chunks and pack into full SA
+            SApass1.allocateArray();
+            SA.pointArray(SApass1.charArray + SApass1.lengthByte-SA.lengthByte); //SA is shifted to have space for junction insertion
+
+            uint* saIn=new uint[saBlockSize];
 
-        #define SA_CHUNK_BLOCK_SIZE 10000000
-        uint* saIn=new uint[SA_CHUNK_BLOCK_SIZE]; //TODO make adjustable
-
-        #ifdef genenomeGenerate_SA_textOutput
-                ofstream SAtxtStream ((pGe.gDir + "/SAtxt").c_str());
-        #endif
-
-        for (uint iChunk=0;iChunk<saChunkN;iChunk++) {//load files one by one and convert to packed
-            ostringstream saChunkFileNameStream("");
-            saChunkFileNameStream<< pGe.gDir << "/SA_" << iChunk;
-            ifstream saChunkFile(saChunkFileNameStream.str().c_str());
-            while (! saChunkFile.eof()) {//read blocks from each file
-                uint chunkBytesN=fstreamReadBig(saChunkFile,(char*) saIn,SA_CHUNK_BLOCK_SIZE*sizeof(saIn[0]));
-                for (uint ii=0;ii<chunkBytesN/sizeof(saIn[0]);ii++) {
-                    SA.writePacked( packedInd+ii, (saIn[ii]<nGenome) ? saIn[ii] : ( (saIn[ii]-nGenome) | N2bit ) );
-
-                    #ifdef genenomeGenerate_SA_textOutput
-                        SAtxtStream << saIn[ii] << "\n";
-                    #endif
+            #ifdef genenomeGenerate_SA_textOutput
+                    ofstream SAtxtStream ((pGe.gDir + "/SAtxt").c_str());
+            #endif
+
+            for (uint iChunk=0;iChunk<saChunkN;iChunk++) {//load files one by one and convert to packed
+                string chunkFileName=P.outFileTmp+"/SA_"+to_string(iChunk);
+                ifstream saChunkFile(chunkFileName.c_str());
+                while (! saChunkFile.eof()) {//read blocks from each file
+                    uint chunkBytesN=fstreamReadBig(saChunkFile,(char*) saIn,saBlockSize*sizeof(saIn[0]));
+                    for (uint ii=0;ii<chunkBytesN/sizeof(saIn[0]);ii++) {
+                        SA.writePacked( packedInd+ii, (saIn[ii]<nGenome) ? saIn[ii] : ( (saIn[ii]-nGenome) | N2bit ) );
+
+                        #ifdef genenomeGenerate_SA_textOutput
+                            SAtxtStream << saIn[ii] << "\n";
+                        #endif
+                    };
+                    packedInd += chunkBytesN/sizeof(saIn[0]);
                 };
-                packedInd += chunkBytesN/sizeof(saIn[0]);
+                saChunkFile.close();
+                remove(chunkFileName.c_str());//remove the chunk file
             };
-            saChunkFile.close();
-            remove(saChunkFileNameStream.str().c_str());//remove the chunk file
-        };
 
-        #ifdef genenomeGenerate_SA_textOutput
-                SAtxtStream.close();
-        #endif
-        delete [] saIn;
+            #ifdef genenomeGenerate_SA_textOutput
+                    SAtxtStream.close();
+            #endif
+            delete [] saIn;
+        };
 
         if (packedInd != nSA ) {//
             ostringstream errOut;
@@ -344,8 +440,6 @@ void Genome::genomeGenerate() {
             swap(G[2*nGenome-1-ii],G[ii]);
         };
         delete [] indPrefCount;
-        delete [] indPrefStart;
-        delete [] indPrefChunkCount;
     };
 
     time ( &rawTime );
@@ -5,6 +5,7 @@
 #include "streamFuns.h"
 #include "SharedMemory.h"
 #include "genomeScanFastaFiles.h"
+#include "systemFunctions.h"
 
 //addresses with respect to shmStart of several genome values
 #define SHM_sizeG 0
@@ -201,6 +202,17 @@ void Genome::genomeLoad(){//allocate and load Genome
 
             if (sharedMemory->NeedsAllocation()){
                 P.inOut->logMain <<"Allocating shared memory for genome\n"<<flush;
+                if (pGe.gHugePages=="Hugetlb") {
+                    uint64 hugePageSize=linuxHugePageSize();
+                    if (hugePageSize==0) {
+                        ostringstream errOut;
+                        errOut << "EXITING because of FATAL ERROR: could not determine huge page size from /proc/meminfo, required for --genomeHugePages Hugetlb\n";
+                        errOut << "SOLUTION: run STAR with --genomeHugePages None or Transparent\n" <<flush;
+                        exitWithError(errOut.str(),std::cerr, P.inOut->logMain, EXIT_CODE_PARAMETER, P);
+                    };
+                    P.inOut->logMain <<"Shared memory will be allocated in huge pages of "<< hugePageSize <<" bytes\n"<<flush;
+                    sharedMemory->SetHugePages(hugePageSize);
+                };
                 sharedMemory->Allocate(shmSize);
             };
         } catch (const SharedMemoryException & exc){
@@ -208,6 +220,10 @@ void Genome::genomeLoad(){//allocate and load Genome
         };
 
         shmStart = (char*) sharedMemory->GetMapped();
+        if (sharedMemory->IsAllocator()) {
+            hugePagesAdvise(shmStart, shmSize);
+            numaInterleave(shmStart, shmSize);
+        };
         shmNG= (uint*) (shmStart+SHM_sizeG);
         shmNSA= (uint*) (shmStart+SHM_sizeSA);
 
@@ -244,6 +260,7 @@ void Genome::genomeLoad(){//allocate and load Genome
     } else if (pGe.gLoad=="NoSharedMemory") {// simply allocate memory, do not use shared memory
         genomeInsertL=0;
         genomeInsertChrIndFirst=nChrReal;
+        uint64 nG1bytes=0;
         if (pGe.gFastaFiles.at(0)!="-") {//will insert sequences in the genome, now estimate the extra size
            uint oldlen=chrStart.back();//record the old length
            genomeInsertL=genomeScanFastaFiles(P, G, false, *this)-oldlen;
@@ -269,7 +286,8 @@ void Genome::genomeLoad(){//allocate and load Genome
                     nSApass2+=2*P.limitSjdbInsertNsj*sjdbLength;
                 };
 
-                G1=new char[nGenomePass2+L+L];
+                nG1bytes=nGenomePass2+L+L;
+                G1=new char[nG1bytes];
 
                 SApass2.defineBits(GstrandBit+1,nSApass2);
                 SApass2.allocateArray();
@@ -283,10 +301,12 @@ void Genome::genomeLoad(){//allocate and load Genome
                 SA.pointArray(SAinsert.charArray+SAinsert.lengthByte-SA.lengthByte);
             } else {//no sjdb insertions
                 if (genomeInsertL==0) {// no sequence insertion, simple allocation
-                    G1=new char[nGenome+L+L];
+                    nG1bytes=nGenome+L+L;
+                    G1=new char[nG1bytes];
                     SA.allocateArray();
                 } else {
-                    G1=new char[nGenome+L+L+genomeInsertL];
+                    nG1bytes=nGenome+L+L+genomeInsertL;
+                    G1=new char[nG1bytes];
                     SAinsert.defineBits(GstrandBit+1,nSA+2*genomeInsertL);//TODO: re-define GstrandBit if necessary
                     SAinsert.allocateArray();
                     SA.pointArray(SAinsert.charArray+SAinsert.lengthByte-SA.lengthByte);
@@ -294,6 +314,14 @@ void Genome::genomeLoad(){//allocate and load Genome
             };
             SAi.allocateArray();
             P.inOut->logMain <<"Shared memory is not used for genomes. Allocated a private copy of the genome.\n"<<flush;
+
+            hugePagesAdvise(G1, nG1bytes);
+            PackedArray &SAallocated = (P.sjdbInsert.pass1 || P.sjdbInsert.pass2) ? SApass2 : (genomeInsertL>0 ? SAinsert : SA);
+            hugePagesAdvise(SAallocated.charArray, SAallocated.lengthByte);
+            hugePagesAdvise(SAi.charArray, SAi.lengthByte);
+            numaInterleave(G1, nG1bytes);
+            numaInterleave(SAallocated.charArray, SAallocated.lengthByte);
+            numaInterleave(SAi.charArray, SAi.lengthByte);
         } catch (exception & exc) {
             ostringstream errOut;
             errOut <<"EXITING: fatal error trying to allocate genome arrays, exception thrown: "<<exc.what()<<endl;
@@ -301,6 +329,25 @@ void Genome::genomeLoad(){//allocate and load Genome
             errOut <<"Possible cause 2: not enough virtual memory allowed with ulimit. SOLUTION: run ulimit -v " <<  nGenome+L+L+SA.lengthByte+SAi.lengthByte+2000000000<<endl <<flush;
             exitWithError(errOut.str(),std::cerr, P.inOut->logMain, EXIT_CODE_MEMORY_ALLOCATION, P);
         };
+    } else if (pGe.gLoad=="Mmap") {//map genome files into memory, the pages are shared with other jobs through the page cache
+        if (pGe.gFastaFiles.at(0)!="-") {
+            ostringstream errOut;
+            errOut << "EXITING because of fatal PARAMETERS error: on the fly sequence insertion with --genomeFastaFiles cannot be used with --genomeLoad Mmap\n";
+            errOut << "SOLUTION: run STAR with --genomeLoad NoSharedMemory\n" <<flush;
+            exitWithError(errOut.str(),std::cerr, P.inOut->logMain, EXIT_CODE_PARAMETER, P);
+        };
+        genomeInsertL=0;
+        genomeInsertChrIndFirst=nChrReal;
+
+        G1=mmapFile("Genome", nGenome, nGenome+L, L, true)-L;
+        for (uint ii=0;ii<L;ii++) {// attach a tail with the largest symbol
+            G1[ii]=K-1;
+            G1[L+nGenome+ii]=K-1;
+        };
+
+        SA.pointArray(mmapFile("SA", nSAbyte, SA.lengthByte, 0, false));
+        SAi.pointArray(mmapFile("SAindex", SAiInBytes+SAi.lengthByte, SAiInBytes+SAi.lengthByte, 0, false)+SAiInBytes);//SAi starts after the L-mer starts header
+        P.inOut->logMain <<"Genome files are memory-mapped, the genome is shared with other jobs through the page cache.\n"<<flush;
     };
 
     G=G1+L;
@@ -350,6 +397,12 @@ void Genome::genomeLoad(){//allocate and load Genome
     time ( &rawtime );
     P.inOut->logMain << "Finished loading the genome: " << asctime (localtime ( &rawtime )) <<"\n"<<flush;
 
+    P.inOut->logMain << "Memory pages of the genome sequence: " << linuxProcMemoryPages(G1, nGenome+L+L);
+    P.inOut->logMain << "Memory pages of the suffix array: " << linuxProcMemoryPages(SA.charArray, SA.lengthByte);
+    P.inOut->logMain << "Memory pages of the suffix array index: " << linuxProcMemoryPages(SAi.charArray, SAi.lengthByte) << flush;
+    if (numaInterleaveYes())
+        P.inOut->logMain << "NUMA nodes of the suffix array pages: " << numaPagesNodes(SA.charArray, SA.lengthByte) <<"\n"<< flush;
+
     #ifdef COMPILE_FOR_MAC
     {
         uint sum1=0;
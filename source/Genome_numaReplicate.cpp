@@ -0,0 +1,189 @@
+/*
+ * NUMA placement of the genome arrays: interleaving across nodes, or replicas on each node for the mapping threads
+ */
+#include "Genome.h"
+#include "ErrorWarning.h"
+#include "systemFunctions.h"
+#include "TimeFunctions.h"
+#include <map>
+
+bool Genome::numaInterleaveYes()
+{//true if the genome arrays should be interleaved across NUMA nodes
+    if (pGe.gNUMA!="Interleave")
+        return false;
+
+    if (!numa.init) {
+        linuxNumaNodes(numa.nodes, numa.nodeCPUs);
+        numa.init=true;
+        P.inOut->logMain << "NUMA nodes with memory available for this job: " << numa.nodes.size() <<"\n";
+        if (numa.nodes.size()<2)
+            P.inOut->logMain << "Only one NUMA node is available, --genomeNUMA Interleave is not used\n";
+        P.inOut->logMain << flush;
+    };
+
+    return numa.nodes.size()>1;
+};
+
+void Genome::numaInterleave(char *memStart, uint64 memLength)
+{//interleave pages across NUMA nodes, has to be called before the memory is filled
+    if (memStart==NULL || !numaInterleaveYes())
+        return;
+
+    uint64 pageSize=(uint64) sysconf(_SC_PAGESIZE);
+    uint64 a1=(((uint64) memStart+pageSize-1)/pageSize)*pageSize;
+    uint64 a2=(((uint64) memStart+memLength)/pageSize)*pageSize;
+    if (a2>a1 && linuxNumaBind((void*) a1, a2-a1, numa.nodes, true)!=0)
+        P.inOut->logMain << "WARNING: mbind(MPOL_INTERLEAVE) failed: " << strerror(errno) << "; genome memory will not be interleaved across NUMA nodes\n" << flush;
+};
+
+string Genome::numaPagesNodes(const char *memStart, uint64 memLength)
+{//distribution of the pages across the nodes, estimated from a sample of pages
+    uint64 pageSize=(uint64) sysconf(_SC_PAGESIZE);
+    uint64 nPages=memLength/pageSize+1;
+    uint64 nSample=min(nPages, (uint64) 1000);
+
+    std::map <int,uint64> nodeN;
+    for (uint64 ii=0; ii<nSample; ii++)
+        nodeN[linuxNumaPageNode(memStart + (nPages*ii/nSample)*pageSize)]++;
+
+    ostringstream outStream;
+    for (auto &nn : nodeN) {
+        if (nn.first<0) {
+            outStream << "unknown";
+        } else {
+            outStream << "node" << nn.first;
+        };
+        outStream << ": " << nn.second*100/nSample << "%  ";
+    };
+    return outStream.str();
+};
+
+void Genome::numaReplicate()
+{//copy the genome arrays to the NUMA nodes that do not hold them, and assign the mapping threads to nodes
+    if (pGe.gNUMA!="Replicate")
+        return;
+
+    vector <int> nodes1;
+    vector <vector<int>> nodeCPUs1;
+    linuxNumaNodes(nodes1, nodeCPUs1);
+    numa.nodes.clear();
+    numa.nodeCPUs.clear();
+    for (uint32 ii=0; ii<nodes1.size(); ii++) {//only nodes with CPUs allowed for this job can run the mapping threads
+        if (nodeCPUs1[ii].size()>0) {
+            numa.nodes.push_back(nodes1[ii]);
+            numa.nodeCPUs.push_back(nodeCPUs1[ii]);
+        };
+    };
+    numa.init=true;
+
+    P.inOut->logMain << "NUMA nodes with CPUs and memory available for this job: " << numa.nodes.size() <<"\n";
+    if (numa.nodes.size()<2) {
+        P.inOut->logMain << "Only one NUMA node is available, --genomeNUMA Replicate is not used\n" << flush;
+        numa.nodes.clear();
+        numa.nodeCPUs.clear();
+        return;
+    };
+
+    //node that holds most of the SA pages will use this genome
+    int nodeMain=-1;
+    {
+        uint64 pageSize=(uint64) sysconf(_SC_PAGESIZE);
+        uint64 nPages=SA.lengthByte/pageSize+1;
+        uint64 nSample=min(nPages, (uint64) 1000);
+        std::map <int,uint64> nodeN;
+        for (uint64 ii=0; ii<nSample; ii++)
+            nodeN[linuxNumaPageNode(SA.charArray + (nPages*ii/nSample)*pageSize)]++;
+        uint64 nMax=0;
+        for (auto &nn : nodeN) {
+            if (nn.first>=0 && nn.second>nMax) {
+                nMax=nn.second;
+                nodeMain=nn.first;
+            };
+        };
+    };
+    P.inOut->logMain << "NUMA nodes of the suffix array pages: " << numaPagesNodes(SA.charArray, SA.lengthByte) <<"\n" << flush;
+
+    uint64 gPad=G-G1; //padding before and after the genome sequence
+    uint64 lengthG1=nGenome+2*gPad;
+
+    numa.nodeGenome.assign(numa.nodes.size(), NULL);
+    vector <uint32> replicaInd;
+    for (uint32 inode=0; inode<numa.nodes.size(); inode++) {
+        if (numa.nodes[inode]==nodeMain)
+            continue;
+
+        Genome *g1=new Genome(*this);
+        g1->numa.nodeGenome.clear();
+        g1->mmapRegions.clear();
+        g1->sharedMemory=NULL;
+
+        char* arrays1[3];
+        uint64 lengths1[3]={lengthG1, SA.lengthByte, SAi.lengthByte};
+        for (int ia=0; ia<3; ia++) {
+            arrays1[ia] = (char*) mmap(NULL, lengths1[ia], PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (arrays1[ia]==(char*) MAP_FAILED) {
+                ostringstream errOut;
+                errOut << "EXITING because of FATAL ERROR: could not allocate memory for the genome replica on NUMA node " << numa.nodes[inode] << " : " << strerror(errno) <<"\n";
+                errOut << "SOLUTION: check that there is enough RAM for a copy of the genome index on each NUMA node, OR run STAR with --genomeNUMA None or Interleave\n" <<flush;
+                exitWithError(errOut.str(),std::cerr, P.inOut->logMain, EXIT_CODE_MEMORY_ALLOCATION, P);
+            };
+            g1->mmapRegions.push_back({(uint64) arrays1[ia], lengths1[ia]});
+            if (linuxNumaBind(arrays1[ia], lengths1[ia], vector<int> {numa.nodes[inode]}, false)!=0)
+                P.inOut->logMain << "WARNING: mbind(MPOL_BIND) failed for node " << numa.nodes[inode] << ": " << strerror(errno) <<"\n";
+            hugePagesAdvise(arrays1[ia], lengths1[ia]);
+        };
+
+        g1->G1=arrays1[0];
+        g1->G=g1->G1+gPad;
+        g1->SA.pointArray(arrays1[1]);
+        g1->SAi.pointArray(arrays1[2]);
+
+        numa.nodeGenome[inode]=g1;
+        replicaInd.push_back(inode);
+    };
+
+    time_t rawtime;
+    time ( &rawtime );
+    P.inOut->logMain << timeMonthDayTime(rawtime) << " ... copying genome replicas to " << replicaInd.size() << " NUMA node(s)\n" << flush;
+
+    #pragma omp parallel for num_threads(replicaInd.size()*3) schedule(static,1)
+    for (uint32 ic=0; ic<replicaInd.size()*3; ic++) {//each array of each replica in a separate thread
+        Genome *g1=numa.nodeGenome[replicaInd[ic/3]];
+        switch (ic%3) {
+            case 0:
+                memcpy(g1->G1, G1, lengthG1);
+                break;
+            case 1:
+                memcpy(g1->SA.charArray, SA.charArray, SA.lengthByte);
+                break;
+            case 2:
+                memcpy(g1->SAi.charArray, SAi.charArray, SAi.lengthByte);
+        };
+    };
+
+    time ( &rawtime );
+    P.inOut->logMain << timeMonthDayTime(rawtime) << " ... finished copying genome replicas\n";
+    for (uint32 inode=0; inode<numa.nodes.size(); inode++) {
+        Genome *g1 = numa.nodeGenome[inode]==NULL ? this : numa.nodeGenome[inode];
+        P.inOut->logMain << "NUMA node " << numa.nodes[inode] << ": " << (g1==this ? "original genome" : "genome replica")
+                         << ", " << numa.nodeCPUs[inode].size() << " CPUs; suffix array pages: " << numaPagesNodes(g1->SA.charArray, g1->SA.lengthByte) <<"\n";
+    };
+    for (int ichunk=0; ichunk<P.runThreadN; ichunk++)
+        P.inOut->logMain << "Mapping thread " << ichunk << " is pinned to NUMA node " << numa.nodes[ichunk % numa.nodes.size()] <<"\n";
+    P.inOut->logMain << flush;
+};
+
+Genome& Genome::numaChunkGenome(int iChunk)
+{//genome to be used by the mapping thread
+    if (numa.nodeGenome.empty())
+        return *this;
+    Genome *g1=numa.nodeGenome[iChunk % numa.nodeGenome.size()];
+    return g1==NULL ? *this : *g1;
+};
+
+vector<int> Genome::numaChunkCPUs(int iChunk)
+{//CPUs to pin the mapping thread to, empty if the thread is not pinned
+    if (numa.nodeGenome.empty())
+        return vector<int>();
+    return numa.nodeCPUs[iChunk % numa.nodeCPUs.size()];
+};
@@ -6,6 +6,8 @@ InOutStreams::InOutStreams() {
     outSAM=NULL;
     outBAMfileUnsorted=NULL;
     outQuantBAMfile=NULL;
+    for (int ii=0;ii<MAX_N_MATES;ii++)
+        readInBuf[ii]=NULL;
 };
 
 InOutStreams::~InOutStreams() {
@@ -4,6 +4,8 @@
 #include "IncludeDefine.h"
 #include SAMTOOLS_BGZF_H
 
+class ReadFilesStreambuf;
+
 class InOutStreams {
     public:
     ostream *logStdOut, *outSAM;
@@ -12,6 +14,7 @@ class InOutStreams {
 
     ofstream outChimSAM, outChimJunction, logMain, logProgress, logFinal, outUnmappedReadsStream[MAX_N_MATES];
     ifstream readIn[MAX_N_MATES];
+    ReadFilesStreambuf *readInBuf[MAX_N_MATES]; //native reading of the read files, installed into readIn
 
     //compilation-optional streams
     ofstream outLocalChains;
@@ -1,5 +1,6 @@
 #include "OutSJ.h"
 #include "ErrorWarning.h"
+#include "radixSort.h"
 
 OutSJ::OutSJ (uint nSJmax, Parameters &Pin, Genome &genomeIn) : oneSJ(genomeIn), P(Pin), genOut(genomeIn)  {//do I need P?
 
@@ -9,6 +10,7 @@ OutSJ::OutSJ (uint nSJmax, Parameters &Pin, Genome &genomeIn) : oneSJ(genomeIn),
     data = dataVec.data();
     memset(data,0,oneSJ.dataSize*Nstore);
     N=0;//initialize the counter
+    Ncollapsed=0;
 };
 
 
@@ -33,30 +35,72 @@ int compareSJ(const void* i1, const void* i2) {//compare SJs from the data struc
     };
 };
 
-void OutSJ::collapseSJ() {//collapse junctions. Simple version now: re-sort everything
-                                //TODO: sort only unsorted portion, and merge two sorted lists
-                                //TODO: if there are many collapsed junctions, add the new junction to them w/o sorting
+void OutSJ::collapseSJ() {//collapse junctions: sort only the junctions recorded after the last collapse, and merge them into the collapsed junctions
                                 //TODO: stranded version
+    if (N==Ncollapsed) return;
+    uint64 nTail=N-Ncollapsed;
+    char *tailIn=data+Ncollapsed*oneSJ.dataSize;
+
     //sort by start and gap
-    if (N==0) return;
-    qsort((void*) data, N, oneSJ.dataSize, compareSJ);
+    tailKeys.resize(nTail*3);
+    for (uint64 isj=0; isj<nTail; isj++) {
+        char *isjP=tailIn+isj*oneSJ.dataSize;
+        tailKeys[isj*3]  =*(uint*)(isjP+Junction::startP);
+        tailKeys[isj*3+1]=*(uint32*)(isjP+Junction::gapP);
+        tailKeys[isj*3+2]=isj;
+    };
+    radixSortUint64(tailKeys.data(), nTail, 3, 1);
+
     //collapse
-    uint isj1=0; //last collapsed junction
-    char* isj1P=data;
-    for (uint isj=1;isj<N;isj++) {//cycle through all non-collapsed junctions
-        char* isjP=data+isj*oneSJ.dataSize;
-        if ( compareSJ( (void*) isjP, (void*) isj1P ) == 0 ) {
-            oneSJ.collapseOneSJ(isj1P, isjP, P);
-        } else {//originate new junction: copy from isj to isj1+1
-            isj1++;
-            isj1P=data+isj1*oneSJ.dataSize;
-            if (isj!=isj1)
-            {
-                memcpy(isj1P,isjP,oneSJ.dataSize);
-            };
+    tailVec.resize(nTail*oneSJ.dataSize);
+    char *tail=tailVec.data();
+    uint64 nTail1=0; //collapsed junctions
+    for (uint64 ii=0; ii<nTail; ii++) {
+        char* isjP=tailIn+tailKeys[ii*3+2]*oneSJ.dataSize;
+        if ( nTail1>0 && compareSJ( (void*) isjP, (void*) (tail+(nTail1-1)*oneSJ.dataSize) ) == 0 ) {
+            oneSJ.collapseOneSJ(tail+(nTail1-1)*oneSJ.dataSize, isjP, P);
+        } else {//originate new junction
+            memcpy(tail+nTail1*oneSJ.dataSize, isjP, oneSJ.dataSize);
+            nTail1++;
+        };
+    };
+
+    N=Ncollapsed;
+    mergeSJ(tail, nTail1);
+};
+
+void OutSJ::mergeSJ(const char *sjIn, uint64 nIn) {//sjIn cannot point into data
+    while (N+nIn > Nstore)
+        dataSizeIncrease();
+
+    //merge from the end, the merged junctions are placed at the end of [0,N+nIn)
+    int64 i1=(int64) N-1, i2=(int64) nIn-1;
+    uint64 iOut=N+nIn;
+    while (i2>=0) {
+        char *sj1=data+i1*oneSJ.dataSize;
+        const char *sj2=sjIn+i2*oneSJ.dataSize;
+        int comp = i1>=0 ? compareSJ( (void*) sj1, (void*) sj2 ) : -1;
+        --iOut; //iOut>i1 while i2>=0
+        if (comp>0) {
+            memcpy(data+iOut*oneSJ.dataSize, sj1, oneSJ.dataSize);
+            --i1;
+        } else if (comp<0) {
+            memcpy(data+iOut*oneSJ.dataSize, sj2, oneSJ.dataSize);
+            --i2;
+        } else {//same junction
+            oneSJ.collapseOneSJ(sj1, (char*) sj2, P);
+            memcpy(data+iOut*oneSJ.dataSize, sj1, oneSJ.dataSize);
+            --i1;
+            --i2;
         };
     };
-    N=isj1+1;
+
+    //junctions [0,i1] are in place, move the merged junctions next to them
+    uint64 nMerged=N+nIn-iOut;
+    if (iOut>(uint64) (i1+1))
+        memmove(data+(i1+1)*oneSJ.dataSize, data+iOut*oneSJ.dataSize, nMerged*oneSJ.dataSize);
+    N=i1+1+nMerged;
+    Ncollapsed=N;
 };
 
 void OutSJ::dataSizeIncrease() {
@@ -65,6 +109,90 @@ void OutSJ::dataSizeIncrease() {
     data = dataVec.data();
 };
 
+#define OUTSJ_TABLE_shardsPerThread 8
+#define OUTSJ_TABLE_shardSJ0 1024
+
+static inline uint64 hashSJ(const char *sjP) {//hash of the junction start and gap
+    uint64 h = *(uint*)(sjP+Junction::startP) * 0x9E3779B97F4A7C15LLU ^ *(uint32*)(sjP+Junction::gapP) * 0xC2B2AE3D27D4EB4FLLU;
+    return h ^ (h>>32);
+};
+
+OutSJtable::OutSJtable(Parameters &Pin, Genome &genomeIn) : P(Pin) {
+    shards.resize(P.runThreadN*OUTSJ_TABLE_shardsPerThread);
+    shardLength=genomeIn.nGenome/shards.size()+1;
+    for (auto &sh : shards) {
+        sh.sj = new OutSJ (OUTSJ_TABLE_shardSJ0, P, genomeIn);
+        sh.hash.resize(2*OUTSJ_TABLE_shardSJ0, 0);
+        pthread_mutex_init(&sh.mutex, NULL);
+    };
+};
+
+OutSJtable::~OutSJtable() {
+    for (auto &sh : shards) {
+        delete sh.sj;
+        pthread_mutex_destroy(&sh.mutex);
+    };
+};
+
+void OutSJtable::shardHash(Shard &sh) {
+    std::fill(sh.hash.begin(), sh.hash.end(), 0);
+    uint64 hashMask=sh.hash.size()-1;
+    for (uint64 isj=0; isj<sh.sj->N; isj++) {
+        uint64 ih=hashSJ(sh.sj->data+isj*Junction::dataSize) & hashMask;
+        while (sh.hash[ih]>0)
+            ih=(ih+1) & hashMask;
+        sh.hash[ih]=isj+1;
+    };
+};
+
+void OutSJtable::insert(OutSJ &sjIn) {
+    uint64 i1=0;
+    while (i1<sjIn.N) {
+        //junctions are sorted by start: [i1,i2) belong to the same shard
+        uint64 iShard=min(*(uint*)(sjIn.data+i1*Junction::dataSize+Junction::startP)/shardLength, (uint64) shards.size()-1);
+        uint64 i2=i1+1;
+        while (i2<sjIn.N && min(*(uint*)(sjIn.data+i2*Junction::dataSize+Junction::startP)/shardLength, (uint64) shards.size()-1)==iShard)
+            ++i2;
+
+        Shard &sh=shards[iShard];
+        pthread_mutex_lock(&sh.mutex);
+        for (; i1<i2; i1++) {
+            char *sjP=sjIn.data+i1*Junction::dataSize;
+            if ( 2*(sh.sj->N+1) > sh.hash.size() ) {//keep the load factor below 1/2
+                sh.hash.resize(2*sh.hash.size());
+                shardHash(sh);
+            };
+            uint64 hashMask=sh.hash.size()-1;
+            uint64 ih=hashSJ(sjP) & hashMask;
+            while (sh.hash[ih]>0 && compareSJ(sh.sj->data+(sh.hash[ih]-1)*Junction::dataSize, sjP)!=0)
+                ih=(ih+1) & hashMask;
+
+            if (sh.hash[ih]>0) {//junction is already in the table
+                sh.sj->oneSJ.collapseOneSJ(sh.sj->data+(sh.hash[ih]-1)*Junction::dataSize, sjP, P);
+            } else {
+                if (sh.sj->N==sh.sj->Nstore)
+                    sh.sj->dataSizeIncrease();
+                memcpy(sh.sj->data+sh.sj->N*Junction::dataSize, sjP, Junction::dataSize);
+                sh.hash[ih]=++sh.sj->N;
+            };
+        };
+        pthread_mutex_unlock(&sh.mutex);
+    };
+    sjIn.N=0;
+    sjIn.Ncollapsed=0;
+};
+
+void OutSJtable::collect(OutSJ &sjOut) {//all threads have finished mapping
+    #pragma omp parallel for num_threads(P.runThreadN) schedule(dynamic,1)
+    for (uint64 ish=0; ish<shards.size(); ish++) {//sort the shards, the hash tables are rebuilt for the junctions added later
+        shards[ish].sj->collapseSJ();
+        shardHash(shards[ish]);
+    };
+
+    for (auto &sh : shards) //shards follow each other in the order of junction starts
+        sjOut.mergeSJ(sh.sj->data, sh.sj->N);
+};
+
 Junction::Junction(Genome &genOut) : genOut(genOut) {
 };
 
@@ -3,6 +3,7 @@
 
 #include "Parameters.h"
 #include "Genome.h"
+#include <pthread.h>
 
 class Junction {//one junction
 public:
@@ -40,10 +41,12 @@ public:
     char* data; //sj array[Njunctions][dataSize]
     vector<char> dataVec;
     uint64 N, Nstore; //N=number of junctions stored; Nstore=storage size
+    uint64 Ncollapsed; //junctions [0,Ncollapsed) are sorted and collapsed
     Junction oneSJ;
 
     OutSJ(uint64 nSJmax, Parameters &Pin, Genome &genomeIn);
     void collapseSJ();//collapse the junctions in data
+    void mergeSJ(const char *sjIn, uint64 nIn);//merge sorted collapsed junctions into the sorted collapsed data
 //     int compareSJ(void* i1, void* i2);
 
     void dataSizeIncrease();
@@ -51,6 +54,29 @@ public:
 private:
     Parameters &P;
     Genome &genOut;
+    vector <uint64> tailKeys;//sorting keys of the junctions recorded after the last collapse
+    vector <char> tailVec;//sorted and collapsed junctions recorded after the last collapse
+};
+
+class OutSJtable {//junctions from all threads, the threads add their collapsed junctions while mapping
+                  //the shards cover consecutive ranges of junction starts, each shard has its own hash table and mutex
+public:
+    OutSJtable(Parameters &Pin, Genome &genomeIn);
+    ~OutSJtable();
+    void insert(OutSJ &sjIn);//add the sorted collapsed junctions of sjIn, sjIn is emptied
+    void collect(OutSJ &sjOut);//merge all junctions into sjOut, sorted and collapsed
+
+private:
+    struct Shard {
+        OutSJ *sj;//junctions of the shard
+        vector <uint64> hash;//junction index+1 in each slot, 0 for empty slots
+        pthread_mutex_t mutex;
+    };
+    Parameters &P;
+    vector <Shard> shards;
+    uint64 shardLength;//junction starts in each shard
+
+    void shardHash(Shard &sh);//rebuild the hash table of the shard
 };
 
 int compareSJ(const void* i1, const void* i2); //external functions
@@ -39,6 +39,8 @@ Parameters::Parameters() {//initalize parameters info
     parArray.push_back(new ParameterInfoScalar <string> (-1, -1, "genomeType", &pGe.gTypeString));    
     parArray.push_back(new ParameterInfoScalar <string> (-1, -1, "genomeDir", &pGe.gDir));
     parArray.push_back(new ParameterInfoScalar <string> (-1, -1, "genomeLoad", &pGe.gLoad));
+    parArray.push_back(new ParameterInfoScalar <string> (-1, -1, "genomeHugePages", &pGe.gHugePages));
+    parArray.push_back(new ParameterInfoScalar <string> (-1, -1, "genomeNUMA", &pGe.gNUMA));
     parArray.push_back(new ParameterInfoVector <string> (-1, -1, "genomeFastaFiles", &pGe.gFastaFiles));
     parArray.push_back(new ParameterInfoVector <string> (-1, -1, "genomeChainFiles", &pGe.gChainFiles));
     parArray.push_back(new ParameterInfoScalar <uint> (-1, -1, "genomeSAindexNbases", &pGe.gSAindexNbases));
@@ -57,6 +59,7 @@ Parameters::Parameters() {//initalize parameters info
     parArray.push_back(new ParameterInfoVector <string> (-1, -1, "readFilesIn", &readFilesIn));
     parArray.push_back(new ParameterInfoScalar <string> (-1, -1, "readFilesPrefix", &readFilesPrefix));
     parArray.push_back(new ParameterInfoVector <string> (-1, -1, "readFilesCommand", &readFilesCommand));
+    parArray.push_back(new ParameterInfoScalar <int> (-1, -1, "readFilesDecompressThreadN", &readFilesDecompressThreadN));
 
     parArray.push_back(new ParameterInfoScalar <string> (-1, -1, "readMatesLengthsIn", &readMatesLengthsIn));
     parArray.push_back(new ParameterInfoScalar <uint> (-1, -1, "readMapNumber", &readMapNumber));
@@ -82,6 +85,8 @@ Parameters::Parameters() {//initalize parameters info
     parArray.push_back(new ParameterInfoScalar <uint>   (-1, -1, "limitOutSJcollapsed", &limitOutSJcollapsed));
     parArray.push_back(new ParameterInfoScalar <uint>   (-1, -1, "limitOutSJoneRead", &limitOutSJoneRead));
     parArray.push_back(new ParameterInfoScalar <uint>   (-1, -1, "limitBAMsortRAM", &limitBAMsortRAM));
+    parArray.push_back(new ParameterInfoScalar <uint>   (-1, -1, "limitBAMsortBinsRAM", &limitBAMsortBinsRAM));
+    parArray.push_back(new ParameterInfoScalar <uint>   (-1, -1, "limitSoloReadsRAM", &limitSoloReadsRAM));
     parArray.push_back(new ParameterInfoScalar <uint>   (-1, -1, "limitSjdbInsertNsj", &limitSjdbInsertNsj));
     parArray.push_back(new ParameterInfoScalar <uint>   (-1, -1, "limitNreadsSoft", &limitNreadsSoft));
 
@@ -113,6 +118,8 @@ Parameters::Parameters() {//initalize parameters info
     parArray.push_back(new ParameterInfoScalar <int>        (-1, -1, "outBAMcompression", &outBAMcompression));
     parArray.push_back(new ParameterInfoScalar <int>        (-1, -1, "outBAMsortingThreadN", &outBAMsortingThreadN));
     parArray.push_back(new ParameterInfoScalar <uint32>        (-1, -1, "outBAMsortingBinsN", &outBAMsortingBinsN));
+    parArray.push_back(new ParameterInfoScalar <string>        (-1, -1, "outBAMsortingPresort", &outBAMsortingPresort.in));
+    parArray.push_back(new ParameterInfoScalar <string>        (-1, -1, "outBAMsortingIndex", &outBAMsortingIndex.in));
     parArray.push_back(new ParameterInfoVector <string>     (-1, -1, "outSAMfilter", &outSAMfilter.mode));
     parArray.push_back(new ParameterInfoScalar <uint>     (-1, -1, "outSAMmultNmax", &outSAMmultNmax));
     parArray.push_back(new ParameterInfoScalar <uint>     (-1, -1, "outSAMattrIHstart", &outSAMattrIHstart));
@@ -189,6 +196,7 @@ Parameters::Parameters() {//initalize parameters info
     parArray.push_back(new ParameterInfoScalar <uint>       (-1, -1, "seedSearchLmax", &seedSearchLmax));
     parArray.push_back(new ParameterInfoScalar <uint>       (-1, -1, "seedSearchStartLmax", &seedSearchStartLmax));
     parArray.push_back(new ParameterInfoScalar <double>     (-1, -1, "seedSearchStartLmaxOverLread", &seedSearchStartLmaxOverLread));
+    parArray.push_back(new ParameterInfoScalar <string>     (-1, -1, "seedSearchBatch", &seedSearchBatch.in));
 
     parArray.push_back(new ParameterInfoScalar <uint>       (-1, -1, "seedPerReadNmax", &seedPerReadNmax));
     parArray.push_back(new ParameterInfoScalar <uint>       (-1, -1, "seedPerWindowNmax", &seedPerWindowNmax));
@@ -277,6 +285,7 @@ Parameters::Parameters() {//initalize parameters info
     parArray.push_back(new ParameterInfoScalar <uint32>   (-1, -1, "soloBarcodeReadLength", &pSolo.bL));
     parArray.push_back(new ParameterInfoScalar <uint32>   (-1, -1, "soloBarcodeMate", &pSolo.barcodeReadIn));
     parArray.push_back(new ParameterInfoVector <string>   (-1, -1, "soloCBwhitelist", &pSolo.soloCBwhitelist));
+    parArray.push_back(new ParameterInfoScalar <string>   (-1, -1, "soloCBwhitelistCache", &pSolo.soloCBwhitelistCache));
     parArray.push_back(new ParameterInfoScalar <string>   (-1, -1, "soloStrand", &pSolo.strandStr));
     parArray.push_back(new ParameterInfoVector <string>   (-1, -1, "soloOutFileNames", &pSolo.outFileNames));
     parArray.push_back(new ParameterInfoVector <string>   (-1, -1, "soloFeatures", &pSolo.featureIn));
@@ -1035,7 +1044,7 @@ void Parameters::inputParameters (int argInN, char* argIn[]) {//input parameters
     };
 
     if (outBAMcoord && limitBAMsortRAM==0) {//check limitBAMsortRAM
-        if (pGe.gLoad!="NoSharedMemory") {
+        if (pGe.gLoad!="NoSharedMemory" && pGe.gLoad!="Mmap") {
             ostringstream errOut;
             errOut <<"EXITING because of fatal PARAMETERS error: limitBAMsortRAM=0 (default) cannot be used with --genomeLoad="<<pGe.gLoad <<", or any other shared memory options\n";
             errOut <<"SOLUTION: please use default --genomeLoad NoSharedMemory, \n        OR specify --limitBAMsortRAM the amount of RAM (bytes) that can be allocated for BAM sorting in addition to shared memory allocated for the genome.\n        --limitBAMsortRAM typically has to be > 10000000000 (i.e 10GB).\n";
@@ -1044,6 +1053,13 @@ void Parameters::inputParameters (int argInN, char* argIn[]) {//input parameters
         inOut->logMain<<"WARNING: --limitBAMsortRAM=0, will use genome size as RAM limit for BAM sorting\n";
     };
 
+    if (outBAMcoord && limitBAMsortBinsRAM>0 && limitBAMsortRAM>0 && limitBAMsortBinsRAM>limitBAMsortRAM) {
+        ostringstream errOut;
+        errOut <<"EXITING because of fatal PARAMETERS error: --limitBAMsortBinsRAM "<<limitBAMsortBinsRAM<<" is larger than --limitBAMsortRAM "<<limitBAMsortRAM<<"\n";
+        errOut <<"SOLUTION: the in-memory sorting bins are a part of the BAM sorting RAM, reduce --limitBAMsortBinsRAM or increase --limitBAMsortRAM\n";
+        exitWithError(errOut.str(), std::cerr, inOut->logMain, EXIT_CODE_PARAMETER, *this);
+    };
+
     for (uint ii=0; ii<readNameSeparator.size(); ii++) {
         if (readNameSeparator.at(ii)=="space") {
             readNameSeparatorChar.push_back(' ');
@@ -1126,6 +1142,42 @@ void Parameters::inputParameters (int argInN, char* argIn[]) {//input parameters
         exitWithError(errOut.str(),std::cerr, inOut->logMain, EXIT_CODE_PARAMETER, *this);
     };
 
+    //seedSearchBatch
+    if (seedSearchBatch.in=="Yes") {
+        seedSearchBatch.yes=true;
+    } else if (seedSearchBatch.in=="No") {
+        seedSearchBatch.yes=false;
+    } else {
+        ostringstream errOut;
+        errOut << "EXITING because of fatal PARAMETERS error: unrecognized option in --seedSearchBatch   "<<seedSearchBatch.in<<"\n";
+        errOut << "SOLUTION: use allowed option: Yes or No";
+        exitWithError(errOut.str(),std::cerr, inOut->logMain, EXIT_CODE_PARAMETER, *this);
+    };
+
+    //outBAMsortingPresort
+    if (outBAMsortingPresort.in=="Yes") {
+        outBAMsortingPresort.yes=true;
+    } else if (outBAMsortingPresort.in=="No") {
+        outBAMsortingPresort.yes=false;
+    } else {
+        ostringstream errOut;
+        errOut << "EXITING because of fatal PARAMETERS error: unrecognized option in --outBAMsortingPresort   "<<outBAMsortingPresort.in<<"\n";
+        errOut << "SOLUTION: use allowed option: Yes or No";
+        exitWithError(errOut.str(),std::cerr, inOut->logMain, EXIT_CODE_PARAMETER, *this);
+    };
+
+    //outBAMsortingIndex
+    if (outBAMsortingIndex.in=="None") {
+        outBAMsortingIndex.yes=false;
+    } else if (outBAMsortingIndex.in=="Auto" || outBAMsortingIndex.in=="BAI" || outBAMsortingIndex.in=="CSI") {
+        outBAMsortingIndex.yes=outBAMcoord;
+    } else {
+        ostringstream errOut;
+        errOut << "EXITING because of fatal PARAMETERS error: unrecognized option in --outBAMsortingIndex   "<<outBAMsortingIndex.in<<"\n";
+        errOut << "SOLUTION: use allowed option: None or Auto or BAI or CSI";
+        exitWithError(errOut.str(),std::cerr, inOut->logMain, EXIT_CODE_PARAMETER, *this);
+    };
+
     outSAMreadIDnumber=false;
     if (outSAMreadID=="Number") {
         outSAMreadIDnumber=true;
@@ -71,6 +71,7 @@ class Parameters {
         string readFilesCommandString; //actual command string
         int readFilesIndex;
         pid_t readFilesCommandPID[MAX_N_MATES];
+        int readFilesDecompressThreadN, readFilesDecompressThreadNactual;
 
         uint readMapNumber;
         uint iReadAll;
@@ -140,6 +141,10 @@ class Parameters {
         uint seedSearchStartLmax;
         double seedSearchStartLmaxOverLread; //length of split start points
         uint64 seedSplitMin, seedMapMin;
+        struct {
+            string in;
+            bool yes;
+        } seedSearchBatch; //interleaved suffix array searches of the seeds
 
         //chunk parameters
         uint chunkInSizeBytes,chunkInSizeBytesArray,chunkOutBAMsizeBytes;
@@ -174,6 +179,14 @@ class Parameters {
         bool outBAMunsorted, outBAMcoord, outSAMbool;
         uint32 outBAMcoordNbins;
         uint32 outBAMsortingBinsN;//user-defined number of bins for sorting
+        struct {
+            string in;
+            bool yes;
+        } outBAMsortingPresort;//sort the bin buffers in the mapping threads, merge them at the sorting stage
+        struct {
+            string in;
+            bool yes;
+        } outBAMsortingIndex;//index the sorted BAM while the bins are written
         string outBAMsortTmpDir;
 
 //         string bamRemoveDuplicatesType;
@@ -279,6 +292,8 @@ class Parameters {
         uint64 limitOutSAMoneReadBytes;
         uint64 limitOutSJoneRead, limitOutSJcollapsed;
         uint64 limitBAMsortRAM;
+        uint64 limitBAMsortBinsRAM;
+        uint64 limitSoloReadsRAM;
         uint64 limitSjdbInsertNsj;
         uint64 limitNreadsSoft;
 
@@ -50,10 +50,36 @@ void ParametersGenome::initialize(Parameters *pPin)
         exitWithError(errOut.str(),std::cerr, pP->inOut->logMain, EXIT_CODE_PARAMETER, *pP);
     };
 
-    if (gLoad!="LoadAndKeep" && gLoad!="LoadAndRemove" && gLoad!="Remove" && gLoad!="LoadAndExit" && gLoad!="NoSharedMemory") {// find shared memory fragment
+    if (gLoad!="LoadAndKeep" && gLoad!="LoadAndRemove" && gLoad!="Remove" && gLoad!="LoadAndExit" && gLoad!="NoSharedMemory" && gLoad!="Mmap") {// find shared memory fragment
         ostringstream errOut;
         errOut << "EXITING because of FATAL INPUT ERROR: --genomeLoad=" << gLoad << "\n" <<flush;
-        errOut << "SOLUTION: use one of the allowed values for --genomeLoad : NoSharedMemory,LoadAndKeep,LoadAndRemove,LoadAndExit,Remove.\n" <<flush;
+        errOut << "SOLUTION: use one of the allowed values for --genomeLoad : NoSharedMemory,Mmap,LoadAndKeep,LoadAndRemove,LoadAndExit,Remove.\n" <<flush;
         exitWithError(errOut.str(),std::cerr, pP->inOut->logMain, EXIT_CODE_PARAMETER, *pP);
     };    
+
+    if (gHugePages!="None" && gHugePages!="Transparent" && gHugePages!="Hugetlb") {
+        ostringstream errOut;
+        errOut << "EXITING because of FATAL INPUT ERROR: --genomeHugePages=" << gHugePages << "\n" <<flush;
+        errOut << "SOLUTION: use one of the allowed values for --genomeHugePages : None,Transparent,Hugetlb.\n" <<flush;
+        exitWithError(errOut.str(),std::cerr, pP->inOut->logMain, EXIT_CODE_PARAMETER, *pP);
+    };
+
+    if (gNUMA!="None" && gNUMA!="Interleave" && gNUMA!="Replicate") {
+        ostringstream errOut;
+        errOut << "EXITING because of FATAL INPUT ERROR: --genomeNUMA=" << gNUMA << "\n" <<flush;
+        errOut << "SOLUTION: use one of the allowed values for --genomeNUMA : None,Interleave,Replicate.\n" <<flush;
+        exitWithError(errOut.str(),std::cerr, pP->inOut->logMain, EXIT_CODE_PARAMETER, *pP);
+    };
+
+    #ifdef POSIX_SHARED_MEM
+    bool hugetlbShm=false; //POSIX shared memory objects cannot be allocated in hugetlbfs
+    #else
+    bool hugetlbShm = gLoad=="LoadAndKeep" || gLoad=="LoadAndRemove" || gLoad=="LoadAndExit";
+    #endif
+    if (gHugePages=="Hugetlb" && !hugetlbShm) {
+        ostringstream errOut;
+        errOut << "EXITING because of FATAL INPUT ERROR: --genomeHugePages Hugetlb can only be used with SysV shared memory: --genomeLoad LoadAndKeep, LoadAndRemove or LoadAndExit\n" <<flush;
+        errOut << "SOLUTION: use --genomeHugePages Transparent, OR load the genome into shared memory\n" <<flush;
+        exitWithError(errOut.str(),std::cerr, pP->inOut->logMain, EXIT_CODE_PARAMETER, *pP);
+    };
 };
\ No newline at end of file
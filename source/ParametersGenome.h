@@ -10,6 +10,8 @@ class ParametersGenome {//"constant" genome parameters - user input
 public:
     string gDir;
     string gLoad;
+    string gHugePages;
+    string gNUMA;
     
     uint32 gType;//type code
     string gTypeString;
@@ -6,6 +6,7 @@
 #include "serviceFuns.cpp"
 
 #include <stdlib.h>
+#include <unistd.h>
 
 void ParametersSolo::initialize(Parameters *pPin)
 {
@@ -311,6 +312,9 @@ void ParametersSolo::initialize(Parameters *pPin)
             cbWLyes=false;
         } else {
             cbWLyes=true;
+        };
+        
+        if (cbWLyes && !cbWLcacheLoad()) {//load from the text file. The cache, if present, already contains sorted and collapsed whitelist
             ifstream & cbWlStream = ifstrOpen(soloCBwhitelist[0], ERROR_OUT, "SOLUTION: check the path and permissions of the CB whitelist file: " + soloCBwhitelist[0], *pP);
             string seq1;
             while (cbWlStream >> seq1) {
@@ -332,17 +336,20 @@ void ParametersSolo::initialize(Parameters *pPin)
                                " is empty. \nSOLUTION: provide non-empty whitelist.\n" , \
                                std::cerr, pP->inOut->logMain, EXIT_CODE_INPUT_FILES, *pP);
             };
+            
+            std::sort(cbWL.begin(),cbWL.end());//sort
+            auto un1=std::unique(cbWL.begin(),cbWL.end());//collapse identical
+            cbWL.resize(std::distance(cbWL.begin(),un1));
+            cbWLcacheSave();
         };
-
-        std::sort(cbWL.begin(),cbWL.end());//sort
-        auto un1=std::unique(cbWL.begin(),cbWL.end());//collapse identical
-        cbWL.resize(std::distance(cbWL.begin(),un1));        
+        
         cbWLsize=cbWL.size();
         pP->inOut->logMain << "Number of CBs in the whitelist = " << cbWLsize <<endl;
         
         cbWLstr.resize(cbWLsize);
         for (uint64 ii=0; ii<cbWLsize; ii++)
              cbWLstr[ii] = convertNuclInt64toString(cbWL[ii],cbL);        
+        cbWLhash.build(cbWL);
         
     //////////////////////////////////////////////////////////////////////////////////
     } else if (type==SoloTypes::SmartSeq) {
@@ -449,6 +456,7 @@ void ParametersSolo::initialize(Parameters *pPin)
         readStatsYes[SoloFeatureTypes::VelocytoSimple] = false; //this could be allowed, but it will have the same info as Gene
         readStatsYes[SoloFeatureTypes::Velocyto] = false;
         readStatsYes[SoloFeatureTypes::SJ] = false; //output for SJ requires careful consideration for SoloReadFeature_record.cpp, for output of reads that do not have splice junction
+        readStatsYes[SoloFeatureTypes::Transcript3p] = false; //Transcript3p records have a different format, and its counting does not output the read stats
         for (uint32 ff=0; ff<readIndexYes.size(); ff++) {//merge with previous values
             readIndexYes[ff] |= readStatsYes[ff];
         };
@@ -725,3 +733,91 @@ void ParametersSolo::init_CBmatchWL()
                         std::cerr, pP->inOut->logMain, EXIT_CODE_PARAMETER, *pP);
     };
 };
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//binary cache of the simple whitelist. Header: 8-byte tag, cbL, size and checksum of the whitelist file, number of CBs
+static const char cbWLcacheTag[8]={'S','T','A','R','c','b','W','2'};
+
+static bool wlFileChecksum(const string &fileName, uint64 &fileSize, uint64 &checksum)
+{//size and 64-bit checksum of the file contents, reading the file is much faster than converting the barcodes
+    ifstream fileIn(fileName, std::ios::binary);
+    if (!fileIn.good())
+        return false;
+    
+    vector<char> buf(1LLU<<20);
+    fileSize=0;
+    checksum=0x9E3779B97F4A7C15LLU;
+    while (fileIn.good()) {
+        fileIn.read(buf.data(), buf.size());
+        uint64 n=fileIn.gcount();
+        for (uint64 ii=0; ii<n; ii+=8) {//only the last chunk can be shorter than buf
+            uint64 w=0;
+            memcpy(&w, buf.data()+ii, min((uint64)8, n-ii));
+            checksum = (checksum ^ w) * 0xBF58476D1CE4E5B9LLU;
+            checksum ^= checksum>>31;
+        };
+        fileSize+=n;
+    };
+    return !fileIn.bad();
+};
+
+bool ParametersSolo::cbWLcacheLoad()
+{
+    if (soloCBwhitelistCache=="None")
+        return false;
+    
+    ifstream cacheStream(soloCBwhitelistCache, std::ios::binary);
+    if (!cacheStream.good())
+        return false;
+    
+    uint64 wlSize, wlChecksum;
+    if (!wlFileChecksum(soloCBwhitelist[0], wlSize, wlChecksum))
+        return false; //the text file error will be reported when it is opened
+    
+    char tag1[8];
+    uint64 head1[4];//cbL, file size, checksum, number of CBs
+    cacheStream.read(tag1, sizeof(tag1));
+    cacheStream.read((char*) head1, sizeof(head1));
+    if (cacheStream.fail() || memcmp(tag1, cbWLcacheTag, sizeof(tag1))!=0 
+        || head1[0]!=cbL || head1[1]!=wlSize || head1[2]!=wlChecksum || head1[3]==0) {
+        pP->inOut->logMain << "CB whitelist cache " << soloCBwhitelistCache << " does not match the whitelist file, it will be rewritten" << endl;
+        return false;
+    };
+    
+    cbWL.resize(head1[3]);
+    cacheStream.read((char*) cbWL.data(), cbWL.size()*sizeof(cbWL[0]));
+    if ((uint64)cacheStream.gcount() != cbWL.size()*sizeof(cbWL[0])) {
+        pP->inOut->logMain << "CB whitelist cache " << soloCBwhitelistCache << " is truncated, it will be rewritten" << endl;
+        cbWL.clear();
+        return false;
+    };
+    
+    pP->inOut->logMain << "Loaded CB whitelist from the cache " << soloCBwhitelistCache << endl;
+    return true;
+};
+
+void ParametersSolo::cbWLcacheSave()
+{
+    if (soloCBwhitelistCache=="None")
+        return;
+    
+    uint64 wlSize, wlChecksum;
+    if (!wlFileChecksum(soloCBwhitelist[0], wlSize, wlChecksum))
+        return;
+    
+    string fileTmp=soloCBwhitelistCache + ".tmp" + to_string(getpid());//written to a temporary file and renamed, in case several runs share the cache
+    ofstream cacheStream(fileTmp, std::ios::binary);
+    uint64 head1[4]={cbL, wlSize, wlChecksum, cbWL.size()};
+    cacheStream.write(cbWLcacheTag, sizeof(cbWLcacheTag));
+    cacheStream.write((char*) head1, sizeof(head1));
+    cacheStream.write((char*) cbWL.data(), cbWL.size()*sizeof(cbWL[0]));
+    cacheStream.close();
+    
+    if (cacheStream.fail() || rename(fileTmp.c_str(), soloCBwhitelistCache.c_str())!=0) {
+        remove(fileTmp.c_str());
+        warningMessage("could not write CB whitelist cache " + soloCBwhitelistCache + ", the whitelist will be loaded from the text file in the next run", \
+                       pP->inOut->logMain, std::cerr, *pP);
+        return;
+    };
+    pP->inOut->logMain << "Wrote CB whitelist cache " << soloCBwhitelistCache << endl;
+};
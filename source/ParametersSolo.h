@@ -8,6 +8,7 @@
 
 #include "IncludeDefine.h"
 #include "SoloBarcode.h"
+#include "SoloCBhash.h"
 #include "SoloFeatureTypes.h"
 
 class Parameters;
@@ -107,7 +108,9 @@ public:
     uint64 cbWLsize;
     bool cbWLyes;
     vector<string> soloCBwhitelist;
+    string soloCBwhitelistCache; //binary cache of the simple whitelist
     vector <uint64> cbWL;    
+    SoloCBhash cbWLhash; //hash index of cbWL
     vector<string> cbWLstr;
     
     MultiMappers multiMap;
@@ -213,6 +216,8 @@ public:
     void initialize(Parameters *pPin);
     void umiSwapHalves(uint32 &umi);
     void complexWLstrings();
+    bool cbWLcacheLoad();
+    void cbWLcacheSave();
     void cellFiltering();
 
     void init_CBmatchWL();
@@ -1,11 +1,17 @@
 #include "Parameters.h"
 #include "ErrorWarning.h"
+#include "ReadFilesStreambuf.h"
 #include <fstream>
 #include <sys/stat.h>
 void Parameters::closeReadsFiles() {
-    for (uint imate=0; imate<readFilesIn.size(); imate++) {//open readIn files
+    for (uint imate=0; imate<readFilesNames.size(); imate++) {//open readIn files
         if ( inOut->readIn[imate].is_open() )
             inOut->readIn[imate].close();
+        if (inOut->readInBuf[imate]!=NULL) {//restore the file buffer of the stream, stop decompression
+            inOut->readIn[imate].std::ios::rdbuf(inOut->readIn[imate].rdbuf());
+            delete inOut->readInBuf[imate];
+            inOut->readInBuf[imate]=NULL;
+        };
         if (readFilesCommandPID[imate]>0)
             kill(readFilesCommandPID[imate],SIGKILL);
     };
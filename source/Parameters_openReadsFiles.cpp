@@ -1,22 +1,31 @@
 #include "Parameters.h"
 #include "ErrorWarning.h"
+#include "ReadFilesStreambuf.h"
 #include <fstream>
 #include <sys/stat.h>
 void Parameters::openReadsFiles() 
 {
-    if (readFilesCommandString=="") {//read from file
-        for (uint ii=0;ii<readFilesIn.size();ii++) {//open readIn files
-            readFilesCommandPID[ii]=0;//no command process IDs
-            if ( inOut->readIn[ii].is_open() ) inOut->readIn[ii].close();
-
-            string rfName=readFilesPrefixFinal + readFilesIn.at(ii);
-
-            inOut->readIn[ii].open(rfName.c_str()); //try to open the Sequences file right away, exit if failed
-            if (inOut->readIn[ii].fail()) {
-                ostringstream errOut;
-                errOut <<"EXITING because of fatal input ERROR: could not open readFilesIn=" << rfName <<"\n";
-                exitWithError(errOut.str(), std::cerr, inOut->logMain, EXIT_CODE_PARAMETER, *this);
+    if (readFilesCommandString=="") {//read from files directly, decompress gzip/BGZF files natively
+        for (uint imate=0; imate<readFilesNames.size(); imate++) {//open readIn files
+            readFilesCommandPID[imate]=0;//no command process IDs
+            if ( inOut->readIn[imate].is_open() ) inOut->readIn[imate].close();
+
+            inOut->logMain << "\n   Input read files for mate "<< imate+1 <<" :\n";
+            for (auto &fn : readFilesNames[imate]) {
+                {//try to open the files - throw an error if a file cannot be opened
+                    ifstream rftry(fn.c_str());
+                    if (!rftry.good()){
+                        exitWithError("EXITING: because of fatal INPUT file error: could not open read file: " + fn + \
+                                      "\nSOLUTION: check that this file exists and has read permision.\n", \
+                                      std::cerr, inOut->logMain, EXIT_CODE_PARAMETER, *this);
+                    };
+                };
+                inOut->logMain << fn << " ; compression: " << ReadFilesStreambuf::fileCompressionName(fn) <<'\n';
             };
+
+            //multiple files are separated by the FILE markers, as with the readFilesCommand
+            inOut->readInBuf[imate] = new ReadFilesStreambuf(readFilesNames[imate], readFilesN>1, *this);
+            inOut->readIn[imate].std::ios::rdbuf(inOut->readInBuf[imate]);
         };
     } else {//create fifo files, execute pre-processing command
 
@@ -140,13 +140,19 @@ void Parameters::readFilesInit()
     inOut->logMain << "Number of fastq files for each mate = " << readFilesN << endl;
     
     readFilesCommandString="";
-    if (readFilesCommand.at(0)=="-") {
-        if (readFilesN>1)
-            readFilesCommandString="cat   ";//concatenate multiple files
+    string readFilesCommandJoined;
+    for (uint ii=0; ii<readFilesCommand.size(); ii++)
+        readFilesCommandJoined+=(ii>0 ? " " : "") + readFilesCommand.at(ii);
+    if (readFilesCommandJoined=="-" || readFilesCommandJoined=="zcat" || readFilesCommandJoined=="gzip -cd" || readFilesCommandJoined=="gzip -dc" || readFilesCommandJoined=="gunzip -c") {
+        //files are read and decompressed natively, the multiple files are concatenated
+        if (readFilesCommandJoined!="-")
+            inOut->logMain << "--readFilesCommand " << readFilesCommandJoined << " is replaced by the native decompression of the read files\n";
     } else {
         for (uint ii=0; ii<readFilesCommand.size(); ii++) 
             readFilesCommandString+=readFilesCommand.at(ii)+"   "; //concatenate into one string
     };    
+
+    readFilesDecompressThreadNactual = (readFilesDecompressThreadN==0 ? min(4, runThreadN) : readFilesDecompressThreadN);
     
     if (readFilesTypeN==1) {
         readNends=readFilesNames.size(); //for now the number of mates is defined by the number of input files
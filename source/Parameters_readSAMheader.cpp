@@ -1,16 +1,21 @@
 #include "Parameters.h"
 #include "ErrorWarning.h"
+#include "ReadFilesStreambuf.h"
 #include <fstream>
 #include <sys/stat.h>
 
 void Parameters::readSAMheader(const string readFilesCommandString, const vector<string> readFilesNames) {
 
-    if (readFilesCommandString=="") {//simply read from file
-        while (inOut->readIn[0].peek()=='@') {
-            string str1;
-            getline(inOut->readIn[0],str1);
-            if (str1.substr(1,2)!="HD" && str1.substr(1,2)!="SQ") {
-                samHeaderExtra += str1 + '\n';
+    if (readFilesCommandString=="") {//read from files directly: the header of each file is read through a separate stream
+        for (uint32 ii=0; ii<readFilesNames.size(); ii++) {
+            ReadFilesStreambuf headerBuf({readFilesNames.at(ii)}, false, *this);
+            istream headerIn(&headerBuf);
+            while (headerIn.peek()=='@') {
+                string str1;
+                getline(headerIn,str1);
+                if (str1.substr(1,2)!="HD" && str1.substr(1,2)!="SQ" && (!twoPass.pass2) ) {
+                    samHeaderExtra += str1 + '\n';
+                };
             };
         };
         return;
@@ -7,6 +7,9 @@ ReadAlign::ReadAlign (Parameters& Pin, Genome &genomeIn, Transcriptome *TrIn, in
                     : mapGen(genomeIn), genOut(*genomeIn.genomeOut.g), P(Pin), chunkTr(TrIn)
 {
     readNmates=P.readNmates; //not readNends
+    readInChunk=NULL;
+    readInChunkReads=NULL;
+    iReadChunk=0;
     //RNGs
     rngMultOrder.seed(P.runRNGseed*(iChunk+1));
     rngUniformReal0to1=std::uniform_real_distribution<double> (0.0, 1.0);
@@ -26,6 +29,8 @@ ReadAlign::ReadAlign (Parameters& Pin, Genome &genomeIn, Transcriptome *TrIn, in
         //split
         splitR=new uint*[3];
         splitR[0]=new uint[P.maxNsplit]; splitR[1]=new uint[P.maxNsplit]; splitR[2]=new uint[P.maxNsplit];
+        seedSAiPrefix[0]=new SeedSAiPrefix[DEF_readSeqLengthMax+1]; seedSAiPrefix[1]=new SeedSAiPrefix[DEF_readSeqLengthMax+1];
+        seedBatch = P.seedSearchBatch.yes ? new SuffixArraySearchBatch(mapGen) : NULL;
         //alignments
         PC=new uiPC[P.seedPerReadNmax];
         WC=new uiWC[P.alignWindowsPerReadNmax];
@@ -15,6 +15,8 @@
 #include "ReadAnnotations.h"
 #include "SpliceGraph.h"
 #include "ClipMate.h"
+#include "ChunkInQueue.h"
+#include "SuffixArraySearchBatch.h"
 
 #include <time.h>
 #include <random>
@@ -31,7 +33,10 @@ class ReadAlign {
 
         Stats statsRA; //mapping statistics
 
-        istream* readInStream[MAX_N_MATES];
+        istream* readInStream[MAX_N_MATES]; //text input, used for the 2nd stage of the BySJout filtering
+        char **readInChunk; //chunk arrays of the input reads, indexed by readInChunkReads
+        vector<ChunkInRead> *readInChunkReads; //read index for each mate, NULL if the reads are loaded from readInStream
+        uint64 iReadChunk; //next read to load from the chunk
         BAMoutput *outBAMcoord, *outBAMunsorted, *outBAMquant;//sorted by coordinate, unsorted, transcriptomic BAM structure
         fstream chunkOutChimSAM, *chunkOutChimJunction, chunkOutUnmappedReadsStream[MAX_N_MATES], chunkOutFilterBySJoutFiles[MAX_N_MATES];
         OutSJ *chunkOutSJ, *chunkOutSJ1;
@@ -134,6 +139,27 @@ class ReadAlign {
         //split
         uint** splitR;
         uint Nsplit;
+        struct SeedSAiPrefix {//SAi prefix starting at a read position
+            uint64 ind; //gSAindexNbases bases, 2 bits per base
+            uint64 nGood; //number of A/C/G/T bases in the prefix, up to gSAindexNbases
+        };
+        SeedSAiPrefix *seedSAiPrefix[2]; //for each read position: [0] forward, [1] reverse direction
+
+        //batched seed search, --seedSearchBatch
+        SuffixArraySearchBatch *seedBatch;
+        struct SeedChain {//sequence of seeds mapped one after another from one start position of a read piece
+            uint ip, iDir, istart, Lstart, Lmapped;
+            bool fixedLength; //one seed of length seedSearchLmax
+            bool done, firstSeedDone, flagDirMap;
+            uint chainDirMap; //for the reverse direction 1st start: the chain that defines whether this chain is needed
+            vector <uint> seeds;
+        };
+        struct SeedBatch {//one seed: start, length and its searches
+            uint pieceStart, pieceLength, iDir, iFrag, iChain, searchStart, nDist;
+        };
+        vector <SeedChain> seedChains;
+        vector <SeedBatch> seedSeeds;
+        vector <SuffixArraySearchBatch::Search> seedSearches;
 
 //         uint fragLength[MAX_N_FRAG], fragStart[MAX_N_FRAG]; //fragment Lengths and Starts in read space
 
@@ -185,8 +211,14 @@ class ReadAlign {
         void resetN();//resets the counters to 0
         void multMapSelect();
         int mapOneRead();
+        int mapOneReadStitch();
         void mapOneReadSpliceGraph();
-        uint maxMappableLength2strands(uint pieceStart, uint pieceLength, uint iDir, uint iSA1, uint iSA2, uint& maxL, uint iFrag);
+        uint maxMappableLength2strands(uint pieceStart, uint pieceLength, uint iDir, uint& maxL, uint iFrag);
+        void seedSearchStart(uint pieceStartIn, uint pieceLengthIn, uint iDir, uint iDist, SuffixArraySearchBatch::Search &searchOut);
+        uint seedSearchStore(uint pieceStartIn, uint iDir, uint nDist, SuffixArraySearchBatch::Search *searchAll, uint iFrag);
+        void seedSearchBatch(uint seedSearchStartLmax);
+        void seedSAindexCalc(); //SAi prefixes for all read positions
+        void seedSAindexPrefetch(uint seedSearchStartLmax); //prefetch SAi for the first seeds of the pieces
         void storeAligns (uint iDir, uint Shift, uint Nrep, uint L, uint indStartEnd[2], uint iFrag);
 
         bool outputTranscript(Transcript *trOut, uint nTrOut, ofstream *outBED);
@@ -18,15 +18,15 @@ ReadAlignChunk::ReadAlignChunk(Parameters& Pin, Genome &genomeIn, Transcriptome
     RA->iRead=0;
 
     chunkIn=new char* [P.readNends];
-    readInStream=new istringstream* [P.readNends];
     
     for (uint ii=0;ii<P.readNends;ii++) {
        chunkIn[ii]=new char[P.chunkInSizeBytesArray];//reserve more space to finish loading one read
        memset(chunkIn[ii],'\n',P.chunkInSizeBytesArray);
-       readInStream[ii] = new istringstream;
-       readInStream[ii]->rdbuf()->pubsetbuf(chunkIn[ii],P.chunkInSizeBytesArray);
-       RA->readInStream[ii]=readInStream[ii];
+       RA->readInStream[ii]=NULL;
     };
+    //reads are loaded directly from the chunk arrays, using the read index
+    RA->readInChunk=chunkIn;
+    RA->readInChunkReads=chunkInReads;
 
 
     if (P.outSAMbool) {
@@ -63,6 +63,8 @@ ReadAlignChunk::ReadAlignChunk(Parameters& Pin, Genome &genomeIn, Transcriptome
         RA->outBAMquant=NULL;
     };
 
+    sjTable=NULL;//set by the caller, shared by all chunks
+    sjTable1=NULL;
     if (P.outSJ.yes) {
         chunkOutSJ  = new OutSJ (P.limitOutSJcollapsed, P, mapGen);
         RA->chunkOutSJ  = chunkOutSJ;
@@ -17,15 +17,16 @@ public:
     Transcriptome *chunkTr;
 
     char **chunkIn; //space for the chunk of input reads
+    vector<ChunkInRead> chunkInReads[MAX_N_MATES]; //index of the reads in chunkIn
     array<uint64, MAX_N_MATES> chunkInSizeBytesTotal;    
     
     char *chunkOutBAM, *chunkOutBAM1;//space for the chunk of output SAM
     OutSJ *chunkOutSJ, *chunkOutSJ1;
+    OutSJtable *sjTable, *sjTable1;//junctions from all chunks
 
     BAMoutput *chunkOutBAMcoord, *chunkOutBAMunsorted, *chunkOutBAMquant;
     Quantifications *chunkQuants;
     
-    istringstream** readInStream;
     ostringstream*  chunkOutBAMstream;
     ofstream chunkOutBAMfile;
     string chunkOutBAMfileName;
@@ -34,6 +35,7 @@ public:
     uint iChunkIn; //current chunk # as read from .fastq
     uint iChunkOutSAM; //current chunk # writtedn to Aligned.out.sam
     int iThread; //current thread
+    vector <int> threadCPUs; //CPUs the thread processing this chunk is pinned to, empty: not pinned
     uint chunkOutBAMtotal; //total number of bytes in the write buffer
 
     ReadAlignChunk(Parameters& Pin, Genome &genomeIn, Transcriptome *TrIn, int iChunk);
@@ -4,7 +4,7 @@
 #include "ErrorWarning.h"
 #include SAMTOOLS_BGZF_H
 
-void ReadAlignChunk::mapChunk() {//map one chunk. Input reads stream has to be setup in RA->readInStream[ii]
+void ReadAlignChunk::mapChunk() {//map one chunk. Input reads have to be setup in RA->readInChunkReads, or in RA->readInStream[ii]
     
     for (uint32 im=0; im<1; im++) {//hardcoded mate 1 5p onyl for now
         RA->clipMates[im][0].clipChunk(chunkIn[im], chunkInSizeBytesTotal[im]);
@@ -12,10 +12,13 @@ void ReadAlignChunk::mapChunk() {//map one chunk. Input reads stream has to be s
     
     RA->statsRA.resetN();
 
-    for (uint ii=0;ii<P.readNends;ii++) {//clear eof and rewind the input streams
-        RA->readInStream[ii]->clear();
-        RA->readInStream[ii]->seekg(0,ios::beg);
+    if (RA->readInChunkReads==NULL) {//clear eof and rewind the input streams
+        for (uint ii=0;ii<P.readNends;ii++) {
+            RA->readInStream[ii]->clear();
+            RA->readInStream[ii]->seekg(0,ios::beg);
+        };
     };
+    RA->iReadChunk=0;
     
     
 
@@ -73,16 +76,8 @@ void ReadAlignChunk::mapChunk() {//map one chunk. Input reads stream has to be s
             exitWithError(errOut.str(),std::cerr, P.inOut->logMain, EXIT_CODE_INPUT_FILES, P);
         } else if ( chunkOutSJ->N + P.limitOutSJoneRead > chunkOutSJ->Nstore || (readStatus==-1 && noReadsLeft) ) {//write buffer to disk because it's almost full, or all reads are mapped
             chunkOutSJ->collapseSJ();
-            if ( chunkOutSJ->N + 2*P.limitOutSJoneRead > chunkOutSJ->Nstore ) {
-                /*
-                ostringstream errOut;
-                errOut <<"EXITING because of fatal error: buffer size for SJ output is too small\n";
-                errOut <<"Solution: increase input parameter --limitOutSJcollapsed\n";
-                exitWithError(errOut.str(),std::cerr, P.inOut->logMain, EXIT_CODE_INPUT_FILES, P);
-                */
-                chunkOutSJ->dataSizeIncrease();
-                P.inOut->logMain << "Increased the size of chunkOutSJ to " << chunkOutSJ->Nstore <<'\n';
-            };
+            if ( chunkOutSJ->N + 2*P.limitOutSJoneRead > chunkOutSJ->Nstore || (readStatus==-1 && noReadsLeft) ) //move the collapsed junctions into the table shared by all chunks
+                sjTable->insert(*chunkOutSJ);
         };
 
         //collapse SJ1 buffer if needed
@@ -95,16 +90,8 @@ void ReadAlignChunk::mapChunk() {//map one chunk. Input reads stream has to be s
             exitWithError(errOut.str(),std::cerr, P.inOut->logMain, EXIT_CODE_INPUT_FILES, P);
         } else if ( chunkOutSJ1->N + P.limitOutSJoneRead > chunkOutSJ->Nstore || (readStatus==-1 && noReadsLeft) ) {//write buffer to disk because it's almost full, or all reads are mapped
             chunkOutSJ1->collapseSJ();
-            if ( chunkOutSJ1->N + 2*P.limitOutSJoneRead > chunkOutSJ->Nstore ) {
-                /*
-                ostringstream errOut;
-                errOut <<"EXITING because of fatal error: buffer size for SJ output is too small\n";
-                errOut <<"Solution: increase input parameter --limitOutSJcollapsed\n";
-                exitWithError(errOut.str(),std::cerr, P.inOut->logMain, EXIT_CODE_INPUT_FILES, P);
-                */
-                chunkOutSJ->dataSizeIncrease();
-                P.inOut->logMain << "Increased the size of chunkOutSJ to " << chunkOutSJ->Nstore <<'\n';
-            };
+            if ( chunkOutSJ1->N + 2*P.limitOutSJoneRead > chunkOutSJ->Nstore || (readStatus==-1 && noReadsLeft) ) //move the collapsed junctions into the table shared by all chunks
+                sjTable1->insert(*chunkOutSJ1);
         };
 
     }; //reads cycle
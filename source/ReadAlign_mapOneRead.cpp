@@ -15,6 +15,7 @@ int ReadAlign::mapOneRead() {
 
     if (Lread>0) {
         Nsplit=qualitySplit(Read1[0], Lread, P.maxNsplit, P.seedSplitMin, splitR);
+        seedSAindexCalc();
         // splitR[0][fragnum] => good region start position   (from SequenceFuns.cpp)
         // splitR[1][fragnum] => good reagion length
         // splitR[2][fragnum] => fragnum ?
@@ -40,6 +41,12 @@ int ReadAlign::mapOneRead() {
 
     uint seedSearchStartLmax=min(P.seedSearchStartLmax, // 50
                                   (uint) (P.seedSearchStartLmaxOverLread*(Lread-1))); // read length
+    seedSAindexPrefetch(seedSearchStartLmax);
+    if (P.seedSearchBatch.yes) {//interleaved searches of all seeds, replaces the sequential loop below
+        seedSearchBatch(seedSearchStartLmax);
+        return mapOneReadStitch();
+    };
+
     // align all good pieces
     for (uint ip=0; ip<Nsplit; ip++) {
 
@@ -70,7 +77,7 @@ int ReadAlign::mapOneRead() {
 
                         //uint seedLength=min(splitR[1][ip] - Lmapped - istart*Lstart, P.seedSearchLmax);
                         uint seedLength=splitR[1][ip] - Lmapped - istart*Lstart; // what's left of the read to align.
-                        maxMappableLength2strands(Shift, seedLength, iDir, 0, mapGen.nSA-1, L, splitR[2][ip]);//L=max mappable length, unique or multiple
+                        maxMappableLength2strands(Shift, seedLength, iDir, L, splitR[2][ip]);//L=max mappable length, unique or multiple
                         if (iDir==0 && istart==0 && Lmapped==0 && Shift+L == splitR[1][ip] ) {//this piece maps full length and does not need to be mapped from the opposite direction
                             flagDirMap=false;
                         };
@@ -83,7 +90,7 @@ int ReadAlign::mapOneRead() {
                     uint Shift = iDir==0 ? ( splitR[0][ip] + istart*Lstart ) : \
                                    ( splitR[0][ip] + splitR[1][ip] - istart*Lstart-1); //choose Shift for forward or reverse
                     uint seedLength = min(P.seedSearchLmax, iDir==0 ? (splitR[0][ip] + splitR[1][ip]-Shift):(Shift+1) );
-                    maxMappableLength2strands(Shift, seedLength, iDir, 0, mapGen.nSA-1, L, splitR[2][ip]);//L=max mappable length, unique or multiple
+                    maxMappableLength2strands(Shift, seedLength, iDir, L, splitR[2][ip]);//L=max mappable length, unique or multiple
                 };
 
 
@@ -92,6 +99,11 @@ int ReadAlign::mapOneRead() {
         };
     };
 
+    return mapOneReadStitch();
+};
+
+int ReadAlign::mapOneReadStitch() {//after the seed search: mark unmappable reads, or stitch the seeds
+
     #ifdef OFF_AFTER_SEEDING
         #warning OFF_AFTER_SEEDING
         return 0;
@@ -2,114 +2,137 @@
 #include "SuffixArrayFuns.h"
 #include "ErrorWarning.h"
 
-uint ReadAlign::maxMappableLength2strands(uint pieceStartIn, uint pieceLengthIn, uint iDir, uint iSA1, uint iSA2, uint& maxLbest, uint iFrag) {
+uint ReadAlign::maxMappableLength2strands(uint pieceStartIn, uint pieceLengthIn, uint iDir, uint& maxLbest, uint iFrag) {
     //returns number of mappings, maxMappedLength=mapped length
-    uint Nrep=0, indStartEnd[2], maxL;
+    uint nDist=min(pieceLengthIn,P.pGe.gSAsparseD);
+    SuffixArraySearchBatch::Search searchAll[P.pGe.gSAsparseD];
 
-    uint NrepAll[P.pGe.gSAsparseD], indStartEndAll[P.pGe.gSAsparseD][2], maxLall[P.pGe.gSAsparseD];
-    maxLbest=0;
+    for (uint iDist=0; iDist<nDist; iDist++) {//cycle through different distances
+        seedSearchStart(pieceStartIn, pieceLengthIn, iDir, iDist, searchAll[iDist]);
+        if (!searchAll[iDist].done)
+            SuffixArraySearchBatch::searchOne(mapGen, searchAll[iDist]);
+    };
+
+    maxLbest=seedSearchStore(pieceStartIn, iDir, nDist, searchAll, iFrag);
+    return searchAll[nDist-1].Nrep;
+};
 
+void ReadAlign::seedSearchStart(uint pieceStartIn, uint pieceLengthIn, uint iDir, uint iDist, SuffixArraySearchBatch::Search &searchOut) {
+    //SAi look-up for the seed starting at iDist from pieceStartIn: defines SA search range, or finds the alignments if SA search is not needed
+    uint iSA1=0, iSA2=mapGen.nSA-1; //full SA range, narrowed by the SAi look-up
     bool dirR = iDir==0;
 
     // defaults:  (from genomeParameters.txt)
     // gSAsparseD = 1
     // gSAindexNbases = 14
 
-    for (uint iDist=0; iDist<min(pieceLengthIn,P.pGe.gSAsparseD); iDist++) {//cycle through different distances
-        uint pieceStart;
-        uint pieceLength=pieceLengthIn-iDist;
+    uint pieceStart;
+    uint pieceLength=pieceLengthIn-iDist;
 
-        //calculate full index
-        uint Lmax=min(P.pGe.gSAindexNbases,pieceLength);
-        uint ind1=0;
-        if (dirR) {//forward search
-            pieceStart=pieceStartIn+iDist;
-            for (uint ii=0;ii<Lmax;ii++) {//calculate index TODO: make the index calculation once for the whole read and store it
-                ind1 <<=2LLU;
-                ind1 += ((uint) Read1[0][pieceStart+ii]);
-            };
-        } else {//reverse search
-            pieceStart=pieceStartIn-iDist;
-            for (uint ii=0;ii<Lmax;ii++) {//calculate index TODO: make the index calculation once for the whole read and store it
-                ind1 <<=2LLU;
-                ind1 += ( 3-((uint) Read1[0][pieceStart-ii]) );
-            };
+    //full index: precomputed for the read in seedSAindexCalc
+    uint Lmax=min(P.pGe.gSAindexNbases,pieceLength);
+    uint ind1=0;
+    pieceStart = dirR ? pieceStartIn+iDist : pieceStartIn-iDist;
+    SeedSAiPrefix &pre = seedSAiPrefix[iDir][pieceStart];
+    if (pre.nGood>=Lmax) {
+        ind1 = pre.ind >> (2*(P.pGe.gSAindexNbases-Lmax));
+    } else if (dirR) {//forward search, the seed extends into non-ACGT bases
+        for (uint ii=0;ii<Lmax;ii++) {
+            ind1 <<=2LLU;
+            ind1 += ((uint) Read1[0][pieceStart+ii]);
+        };
+    } else {//reverse search, the seed extends into non-ACGT bases
+        for (uint ii=0;ii<Lmax;ii++) {
+            ind1 <<=2LLU;
+            ind1 += ( 3-((uint) Read1[0][pieceStart-ii]) );
         };
+    };
 
-        //find SA boundaries
-        uint Lind=Lmax;
-        while (Lind>0) {//check the presence of the prefix for Lind
-            iSA1=mapGen.SAi[mapGen.genomeSAindexStart[Lind-1]+ind1]; // starting point for suffix array search.
-            if ((iSA1 & mapGen.SAiMarkAbsentMaskC) == 0) {//prefix exists
-                break;
-            } else {//this prefix does not exist, reduce Lind
-                --Lind;
-                ind1 = ind1 >> 2;
-            };
+    //find SA boundaries
+    uint Lind=Lmax;
+    while (Lind>0) {//check the presence of the prefix for Lind
+        iSA1=mapGen.SAi[mapGen.genomeSAindexStart[Lind-1]+ind1]; // starting point for suffix array search.
+        if ((iSA1 & mapGen.SAiMarkAbsentMaskC) == 0) {//prefix exists
+            break;
+        } else {//this prefix does not exist, reduce Lind
+            --Lind;
+            ind1 = ind1 >> 2;
         };
+    };
 
-        // define upper bound for suffix array range search.
-        bool iSA2good = true;
-        if (mapGen.genomeSAindexStart[Lind-1]+ind1+1 < mapGen.genomeSAindexStart[Lind]) {//we are not at the end of the SA
-            iSA2 = mapGen.SAi[mapGen.genomeSAindexStart[Lind-1]+ind1+1];
-            if ( (iSA2 & mapGen.SAiMarkAbsentMaskC) == 0) {
-                iSA2 = (iSA2 & mapGen.SAiMarkNmask) - 1;
-            } else {
-                iSA2 = mapGen.nSA-1; //safe, but can probably do better
-                iSA2good = false;
-            };
+    // define upper bound for suffix array range search.
+    bool iSA2good = true;
+    if (mapGen.genomeSAindexStart[Lind-1]+ind1+1 < mapGen.genomeSAindexStart[Lind]) {//we are not at the end of the SA
+        iSA2 = mapGen.SAi[mapGen.genomeSAindexStart[Lind-1]+ind1+1];
+        if ( (iSA2 & mapGen.SAiMarkAbsentMaskC) == 0) {
+            iSA2 = (iSA2 & mapGen.SAiMarkNmask) - 1;
         } else {
-            iSA2=mapGen.nSA-1;
+            iSA2 = mapGen.nSA-1; //safe, but can probably do better
             iSA2good = false;
         };
+    } else {
+        iSA2=mapGen.nSA-1;
+        iSA2good = false;
+    };
+
+    searchOut.s=Read1;
+    searchOut.S=pieceStart;
+    searchOut.N=pieceLength;
+    searchOut.dirR=dirR;
+    searchOut.done=false;
+    searchOut.unique=false;
 
     //#define SA_SEARCH_FULL
 
     #ifdef SA_SEARCH_FULL
         //full search of the array even if the index search gave maxL
-        maxL=0;
-        Nrep = maxMappableLength(mapGen, Read1, pieceStart, pieceLength, iSA1 & mapGen.SAiMarkNmask, iSA2, dirR, maxL, indStartEnd);
+        searchOut.L=0;
+        searchOut.i1=iSA1 & mapGen.SAiMarkNmask;
+        searchOut.i2=iSA2;
     #else
         bool iSA1noN = (iSA1 & mapGen.SAiMarkNmaskC)==0;
         if (Lind < P.pGe.gSAindexNbases && iSA1noN && iSA2good) {//no need for SA search
             // very short seq, already found hits in suffix array w/o having to search the genome for extensions.
-            indStartEnd[0]=iSA1;
-            indStartEnd[1]=iSA2;
-            Nrep=indStartEnd[1]-indStartEnd[0]+1;
-            maxL=Lind;
+            searchOut.indStartEnd[0]=iSA1;
+            searchOut.indStartEnd[1]=iSA2;
+            searchOut.Nrep=iSA2-iSA1+1;
+            searchOut.L=Lind;
+            searchOut.done=true;
         } else if (iSA1==iSA2 && iSA1noN && iSA2good) {//unique align already, just find maxL
             if ((iSA1 & mapGen.SAiMarkNmaskC)!=0) {
                 ostringstream errOut;
                 errOut  << "BUG: in ReadAlign::maxMappableLength2strands";
                 exitWithError(errOut.str(), std::cerr, P.inOut->logMain, EXIT_CODE_BUG, P);
             };
-            indStartEnd[0]=indStartEnd[1]=iSA1;
-            Nrep=1;
-            bool comparRes;
-            maxL=compareSeqToGenome(mapGen, Read1, pieceStart, pieceLength, Lind, iSA1, dirR, comparRes);
+            searchOut.unique=true;
+            searchOut.i1=searchOut.i2=iSA1;
+            searchOut.L=Lind;
         } else {//need SA search, pieceLength>maxL
             if (iSA2good && iSA1noN) {
-                maxL = Lind; //Lind bases were already matched
+                searchOut.L = Lind; //Lind bases were already matched
             } else {
-                maxL=0;
-            };        
-            Nrep = maxMappableLength(mapGen, Read1, pieceStart, pieceLength, iSA1 & mapGen.SAiMarkNmask, iSA2, dirR, maxL, indStartEnd);
+                searchOut.L=0;
+            };
+            searchOut.i1=iSA1 & mapGen.SAiMarkNmask;
+            searchOut.i2=iSA2;
         };
     #endif
+};
 
-        if (maxL+iDist > maxLbest) {//this idist is better
-            maxLbest=maxL+iDist;
+uint ReadAlign::seedSearchStore(uint pieceStartIn, uint iDir, uint nDist, SuffixArraySearchBatch::Search *searchAll, uint iFrag) {
+    //store the alignments of the distances with the largest maxL, returns the largest maxL
+    uint maxLbest=0;
+    for (uint iDist=0; iDist<nDist; iDist++) {
+        if (searchAll[iDist].L+iDist > maxLbest) {//this idist is better
+            maxLbest=searchAll[iDist].L+iDist;
         };
-        NrepAll[iDist]=Nrep;
-        indStartEndAll[iDist][0]=indStartEnd[0];
-        indStartEndAll[iDist][1]=indStartEnd[1];
-        maxLall[iDist]=maxL;
     };
 
-    for (uint iDist=0; iDist<min(pieceLengthIn,P.pGe.gSAsparseD); iDist++) {//cycle through different distances, store the ones with largest maxL
-        if ( (maxLall[iDist]+iDist) == maxLbest) {
-            storeAligns(iDir, (dirR ? pieceStartIn+iDist : pieceStartIn-iDist), NrepAll[iDist], maxLall[iDist], indStartEndAll[iDist], iFrag);
+    bool dirR = iDir==0;
+    for (uint iDist=0; iDist<nDist; iDist++) {//cycle through different distances, store the ones with largest maxL
+        if ( (searchAll[iDist].L+iDist) == maxLbest) {
+            storeAligns(iDir, (dirR ? pieceStartIn+iDist : pieceStartIn-iDist), searchAll[iDist].Nrep, searchAll[iDist].L, searchAll[iDist].indStartEnd, iFrag);
         };
     };
-    return Nrep;
+    return maxLbest;
 };
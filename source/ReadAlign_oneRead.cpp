@@ -11,7 +11,13 @@ int ReadAlign::oneRead() {//process one read: load, map, write
     int readStatus[P.readNends];
 
     for (uint32 im=0; im<P.readNends; im++) {
-        readStatus[im] = readLoad(*(readInStream[im]), P, readLength[im], readLengthOriginal[im], readNameMates[im], Read0[im], Read1[im], Qual0[im], clipMates[im], iReadAll, readFilesIndex, readFilter, readNameExtra[im]);
+        if (readInChunkReads==NULL) {//text stream
+            readStatus[im] = readLoad(*(readInStream[im]), P, readLength[im], readLengthOriginal[im], readNameMates[im], Read0[im], Read1[im], Qual0[im], clipMates[im], iReadAll, readFilesIndex, readFilter, readNameExtra[im]);
+        } else if (iReadChunk < readInChunkReads[im].size()) {//indexed chunk
+            readStatus[im] = readLoad(readInChunk[im], readInChunkReads[im][iReadChunk], P, readLength[im], readLengthOriginal[im], readNameMates[im], Read0[im], Read1[im], Qual0[im], clipMates[im], iReadAll, readFilesIndex, readFilter, readNameExtra[im]);
+        } else {
+            readStatus[im] = -1; //end of the chunk
+        };
         if (readStatus[im] != readStatus[0]) {//check if the end of file was reached or not for all files
             ostringstream errOut;
             errOut << "EXITING because of FATAL ERROR: read files are not consistent, reached the end of the one before the other one\n";
@@ -23,6 +29,7 @@ int ReadAlign::oneRead() {//process one read: load, map, write
     if (readStatus[0]==-1) {//finished with the stream
         return -1;
     };    
+    iReadChunk++;
     
     if (P.outFilterBySJoutStage != 2) {
         for (uint32 im=0; im<P.readNmates; im++) {//not readNends: the barcode quality will be calculated separately
@@ -0,0 +1,46 @@
+#include "ReadAlign.h"
+
+void ReadAlign::seedSAindexCalc()
+{//SAi prefixes at all read positions, calculated once per read with a rolling 2-bit hash
+ //forward: bases p...p+Nbases-1; reverse: complementary bases p...p-Nbases+1; the 1st base is in the highest bits
+ //prefixes shorter than gSAindexNbases are obtained by shifting out the lowest bits
+    uint64 nB=P.pGe.gSAindexNbases;
+    uint64 shift1=2*(nB-1);
+
+    uint64 ind=0, nGood=0;
+    for (uint64 ii=Lread; ii>0; ii--) {//forward, bases after the end of the read are 0
+        uint64 b=(uint64) Read1[0][ii-1];
+        ind = (ind>>2) | ((b&3LLU)<<shift1);
+        nGood = b<4 ? min(nGood+1,nB) : 0;
+        seedSAiPrefix[0][ii-1]={ind, nGood};
+    };
+
+    ind=0; nGood=0;
+    for (uint64 ii=0; ii<Lread; ii++) {//reverse, bases before the start of the read are 0
+        uint64 b=(uint64) Read1[0][ii];
+        ind = (ind>>2) | (((3LLU-b)&3LLU)<<shift1);
+        nGood = b<4 ? min(nGood+1,nB) : 0;
+        seedSAiPrefix[1][ii]={ind, nGood};
+    };
+};
+
+void ReadAlign::seedSAindexPrefetch(uint seedSearchStartLmax)
+{//prefetch SAi entries for the first seeds from all start positions of all pieces, so that the SAi look-ups of the seed search do not stall
+    uint64 nB=P.pGe.gSAindexNbases;
+    for (uint ip=0; ip<Nsplit; ip++) {
+        uint Nstart = P.seedSearchStartLmax>0 && seedSearchStartLmax<splitR[1][ip] ? splitR[1][ip]/seedSearchStartLmax+1 : 1;
+        uint Lstart = splitR[1][ip]/Nstart;
+        for (uint iDir=0; iDir<2; iDir++) {
+            for (uint istart=0; istart<Nstart; istart++) {
+                uint pieceStart = iDir==0 ? splitR[0][ip] + istart*Lstart : splitR[0][ip] + splitR[1][ip] - istart*Lstart-1;
+                uint pieceLength = splitR[1][ip] - istart*Lstart;
+                for (uint iDist=0; iDist<min(pieceLength,P.pGe.gSAsparseD); iDist++) {
+                    uint64 Lmax=min(nB, (uint64) pieceLength-iDist);
+                    SeedSAiPrefix &pre = seedSAiPrefix[iDir][iDir==0 ? pieceStart+iDist : pieceStart-iDist];
+                    uint64 iSAi = mapGen.genomeSAindexStart[Lmax-1] + (pre.ind>>(2*(nB-Lmax)));
+                    __builtin_prefetch(mapGen.SAi.charArray + iSAi*mapGen.SAi.wordLength/8);
+                };
+            };
+        };
+    };
+};
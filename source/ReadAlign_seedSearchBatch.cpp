@@ -0,0 +1,118 @@
+#include "ReadAlign.h"
+
+void ReadAlign::seedSearchBatch(uint seedSearchStartLmax) {
+    //same seeds as the sequential seed search in mapOneRead, but the suffix array searches of independent chains of seeds are interleaved
+    //seeds within each chain depend on the previous seed and are searched one after another
+    //the alignments are stored in the same order as in the sequential search
+
+    //chains in the order of the sequential search
+    uint nChains=0;
+    for (uint ip=0; ip<Nsplit; ip++) {
+        uint Nstart = P.seedSearchStartLmax>0 && seedSearchStartLmax<splitR[1][ip] ? splitR[1][ip]/seedSearchStartLmax+1 : 1;
+        uint Lstart = splitR[1][ip]/Nstart;
+        uint chainDirMap=nChains; //1st start in the forward direction
+
+        for (uint iDir=0; iDir<2; iDir++) {
+            for (uint istart=0; istart<Nstart; istart++) {
+                for (uint ifix=0; ifix < (P.seedSearchLmax>0 ? 2LLU : 1LLU); ifix++) {
+                    if (nChains==seedChains.size())
+                        seedChains.resize(nChains+1);
+                    SeedChain &ch=seedChains[nChains];
+                    ch.ip=ip;
+                    ch.iDir=iDir;
+                    ch.istart=istart;
+                    ch.Lstart=Lstart;
+                    ch.Lmapped=0;
+                    ch.fixedLength = ifix==1;
+                    ch.done=false;
+                    ch.firstSeedDone=false;
+                    ch.flagDirMap=true;
+                    ch.chainDirMap = (iDir==1 && istart==0 && ifix==0) ? chainDirMap : (uint) -1;
+                    ch.seeds.clear();
+                    ++nChains;
+                };
+            };
+        };
+    };
+
+    seedSeeds.clear();
+    seedSearches.clear();
+    while (true) {//each cycle adds the next seed of each chain
+        uint seedStart=seedSeeds.size();
+        uint searchStart=seedSearches.size();
+
+        for (uint ic=0; ic<nChains; ic++) {
+            SeedChain &ch=seedChains[ic];
+            if (ch.done)
+                continue;
+
+            uint ip=ch.ip;
+            uint pieceStart, pieceLength;
+            if (ch.fixedLength) {//search fixed length
+                if (ch.seeds.size()>0) {
+                    ch.done=true;
+                    continue;
+                };
+                pieceStart = ch.iDir==0 ? ( splitR[0][ip] + ch.istart*ch.Lstart ) : \
+                                          ( splitR[0][ip] + splitR[1][ip] - ch.istart*ch.Lstart-1);
+                pieceLength = min(P.seedSearchLmax, ch.iDir==0 ? (splitR[0][ip] + splitR[1][ip]-pieceStart):(pieceStart+1) );
+            } else {
+                if (ch.chainDirMap != (uint) -1) {//check if the 1st piece in reverse direction needs to be mapped
+                    SeedChain &ch0=seedChains[ch.chainDirMap];
+                    if (!ch0.firstSeedDone)
+                        continue; //wait for the 1st seed in the forward direction
+                    if (!ch0.flagDirMap) {
+                        ch.done=true;
+                        continue;
+                    };
+                    ch.chainDirMap=(uint) -1;
+                };
+
+                if ( ch.istart*ch.Lstart + ch.Lmapped + P.seedMapMin >= splitR[1][ip] ) {//the whole piece is mapped
+                    ch.done=true;
+                    ch.firstSeedDone=true;
+                    continue;
+                };
+                pieceStart = ch.iDir==0 ? ( splitR[0][ip] + ch.istart*ch.Lstart + ch.Lmapped ) : \
+                                          ( splitR[0][ip] + splitR[1][ip] - ch.istart*ch.Lstart-1-ch.Lmapped);
+                pieceLength = splitR[1][ip] - ch.Lmapped - ch.istart*ch.Lstart;
+            };
+
+            ch.seeds.push_back(seedSeeds.size());
+            seedSeeds.push_back({pieceStart, pieceLength, ch.iDir, splitR[2][ip], ic, (uint) seedSearches.size(), min(pieceLength,P.pGe.gSAsparseD)});
+            for (uint iDist=0; iDist<seedSeeds.back().nDist; iDist++) {
+                seedSearches.emplace_back();
+                seedSearchStart(pieceStart, pieceLength, ch.iDir, iDist, seedSearches.back());
+            };
+        };
+
+        if (seedSeeds.size()==seedStart)
+            break; //no new seeds: all chains are done
+
+        seedBatch->searchAll(seedSearches, searchStart);
+
+        for (uint is=seedStart; is<seedSeeds.size(); is++) {
+            SeedBatch &sd=seedSeeds[is];
+            SeedChain &ch=seedChains[sd.iChain];
+            if (ch.fixedLength)
+                continue;
+
+            uint L=0;
+            for (uint iDist=0; iDist<sd.nDist; iDist++)
+                L=max(L, seedSearches[sd.searchStart+iDist].L+iDist);
+
+            if (ch.iDir==0 && ch.istart==0 && ch.Lmapped==0 && sd.pieceStart+L == splitR[1][ch.ip] ) {//this piece maps full length and does not need to be mapped from the opposite direction
+                ch.flagDirMap=false;
+            };
+            ch.firstSeedDone=true;
+            ch.Lmapped+=L;
+        };
+    };
+
+    for (uint ic=0; ic<nChains; ic++) {//store the alignments in the order of the sequential search
+        for (auto &is : seedChains[ic].seeds) {
+            SeedBatch &sd=seedSeeds[is];
+            seedSearchStore(sd.pieceStart, sd.iDir, sd.nDist, seedSearches.data()+sd.searchStart, sd.iFrag);
+        };
+    };
+};
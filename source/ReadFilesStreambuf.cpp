@@ -0,0 +1,368 @@
+#include "ReadFilesStreambuf.h"
+#include "ErrorWarning.h"
+#include SAMTOOLS_BGZF_H
+#include <zlib.h>
+
+#define BGZF_HEADER_SIZE 18
+#define BGZF_FOOTER_SIZE 8
+
+ReadFilesStreambuf::ReadFilesStreambuf(const vector<string> &fileNamesIn, bool fileMarkersIn, Parameters &Pin)
+                   : P(Pin), fileNames(fileNamesIn), fileMarkers(fileMarkersIn)
+{
+    queueFull = new ChunkInQueue(READ_FILES_BUF_N);
+    queueFree = new ChunkInQueue(READ_FILES_BUF_N);
+    for (uint32 ib=0; ib<READ_FILES_BUF_N; ib++) {
+        bufAll[ib].data[0] = new char[READ_FILES_BUF_SIZE];
+        bufAll[ib].sizeBytes[0] = 0;
+        queueFree->pushWait(bufAll+ib);
+    };
+    bufGet=NULL;
+    bufPut=NULL;
+    eofReached=false;
+    stopRead=false;
+    setg(NULL,NULL,NULL);
+
+    inBuf = new char[READ_FILES_BUF_SIZE+BGZF_MAX_BLOCK_SIZE]; //a full decompressed buffer of input always fits
+
+    pthread_create(&threadDecompressPthread, NULL, threadDecompress, (void *) this);
+};
+
+ReadFilesStreambuf::~ReadFilesStreambuf()
+{
+    stopRead=true;
+    if (!eofReached) {//return buffers to the decompression thread until it sends the end marker
+        if (bufGet!=NULL)
+            queueFree->pushWait(bufGet);
+        while (true) {
+            ChunkIn *buf1=queueFull->popWait();
+            bool endMarker = (buf1->sizeBytes[0]==0);
+            queueFree->pushWait(buf1);
+            if (endMarker)
+                break;
+        };
+    };
+    pthread_join(threadDecompressPthread, NULL);
+
+    for (uint32 ib=0; ib<READ_FILES_BUF_N; ib++)
+        delete [] bufAll[ib].data[0];
+    delete [] inBuf;
+    delete queueFull;
+    delete queueFree;
+};
+
+std::streambuf::int_type ReadFilesStreambuf::underflow()
+{
+    if (gptr()<egptr())
+        return traits_type::to_int_type(*gptr());
+
+    if (eofReached)
+        return traits_type::eof();
+
+    if (bufGet!=NULL)
+        queueFree->pushWait(bufGet);
+
+    bufGet=queueFull->popWait();
+
+    if (bufGet->sizeBytes[0]==0) {//empty buffer marks the end of all files
+        eofReached=true;
+        queueFree->pushWait(bufGet);
+        bufGet=NULL;
+        setg(NULL,NULL,NULL);
+        return traits_type::eof();
+    };
+
+    setg(bufGet->data[0], bufGet->data[0], bufGet->data[0]+bufGet->sizeBytes[0]);
+    return traits_type::to_int_type(*gptr());
+};
+
+int ReadFilesStreambuf::fileCompression(const char *header, uint64 headerN)
+{
+    const uint8 *h=(const uint8*) header;
+    if (headerN<2 || h[0]!=31 || h[1]!=139)
+        return compressionNone;
+    //same check as in htslib: gzip header with the extra field that contains the BGZF block size
+    if (headerN>=BGZF_HEADER_SIZE && h[2]==8 && (h[3]&4)!=0 && h[10]==6 && h[11]==0 && h[12]=='B' && h[13]=='C' && h[14]==2 && h[15]==0)
+        return compressionBGZF;
+    return compressionGzip;
+};
+
+string ReadFilesStreambuf::fileCompressionName(const string &fileName)
+{
+    ifstream fileIn1(fileName.c_str(), ios::binary);
+    char header[BGZF_HEADER_SIZE];
+    fileIn1.read(header, BGZF_HEADER_SIZE);
+    switch (fileCompression(header, fileIn1.gcount())) {
+        case compressionBGZF:
+            return "BGZF";
+        case compressionGzip:
+            return "gzip";
+        default:
+            return "none";
+    };
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+void ReadFilesStreambuf::decompressAll()
+{
+    for (uint32 ifile=0; ifile<fileNames.size(); ifile++) {
+        if (fileMarkers) {
+            string marker="FILE " + to_string(ifile) + "\n";
+            bufPutWrite(marker.c_str(), marker.size());
+        };
+
+        fileIn.open(fileNames[ifile].c_str(), ios::binary);
+        if (fileIn.fail()) {
+            exitWithError("EXITING: because of fatal INPUT file error: could not open read file: " + fileNames[ifile] + \
+                          "\nSOLUTION: check that this file exists and has read permision.\n", \
+                          std::cerr, P.inOut->logMain, EXIT_CODE_PARAMETER, P);
+        };
+        inStart=0;
+        inEnd=0;
+        inFill(BGZF_HEADER_SIZE);
+
+        switch (fileCompression(inBuf, inEnd-inStart)) {
+            case compressionBGZF:
+                inflateBGZF(fileNames[ifile]);
+                break;
+            case compressionGzip:
+                inflateGzip(fileNames[ifile]);
+                break;
+            default:
+                copyPlain();
+        };
+
+        fileIn.close();
+        fileIn.clear();
+
+        if (stopRead)
+            break;
+    };
+
+    bufPutPush();
+    bufPutGet(); //send the empty buffer to mark the end of files
+    queueFull->pushWait(bufPut);
+    bufPut=NULL;
+};
+
+void ReadFilesStreambuf::bufPutGet()
+{
+    if (bufPut==NULL) {
+        bufPut=queueFree->popWait();
+        bufPut->sizeBytes[0]=0;
+    };
+};
+
+void ReadFilesStreambuf::bufPutPush()
+{
+    if (bufPut!=NULL && bufPut->sizeBytes[0]>0) {
+        queueFull->pushWait(bufPut);
+        bufPut=NULL;
+    };
+};
+
+void ReadFilesStreambuf::bufPutWrite(const char *data, uint64 dataN)
+{
+    while (dataN>0) {
+        bufPutGet();
+        uint64 n1=min(dataN, READ_FILES_BUF_SIZE-bufPut->sizeBytes[0]);
+        memcpy(bufPut->data[0]+bufPut->sizeBytes[0], data, n1);
+        bufPut->sizeBytes[0]+=n1;
+        data+=n1;
+        dataN-=n1;
+        if (bufPut->sizeBytes[0]==READ_FILES_BUF_SIZE)
+            bufPutPush();
+    };
+};
+
+uint64 ReadFilesStreambuf::inFill(uint64 bytesNeeded)
+{
+    if (inEnd-inStart>=bytesNeeded)
+        return inEnd-inStart;
+
+    if (inStart>0) {//move the remaining bytes to the start of the buffer
+        memmove(inBuf, inBuf+inStart, inEnd-inStart);
+        inEnd-=inStart;
+        inStart=0;
+    };
+
+    uint64 inBufSize=READ_FILES_BUF_SIZE+BGZF_MAX_BLOCK_SIZE;
+    if (inEnd<inBufSize && fileIn.good()) {
+        fileIn.read(inBuf+inEnd, inBufSize-inEnd);
+        inEnd+=fileIn.gcount();
+    };
+    return inEnd-inStart;
+};
+
+void ReadFilesStreambuf::copyPlain()
+{
+    bufPutWrite(inBuf+inStart, inEnd-inStart);
+    inStart=inEnd;
+    while (fileIn.good() && !stopRead) {
+        bufPutGet();
+        fileIn.read(bufPut->data[0]+bufPut->sizeBytes[0], READ_FILES_BUF_SIZE-bufPut->sizeBytes[0]);
+        bufPut->sizeBytes[0]+=fileIn.gcount();
+        if (bufPut->sizeBytes[0]==READ_FILES_BUF_SIZE)
+            bufPutPush();
+    };
+};
+
+void ReadFilesStreambuf::inflateGzip(const string &fileName)
+{//gzip file, possibly with multiple members, is inflated sequentially: plain gzip members do not record their compressed size,
+ //so member boundaries are only known after inflating, and only BGZF input is inflated in parallel
+    z_stream zs;
+    zs.zalloc=Z_NULL;
+    zs.zfree=Z_NULL;
+    zs.opaque=Z_NULL;
+    zs.next_in=Z_NULL;
+    zs.avail_in=0;
+    if (inflateInit2(&zs, 15+32)!=Z_OK) {
+        ostringstream errOut;
+        errOut << "EXITING because of FATAL ERROR: could not initialize gzip decompression for file " << fileName << " : " << (zs.msg==NULL ? "" : zs.msg) <<"\n";
+        errOut << "SOLUTION: check that enough RAM is available\n";
+        exitWithError(errOut.str(), std::cerr, P.inOut->logMain, EXIT_CODE_MEMORY_ALLOCATION, P);
+    };
+
+    bool memberOpen=false;
+    while (!stopRead) {
+        if (inFill(1)==0)
+            break; //end of file
+
+        bufPutGet();
+        zs.next_in=(Bytef*) (inBuf+inStart);
+        zs.avail_in=(uInt) (inEnd-inStart);
+        zs.next_out=(Bytef*) (bufPut->data[0]+bufPut->sizeBytes[0]);
+        zs.avail_out=(uInt) (READ_FILES_BUF_SIZE-bufPut->sizeBytes[0]);
+
+        int zret=inflate(&zs, Z_NO_FLUSH);
+        if (zret!=Z_OK && zret!=Z_STREAM_END && zret!=Z_BUF_ERROR) {
+            ostringstream errOut;
+            errOut << "EXITING because of FATAL INPUT FILE ERROR: could not decompress gzip file " << fileName << " : " << (zs.msg==NULL ? "" : zs.msg) <<"\n";
+            errOut << "SOLUTION: check the integrity of the file, e.g. with gzip -t\n";
+            exitWithError(errOut.str(), std::cerr, P.inOut->logMain, EXIT_CODE_INPUT_FILES, P);
+        };
+        memberOpen=true;
+        inStart=inEnd-zs.avail_in;
+        bufPut->sizeBytes[0]=READ_FILES_BUF_SIZE-zs.avail_out;
+
+        if (zret==Z_STREAM_END) {//next gzip member may follow
+            inflateReset(&zs);
+            memberOpen=false;
+        };
+        if (bufPut->sizeBytes[0]==READ_FILES_BUF_SIZE)
+            bufPutPush();
+    };
+    inflateEnd(&zs);
+
+    if (memberOpen && !stopRead) {
+        ostringstream errOut;
+        errOut << "EXITING because of FATAL INPUT FILE ERROR: unexpected end of gzip file " << fileName <<"\n";
+        errOut << "SOLUTION: check the integrity of the file, e.g. with gzip -t\n";
+        exitWithError(errOut.str(), std::cerr, P.inOut->logMain, EXIT_CODE_INPUT_FILES, P);
+    };
+};
+
+void ReadFilesStreambuf::inflateBGZF(const string &fileName)
+{//BGZF blocks are independent: inflate batches of complete blocks in parallel, directly into the decompressed buffer
+    vector <uint64> blockStart, blockOut;
+    vector <char> blockError;
+
+    while (!stopRead) {
+        bufPutGet();
+
+        //collect complete blocks that fit into the buffer
+        blockStart.clear();
+        blockOut.clear();
+        uint64 inPos=inStart, outPos=bufPut->sizeBytes[0];
+        bool inputShort=false;
+        while (true) {
+            if (inEnd-inPos<BGZF_HEADER_SIZE) {
+                inputShort = (inEnd>inPos);
+                break;
+            };
+            if (fileCompression(inBuf+inPos, BGZF_HEADER_SIZE)!=compressionBGZF) {
+                ostringstream errOut;
+                errOut << "EXITING because of FATAL INPUT FILE ERROR: wrong BGZF block header in file " << fileName <<"\n";
+                errOut << "SOLUTION: check the integrity of the file, e.g. with bgzip -t\n";
+                exitWithError(errOut.str(), std::cerr, P.inOut->logMain, EXIT_CODE_INPUT_FILES, P);
+            };
+            uint64 blockSize=(uint64) *((uint16*) (inBuf+inPos+16)) + 1;
+            if (blockSize<BGZF_HEADER_SIZE+BGZF_FOOTER_SIZE || inEnd-inPos<blockSize) {
+                inputShort=true;
+                break;
+            };
+            uint64 isize=(uint64) *((uint32*) (inBuf+inPos+blockSize-4));
+            if (isize>BGZF_MAX_BLOCK_SIZE) {
+                ostringstream errOut;
+                errOut << "EXITING because of FATAL INPUT FILE ERROR: wrong BGZF block size in file " << fileName <<"\n";
+                errOut << "SOLUTION: check the integrity of the file, e.g. with bgzip -t\n";
+                exitWithError(errOut.str(), std::cerr, P.inOut->logMain, EXIT_CODE_INPUT_FILES, P);
+            };
+            if (outPos+isize>READ_FILES_BUF_SIZE)
+                break;
+            blockStart.push_back(inPos);
+            blockOut.push_back(outPos);
+            inPos+=blockSize;
+            outPos+=isize;
+        };
+
+        if (blockStart.size()==0) {
+            if (inputShort || inStart==inEnd) {//need more input, or the end of file
+                uint64 inN=inEnd-inStart;
+                if (inFill(inN+1)==inN) {
+                    if (inN==0)
+                        break; //end of file at the block boundary
+                    ostringstream errOut;
+                    errOut << "EXITING because of FATAL INPUT FILE ERROR: unexpected end of BGZF file " << fileName <<"\n";
+                    errOut << "SOLUTION: check the integrity of the file, e.g. with bgzip -t\n";
+                    exitWithError(errOut.str(), std::cerr, P.inOut->logMain, EXIT_CODE_INPUT_FILES, P);
+                };
+            } else {//the buffer is full
+                bufPutPush();
+            };
+            continue;
+        };
+
+        blockError.assign(blockStart.size(), 0);
+        char *outBuf=bufPut->data[0];
+        #pragma omp parallel for num_threads(P.readFilesDecompressThreadNactual) schedule(dynamic,1)
+        for (uint64 ib=0; ib<blockStart.size(); ib++) {
+            char *blockIn=inBuf+blockStart[ib];
+            uint64 blockSize=(uint64) *((uint16*) (blockIn+16)) + 1;
+            uint32 isize=*((uint32*) (blockIn+blockSize-4));
+            uint32 crc=*((uint32*) (blockIn+blockSize-8));
+            if (isize==0) //empty block, e.g. BGZF EOF marker
+                continue;
+
+            z_stream zs;
+            zs.zalloc=Z_NULL;
+            zs.zfree=Z_NULL;
+            zs.opaque=Z_NULL;
+            zs.next_in=(Bytef*) (blockIn+BGZF_HEADER_SIZE);
+            zs.avail_in=(uInt) (blockSize-BGZF_HEADER_SIZE-BGZF_FOOTER_SIZE);
+            zs.next_out=(Bytef*) (outBuf+blockOut[ib]);
+            zs.avail_out=isize;
+            if (inflateInit2(&zs, -15)!=Z_OK) {
+                blockError[ib]=1;
+                continue;
+            };
+            int zret=inflate(&zs, Z_FINISH);
+            inflateEnd(&zs);
+            if (zret!=Z_STREAM_END || zs.avail_out!=0 || crc32(crc32(0L, Z_NULL, 0), (Bytef*) (outBuf+blockOut[ib]), isize)!=crc)
+                blockError[ib]=1;
+        };
+
+        for (uint64 ib=0; ib<blockStart.size(); ib++) {
+            if (blockError[ib]) {
+                ostringstream errOut;
+                errOut << "EXITING because of FATAL INPUT FILE ERROR: could not decompress BGZF block in file " << fileName <<"\n";
+                errOut << "SOLUTION: check the integrity of the file, e.g. with bgzip -t\n";
+                exitWithError(errOut.str(), std::cerr, P.inOut->logMain, EXIT_CODE_INPUT_FILES, P);
+            };
+        };
+
+        inStart=inPos;
+        bufPut->sizeBytes[0]=outPos;
+        if (outPos==READ_FILES_BUF_SIZE)
+            bufPutPush();
+    };
+};
@@ -0,0 +1,64 @@
+#ifndef CODE_ReadFilesStreambuf
+#define CODE_ReadFilesStreambuf
+
+#include "IncludeDefine.h"
+#include "Parameters.h"
+#include "ChunkInQueue.h"
+#include <streambuf>
+#include <atomic>
+#include <pthread.h>
+
+#define READ_FILES_BUF_SIZE (1LLU<<23) //size of one decompressed buffer
+#define READ_FILES_BUF_N 4 //number of decompressed buffers per input stream
+
+class ReadFilesStreambuf : public std::streambuf {//reads plain, gzip or BGZF files for one mate, decompresses them in a separate thread
+public:
+    enum {compressionNone, compressionGzip, compressionBGZF};
+
+    //fileMarkersIn: insert "FILE n" lines before each file, same as the readFilesCommand script does for multiple files
+    ReadFilesStreambuf(const vector<string> &fileNamesIn, bool fileMarkersIn, Parameters &Pin);
+    ~ReadFilesStreambuf();
+
+    static int fileCompression(const char *header, uint64 headerN); //detect compression from the first bytes of the file
+    static string fileCompressionName(const string &fileName);
+
+    static void* threadDecompress(void *streambuf) {
+        ( (ReadFilesStreambuf*) streambuf )->decompressAll();
+        pthread_exit(0);
+        return NULL;
+    };
+
+protected:
+    int_type underflow();
+
+private:
+    Parameters &P;
+    vector <string> fileNames;
+    bool fileMarkers;
+
+    ChunkInQueue *queueFull, *queueFree; //decompressed buffers and buffers that can be re-filled, only data[0] is used
+    ChunkIn bufAll[READ_FILES_BUF_N];
+    ChunkIn *bufGet; //buffer that is being read by the streambuf
+    ChunkIn *bufPut; //buffer that is being filled by the decompression thread
+    bool eofReached;
+    std::atomic<bool> stopRead; //set by the destructor to stop decompression before the end of the files
+
+    pthread_t threadDecompressPthread;
+
+    //compressed input
+    ifstream fileIn;
+    char *inBuf;
+    uint64 inStart, inEnd;
+
+    void decompressAll(); //decompression thread: all files one after another
+    void bufPutGet(); //get an empty buffer for filling, if there is no buffer being filled
+    void bufPutPush(); //pass the filled buffer to the streambuf
+    void bufPutWrite(const char *data, uint64 dataN);
+
+    uint64 inFill(uint64 bytesNeeded); //read more compressed input, returns number of available bytes
+    void copyPlain();
+    void inflateGzip(const string &fileName);
+    void inflateBGZF(const string &fileName);
+};
+
+#endif
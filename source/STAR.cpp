@@ -150,10 +150,10 @@ int main(int argInN, char *argIn[])
     };
 
     /////////////////////////////////////////////////////////////////////////////////////////////////START
+    pthread_mutex_init(&g_threadChunks.mutexLogMain, NULL);//the input reader thread runs also with runThreadN==1
     if (P.runThreadN > 1)
     {
         g_threadChunks.threadArray = new pthread_t[P.runThreadN];
-        pthread_mutex_init(&g_threadChunks.mutexInRead, NULL);
         pthread_mutex_init(&g_threadChunks.mutexOutSAM, NULL);
         pthread_mutex_init(&g_threadChunks.mutexOutBAM1, NULL);
         pthread_mutex_init(&g_threadChunks.mutexOutUnmappedFastx, NULL);
@@ -190,11 +190,21 @@ int main(int argInN, char *argIn[])
     // this does not seem to work at the moment
     // P.inOut->logMain << "mlock value="<<mlockall(MCL_CURRENT|MCL_FUTURE) <<"\n"<<flush;
 
+    // genome replicas on NUMA nodes, after all insertions into the genome
+    genomeMain.numaReplicate();
+
     // prepare chunks and spawn mapping threads
     ReadAlignChunk *RAchunk[P.runThreadN];
     for (int ii = 0; ii < P.runThreadN; ii++)
     {
-        RAchunk[ii] = new ReadAlignChunk(P, genomeMain, transcriptomeMain, ii);
+        RAchunk[ii] = new ReadAlignChunk(P, genomeMain.numaChunkGenome(ii), transcriptomeMain, ii);
+        RAchunk[ii]->threadCPUs = genomeMain.numaChunkCPUs(ii);
+    };
+    OutSJtable sjTable(P, RAchunk[0]->RA->genOut), sjTable1(P, RAchunk[0]->RA->genOut); // junctions from all chunks
+    for (int ii = 0; ii < P.runThreadN; ii++)
+    {
+        RAchunk[ii]->sjTable = &sjTable;
+        RAchunk[ii]->sjTable1 = &sjTable1;
     };
 
     if (P.runRestart.type != 1)
@@ -16,6 +16,9 @@
   //some Mac's idiosyncrasies: standard SHM libraries are very old and missing some definitions
   #define SHM_NORESERVE 0
 #endif
+#ifndef SHM_HUGETLB
+  #define SHM_HUGETLB 0
+#endif
 
 using namespace std;
 
@@ -29,6 +32,7 @@ SharedMemory::SharedMemory(key_t key, bool unloadLast): _key(key), _counterKey(k
     _sem=NULL;
     _isAllocator = false;
     _needsAllocation = true;
+    _hugePageSize = 0;
 
     EnsureCounter();
     OpenIfExists();
@@ -106,7 +110,14 @@ void SharedMemory::CreateAndInitSharedObject(size_t shmSize)
 #ifdef POSIX_SHARED_MEM
     _shmID=shm_open(GetPosixObjectKey().c_str(), O_CREAT | O_RDWR | O_EXCL, 0666);
 #else
-    _shmID=shmget(_key, toReserve, IPC_CREAT | IPC_EXCL | SHM_NORESERVE | 0666); //        _shmID = shmget(shmKey, shmSize, IPC_CREAT | SHM_NORESERVE | SHM_HUGETLB | 0666);
+    int shmFlags = IPC_CREAT | IPC_EXCL | SHM_NORESERVE | 0666;
+    if (_hugePageSize > 0)
+    {// segment backed by hugetlbfs pages, its size has to be a multiple of the huge page size
+     // huge pages are reserved at creation, so that shmget fails if there are not enough of them, instead of SIGBUS on access
+        toReserve = ((toReserve + _hugePageSize - 1) / _hugePageSize) * _hugePageSize;
+        shmFlags = (shmFlags & ~SHM_NORESERVE) | SHM_HUGETLB;
+    }
+    _shmID=shmget(_key, toReserve, shmFlags);
 #endif
 
     if (_shmID == -1)
@@ -139,6 +139,12 @@ public:
             _err = err;
         };
 
+        // allocate the segment in huge pages of this size (SysV only), 0: normal pages
+        void SetHugePages(size_t hugePageSize)
+        {
+            _hugePageSize = hugePageSize;
+        };
+
         SharedMemory(key_t key, bool unloadLast);
         ~SharedMemory();
         void Allocate(size_t shmSize);
@@ -161,6 +167,7 @@ private:
         key_t _counterKey;
         bool _unloadLast;
         std::ostream * _err;
+        size_t _hugePageSize;
 
         int SharedObjectsUseCount();
         void OpenIfExists();
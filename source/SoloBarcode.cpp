@@ -11,9 +11,11 @@ void SoloBarcode::sortWhiteList(ParametersSolo *pSolo)
     totalSize=0;
     minLen=(uint32)-1;
     wlAdd.resize( wl.size() );
+    wlHash.resize( wl.size() );
     if (pSolo->CBmatchWL.EditDist_2) {
         wlEd.resize( wl.size() );
         wlEdInd.resize( wl.size() );
+        wlEdHash.resize( wl.size() );
     };
 
     for (uint32 ilen1=1; ilen1 < wl.size(); ilen1++) {//scan through different lengths for this CB
@@ -25,9 +27,11 @@ void SoloBarcode::sortWhiteList(ParametersSolo *pSolo)
             auto un1=std::unique(wl[ilen1].begin(),wl[ilen1].end());//collapse identical
             wl[ilen1].resize(std::distance(wl[ilen1].begin(),un1));
             totalSize += wl[ilen1].size();
+            wlHash[ilen1].build(wl[ilen1]);
 
             if (pSolo->CBmatchWL.EditDist_2) {//add mismatches
                 wlAddMismatches(2, ilen1, wl[ilen1], wlEd[ilen1], wlEdInd[ilen1]);
+                wlEdHash[ilen1].build(wlEd[ilen1]);
             };
 
         };
@@ -2,6 +2,7 @@
 #define CODE_SoloBarcode
 #include "IncludeDefine.h"
 #include "SoloCommon.h"
+#include "SoloCBhash.h"
 //#include "ParametersSolo.h"
 
 class ParametersSolo;
@@ -20,6 +21,7 @@ public:
     vector<vector<uintCB>> wl;//whitelists, one for each length
     vector<vector<uintCB>> wlEd;//edited whitelists (i.e. including mismatches and indels)
     vector<vector<uint32>> wlEdInd;//index for wlEd in the unedited wl
+    vector<SoloCBhash> wlHash, wlEdHash;//hash indexes of wl and wlEd
 
     uint64 wlFactor;//factor and modulo for converting each whitelist index into global index
     vector<uint32> wlAdd;//additive for each length
@@ -0,0 +1,22 @@
+#include "SoloCBhash.h"
+
+const uint64 SoloCBhash::emptySlot;
+
+void SoloCBhash::build(const vector<uint64> &wl)
+{
+    table.clear();
+    tableN=0;
+    wlN=wl.size();
+    if (wlN==0 || wlN>=(1LLU<<32)-1)
+        return; //indexes are stored in 32 bits, for larger whitelists find() uses binary search
+
+    tableN = wlN*5/3+16; //load factor 0.6
+    table.assign(tableN, emptySlot);
+    for (uint64 ii=0; ii<wlN; ii++) {
+        uint64 h=hashKey(wl[ii]);
+        uint64 is=slot(h);
+        while (table[is]!=emptySlot)
+            is = (is+1==tableN ? 0 : is+1);
+        table[is] = (ii<<32) | (h & 0xFFFFFFFFLLU);
+    };
+};
@@ -0,0 +1,48 @@
+#ifndef H_SoloCBhash
+#define H_SoloCBhash
+
+#include "IncludeDefine.h"
+
+class SoloCBhash {//open-addressing hash of a sorted whitelist: returns the index of a barcode in the whitelist in ~1 probe, instead of binary search
+public:
+    void build(const vector<uint64> &wl);
+
+    int64 find(const uint64 key, const uint64 *wl) const
+    {//index of key in wl (the same whitelist that was used in build), -1 if key is not in wl
+        if (tableN==0) {//the hash was not built
+            if (wlN==0)
+                return -1;
+            const uint64 *it=std::lower_bound(wl, wl+wlN, key);
+            return (it<wl+wlN && *it==key) ? (int64)(it-wl) : -1;
+        };
+        uint64 h=hashKey(key);
+        uint64 fp=h & 0xFFFFFFFFLLU; //fingerprint
+        for (uint64 is=slot(h); ; is = (is+1==tableN ? 0 : is+1)) {//linear probing
+            uint64 e=table[is];
+            if (e==emptySlot)
+                return -1;
+            if ( (e & 0xFFFFFFFFLLU)==fp && wl[e>>32]==key )
+                return (int64) (e>>32);
+        };
+    };
+
+private:
+    static const uint64 emptySlot=(uint64)-1;
+    uint64 wlN=0; //number of barcodes in the whitelist
+    uint64 tableN=0; //number of slots
+    vector<uint64> table; //slot: whitelist index (high 32 bits), fingerprint of the barcode (low 32 bits)
+
+    static inline uint64 hashKey(uint64 key)
+    {//mixing function from splitmix64
+        key = (key ^ (key>>30)) * 0xBF58476D1CE4E5B9LLU;
+        key = (key ^ (key>>27)) * 0x94D049BB133111EBLLU;
+        return key ^ (key>>31);
+    };
+
+    inline uint64 slot(uint64 h) const
+    {//the hash is mapped to [0,tableN) by multiplication, i.e. mostly by its high bits
+        return (uint64) ( ((unsigned __int128) h * tableN) >> 64 );
+    };
+};
+
+#endif
@@ -45,6 +45,7 @@ public:
     */
 
     unordered_map < uintCB, array<uint64,nBits> > flagCounts;
+    vector<uintCB> flagCountsOrder; //CBs in the order of insertion into flagCounts
     array<uint64,nBits> flagCountsNoCB={};
 
     void setBit(uint32 ibit) {
@@ -58,6 +59,8 @@ public:
     void countsAdd(uintCB cb) 
     {//adds flag bits to the count for a given cb
         auto cbInserted = flagCounts.insert({cb, {} });
+        if (cbInserted.second)
+            flagCountsOrder.push_back(cb);
         for (uint32 ibit=0; ibit<nBits; ibit++) {
             (*cbInserted.first).second[ibit] += (uint64) checkBit(ibit);
         };
@@ -75,6 +78,20 @@ public:
             flagCountsNoCB[ibit] += arrIn[ibit];
     };
 
+    void countsAddAll(const SoloReadFlagClass &rfIn)
+    {//adds all counts, the CBs are inserted in the same order as into rfIn
+        for (auto cb : rfIn.flagCountsOrder) {
+            auto cbInserted = flagCounts.insert({cb, {} });
+            if (cbInserted.second)
+                flagCountsOrder.push_back(cb);
+            const auto &countsIn = rfIn.flagCounts.at(cb);
+            for (uint32 ibit=0; ibit<nBits; ibit++)
+                (*cbInserted.first).second[ibit] += countsIn[ibit];
+        };
+        for (uint32 ibit=0; ibit<nBits; ibit++)
+            flagCountsNoCB[ibit] += rfIn.flagCountsNoCB[ibit];
+    };
+
 };
 
 #endif
\ No newline at end of file
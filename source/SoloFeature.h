@@ -77,7 +77,7 @@ public:
     
     vector<uint32> redistrFilesCBindex, redistrFilesCBfirst; //redistr file for each CB, CB boundaries in redistributed files
     vector<uint64> redistrFilesNreads; //number of reads in each file
-    vector <fstream*> redistrFilesStreams;
+    vector <SoloReadRecords*> redistrFilesStreams; //records: uint32 feature, uint64 umi, uint64 cb
 
     SoloFeature(Parameters &Pin, ReadAlignChunk **RAchunk, Transcriptome &inTrans, int32 feTy, SoloReadBarcode *readBarSumIn, SoloFeature **soloFeatAll);
     void clearLarge(); //clear large vectors
@@ -90,12 +90,19 @@ public:
     
     void collapseUMI(uint32 iCB, uint32 *umiArray);
     void collapseUMI_CR(uint32 iCB, uint32 *umiArray);
+    struct collapseUMIthread {//scratch arrays and output of one collapsing thread
+        vector<uint32> umiArray, gID, gReadS; //temp arrays for collapsing UMI
+        vector<uint32> umiWork; //work space of the umiArrayCorrect_* functions
+        vector<uint32> cgu; //countCellGeneUMI records of the CBs collapsed by this thread
+        vector<double> cmm; //countMatMult records of the CBs collapsed by this thread
+        uint64 cguS, cguE, cmmS, cmmE; //start and end of the current CB records in cgu, cmm
+    };
     void collapseUMIall();
-    void collapseUMIperCB(uint32 iCB, vector<uint32> &umiArray, vector<uint32> &gID,  vector<uint32> &gReadS);
+    void collapseUMIperCB(uint32 iCB, collapseUMIthread &cT);
 
-    uint32 umiArrayCorrect_CR         (const uint32 nU0, uintUMI *umiArr, const bool readInfoRec, const bool nUMIyes, unordered_map <uintUMI,uintUMI> &umiCorr);
-    uint32 umiArrayCorrect_Directional(const uint32 nU0, uintUMI *umiArr, const bool readInfoRec, const bool nUMIyes, unordered_map <uintUMI,uintUMI> &umiCorr, const int32 dirCountAdd);
-    uint32 umiArrayCorrect_Graph      (const uint32 nU0, uintUMI *umiArr, const bool readInfoRec, const bool nUMIyes, unordered_map <uintUMI,uintUMI> &umiCorr);
+    uint32 umiArrayCorrect_CR         (const uint32 nU0, uintUMI *umiArr, const bool readInfoRec, const bool nUMIyes, unordered_map <uintUMI,uintUMI> &umiCorr, uint32 *umiWork);
+    uint32 umiArrayCorrect_Directional(const uint32 nU0, uintUMI *umiArr, const bool readInfoRec, const bool nUMIyes, unordered_map <uintUMI,uintUMI> &umiCorr, const int32 dirCountAdd, uint32 *umiWork);
+    uint32 umiArrayCorrect_Graph      (const uint32 nU0, uintUMI *umiArr, const bool readInfoRec, const bool nUMIyes, unordered_map <uintUMI,uintUMI> &umiCorr, uint32 *umiWork);
 
     void outputResults(bool cellFilterYes, string outputPrefixMat);
     void addBAMtags(char *&bam0, uint32 &size0, char* bam1);
@@ -5,66 +5,67 @@
 #include <unordered_map>
 #include "SoloCommon.h"
 #include <bitset>
+#include "radixSort.h"
 
 #define def_MarkNoColor  (uint32) -1
 
-void collapseUMIwith1MMlowHalf(uint32 *umiArr, uint32 umiArrayStride, uint32 umiMaskLow, uint32 nU0, uint32 &nU1, uint32 &nU2, uint32 &nC, vector<array<uint32,2>> &vC);
-void graphDepthFirstSearch(uint32 n, vector<vector<uint32>> &nodeEdges, vector <uint32> &nodeColor);
-uint32 graphNumberOfConnectedComponents(uint32 N, vector<array<uint32,2>> V, vector<uint32> &nodeColor);
+void collapseUMIwith1MMlowHalf(uint32 *umiArr, uint32 umiArrayStride, uint32 umiMaskLow, uint32 nU0, uint32 &nU1, uint32 &nU2, uint32 &nC, uint32 *colorParent, uint32 &nCjoin);
 
+static inline uint32 colorRoot(uint32 *colorParent, uint32 c)
+{//colors of the connected components are joined in the union-find forest, the root is the smallest color of the component
+    while (colorParent[c]!=c) {
+        colorParent[c]=colorParent[colorParent[c]]; //path halving
+        c=colorParent[c];
+    };
+    return c;
+};
 
-uint32 SoloFeature::umiArrayCorrect_Graph(const uint32 nU0, uintUMI *umiArr, const bool readInfoRec, const bool nUMIyes, unordered_map <uintUMI,uintUMI> &umiCorr)
-{
+uint32 SoloFeature::umiArrayCorrect_Graph(const uint32 nU0, uintUMI *umiArr, const bool readInfoRec, const bool nUMIyes, unordered_map <uintUMI,uintUMI> &umiCorr, uint32 *umiWork)
+{//umiWork layout: [0,3*nU0) - sorting buffer, [3*nU0,4*nU0) - color parents, [4*nU0,5*nU0) - best UMI of each color
+ //each new color takes two UMIs, i.e. there are at most nU0/2 colors
     uint32 nU1 = nU0;
     uint32 nU2 = nU0;
     uint32 graphN = 0; //number of nodes
-    vector<array<uint32,2>> graphConn;//node connections
-    vector<uint32> graphComp;//for each node (color) - connected component number
+    uint32 graphJoin = 0; //number of joined nodes (colors)
+    uint32 *colorParent = umiWork+umiArrayStride*nU0;
     
     for (uint64 iu=0; iu<nU0*umiArrayStride; iu+=umiArrayStride)
         umiArr[iu+2]=def_MarkNoColor; //marks no color for graph
 
-    qsort(umiArr, nU0, umiArrayStride*sizeof(uint32), funCompareNumbers<uint32>);
-    collapseUMIwith1MMlowHalf(umiArr, umiArrayStride, pSolo.umiMaskLow, nU0, nU1, nU2, graphN, graphConn);
+    radixSortUint32Stable(umiArr, nU0, umiArrayStride, 0, false, umiWork);
+    collapseUMIwith1MMlowHalf(umiArr, umiArrayStride, pSolo.umiMaskLow, nU0, nU1, nU2, graphN, colorParent, graphJoin);
 
     //exchange low and high half of UMIs, re-sort, and look for 1MM again
     for (uint32 iu=0; iu<umiArrayStride*nU0; iu+=umiArrayStride) {
         pSolo.umiSwapHalves(umiArr[iu]);
     };
-    qsort(umiArr, nU0, umiArrayStride*sizeof(uint32), funCompareNumbers<uint32>);
-    collapseUMIwith1MMlowHalf(umiArr, umiArrayStride, pSolo.umiMaskLow, nU0, nU1, nU2, graphN, graphConn);
+    radixSortUint32Stable(umiArr, nU0, umiArrayStride, 0, false, umiWork);
+    collapseUMIwith1MMlowHalf(umiArr, umiArrayStride, pSolo.umiMaskLow, nU0, nU1, nU2, graphN, colorParent, graphJoin);
 
-    uint32 nConnComp=graphNumberOfConnectedComponents(graphN, graphConn, graphComp);
+    uint32 nConnComp=graphN-graphJoin;
     nU1 += nConnComp;    
     
     if (readInfoRec) {
-        for (uint32 ii=0; ii<graphComp.size(); ii++) {//for non-conflicting colors, need to fill the colors correctly
-            if (graphComp[ii]==(uint32)-1)
-                graphComp[ii]=ii;
-        };
-
         const uint32 bitTopMask=~(1<<31);
-        vector<array<uint32,2>> umiBest(graphN,{0,0});
-        unordered_map<uintUMI,uint32> umiCorrColor;
+        uint32 *umiBest = umiWork+(umiArrayStride+1)*nU0; //count and UMI with the highest count for each connected component
+        memset(umiBest, 0, 2*graphN*sizeof(uint32));
         for (uint32 iu=0; iu<umiArrayStride*nU0; iu+=umiArrayStride) {
             //switch low/high to recover original UMIs
             pSolo.umiSwapHalves(umiArr[iu]);//halves were swapped, need to return back to UMIs
             //find best UMI (highest count) for each connected component
             if (umiArr[iu+2]==def_MarkNoColor)
                 continue; //UMI is not corrected
-            uint32 color1=graphComp[umiArr[iu+2]];
+            uint32 color1=colorRoot(colorParent, umiArr[iu+2]);
             uint32 count1=umiArr[iu+1] & bitTopMask;
-            if (umiBest[color1][0] < count1) {
-                umiBest[color1][0] = count1;
-                umiBest[color1][1] = umiArr[iu];
+            if (umiBest[2*color1] < count1) {
+                umiBest[2*color1] = count1;
+                umiBest[2*color1+1] = umiArr[iu];
             };              
-            umiCorrColor[umiArr[iu]] = color1;
         };
 
         for (uint32 iu=0; iu<umiArrayStride*nU0; iu+=umiArrayStride) {
-            auto umi = umiArr[iu+0];
-            if ( umiCorrColor.count(umi)>0 )
-                umiCorr[umi]=umiBest[umiCorrColor[umi]][1];
+            if (umiArr[iu+2]!=def_MarkNoColor)
+                umiCorr[umiArr[iu+0]]=umiBest[2*colorRoot(colorParent, umiArr[iu+2])+1];
         };
     };
     
@@ -77,7 +78,7 @@ uint32 SoloFeature::umiArrayCorrect_Graph(const uint32 nU0, uintUMI *umiArr, con
 };
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////
-void collapseUMIwith1MMlowHalf(uint32 *umiArr, uint32 umiArrayStride, uint32 umiMaskLow, uint32 nU0, uint32 &nU1, uint32 &nU2, uint32 &nC, vector<array<uint32,2>> &vC)
+void collapseUMIwith1MMlowHalf(uint32 *umiArr, uint32 umiArrayStride, uint32 umiMaskLow, uint32 nU0, uint32 &nU1, uint32 &nU2, uint32 &nC, uint32 *colorParent, uint32 &nCjoin)
 {
     const uint32 bitTop=1<<31;
     const uint32 bitTopMask=~bitTop;
@@ -101,6 +102,7 @@ void collapseUMIwith1MMlowHalf(uint32 *umiArr, uint32 umiArrayStride, uint32 umi
                 //new color
                 umiArr[iu+2] = nC;
                 umiArr[iuu+2] = nC;
+                colorParent[nC] = nC;
                 ++nC;
                 nU1 -= 2;//subtract the duplicated UMIs
             } else if ( umiArr[iu+2] == def_MarkNoColor ) {
@@ -110,10 +112,13 @@ void collapseUMIwith1MMlowHalf(uint32 *umiArr, uint32 umiArrayStride, uint32 umi
                 umiArr[iuu+2] = umiArr[iu+2];
                 --nU1;//subtract the duplicated UMIs
             } else {//both color
-                if (umiArr[iuu+2] != umiArr[iu+2]) {//color conflict
-                    //uint32 p[2]={umiArr[iu+2],umiArr[iuu+2]};
-                    vC.push_back({umiArr[iu+2],umiArr[iuu+2]});
-                    //vC.push_back({umiArr[iuu+2],umiArr[iu+2]});
+                if (umiArr[iuu+2] != umiArr[iu+2]) {//color conflict: join the connected components
+                    uint32 c1=colorRoot(colorParent, umiArr[iu+2]);
+                    uint32 c2=colorRoot(colorParent, umiArr[iuu+2]);
+                    if (c1!=c2) {
+                        colorParent[max(c1,c2)]=min(c1,c2);
+                        ++nCjoin;
+                    };
                 };
             };
 
@@ -128,45 +133,3 @@ void collapseUMIwith1MMlowHalf(uint32 *umiArr, uint32 umiArrayStride, uint32 umi
         };
     };
 };
-
-void graphDepthFirstSearch(uint32 n, vector<vector<uint32>> &nodeEdges, vector <uint32> &nodeColor) 
-{
-    for (const auto &nn : nodeEdges[n]) {
-        if (nodeColor[nn]==(uint32)-1) {//node not visited
-            nodeColor[nn]=nodeColor[n];
-            graphDepthFirstSearch(nn,nodeEdges,nodeColor);
-        };
-    };
-};
-
-uint32 graphNumberOfConnectedComponents(uint32 N, vector<array<uint32,2>> V, vector<uint32> &nodeColor) 
-{//find number of connected components
-    //N=number of nodes
-    //V=edges, list of connected nodes, each pair of nodes listed once
-    //simple recursive DFS
-   
-    nodeColor.resize(N,(uint32)-1); //new color (connected component) for each node (each original color)
-
-    if (V.size()==0)
-        return N;
-
-    vector<vector<uint32>> nodeEdges (N);
-    for (uint32 ii=0; ii<V.size(); ii++) {
-        nodeEdges[V[ii][0]].push_back(V[ii][1]);
-        nodeEdges[V[ii][1]].push_back(V[ii][0]);
-    };
-    
-    uint32 nConnComp=0;
-    for (uint32 ii=0; ii<N; ii++) {
-        if (nodeEdges[ii].size()==0) {//this node is not connected, no need to check. Save time because this happens often
-            ++nConnComp;
-        } else if (nodeColor[ii]==(uint32)-1) {//node not visited
-            ++nConnComp;
-            nodeColor[ii]=ii;
-            graphDepthFirstSearch(ii,nodeEdges,nodeColor);
-        };
-    };
-    return nConnComp;
-};
-
-
@@ -4,20 +4,97 @@
 #include "serviceFuns.cpp"
 #include <unordered_map>
 #include "SoloCommon.h"
+#include "radixSort.h"
 
-inline int funCompareSolo1 (const void *a, const void *b);          //defined below
-inline int funCompare_uint32_1_2_0 (const void *a, const void *b);
+inline int funCompare_uint32_1_2_0 (const void *a, const void *b); //defined below
+
+static inline uint32 umi1MM(uint32 uuXor)
+{//1 if the 2-bit packed UMIs differ by one base: one bit per mismatched base, exactly one has to be set
+    uuXor=(uuXor | (uuXor>>1)) & 0x55555555;
+    return (uint32) ( (uuXor!=0) & ((uuXor & (uuXor-1))==0) );
+};
+
+static inline uint32 umi1MMany(const uint32 *umiS, const uint32 n, const uint32 umi1)
+{//1 if any of umiS[0,n) differs by one base from umi1, no branches to allow the compiler to vectorize it
+    uint32 m=0;
+    for (uint32 ii=0; ii<n; ii++)
+        m |= umi1MM(umiS[ii]^umi1);
+    return m;
+};
+
+#define UMI_1MM_BLOCK 32 //UMIs are checked in blocks for the presence of a 1MM UMI, then one by one
+
+static inline uint32 umi1MMlast(const uint32 *umiS, const uint32 i1, uint32 i2, const uint32 umi1)
+{//last UMI in [i1,i2) with 1MM to umi1, -1 if none
+    while (i2>i1) {
+        uint32 i0 = i2-i1>UMI_1MM_BLOCK ? i2-UMI_1MM_BLOCK : i1;
+        if (umi1MMany(umiS+i0, i2-i0, umi1)) {
+            for ( ; i2>i0; i2--) {
+                if (umi1MM(umiS[i2-1]^umi1))
+                    return i2-1;
+            };
+        };
+        i2=i0;
+    };
+    return (uint32)-1;
+};
+
+static inline uint32 umi1MMfirst(const uint32 *umiS, const uint32 n, const uint32 umi1)
+{//first UMI in [0,n) with 1MM to umi1, -1 if none
+    for (uint32 i1=0; i1<n; i1+=UMI_1MM_BLOCK) {
+        uint32 i2 = min(i1+UMI_1MM_BLOCK, n);
+        if (umi1MMany(umiS+i1, i2-i1, umi1)) {
+            for ( ; i1<i2; i1++) {
+                if (umi1MM(umiS[i1]^umi1))
+                    return i1;
+            };
+        };
+    };
+    return (uint32)-1;
+};
 
 void SoloFeature::collapseUMIall() 
-{
-    vector<uint32> umiArray(nReadPerCBmax*umiArrayStride);//temp array for collapsing UMI
-    vector<uint32> gID(min(2*featuresNumber,nReadPerCBmax)+1); //gene IDs, 2* is needed because each gene can have unique and multi-mappers
-    vector<uint32> gReadS(min(2*featuresNumber,nReadPerCBmax)+1); //start of gene reads TODO: allocate this array in the 2nd half of rGU
+{//CBs are independent: collapse them in parallel, largest CBs first, then concatenate the records in the CB order
+    vector<collapseUMIthread> cThr(P.runThreadN);
+    vector<uint32> cbThread(nCB); //thread that collapsed each CB
+    vector<uint64> cbCguS(nCB), cbCmmS(nCB); //start of each CB records in the thread arrays
+
+    vector<uint32> cbOrder(nCB);
+    for (uint32 icb=0; icb<nCB; icb++)
+        cbOrder[icb]=icb;
+    sort(cbOrder.begin(), cbOrder.end(), [&](const uint32 a, const uint32 b) {return nReadPerCB[a]>nReadPerCB[b] || (nReadPerCB[a]==nReadPerCB[b] && a<b);});
+
+    #pragma omp parallel num_threads(P.runThreadN)
+    {
+        uint32 iThread=omp_get_thread_num();
+        collapseUMIthread &cT=cThr[iThread];
+        cT.gID.resize(min(2*featuresNumber,nReadPerCBmax)+1); //gene IDs, 2* is needed because each gene can have unique and multi-mappers
+        cT.gReadS.resize(min(2*featuresNumber,nReadPerCBmax)+1); //start of gene reads
+        cT.cguE=cT.cmmE=0;
+
+        #pragma omp for schedule(dynamic,1)
+        for (uint32 ii=0; ii<nCB; ii++) {//main collapse cycle
+            uint32 icb=cbOrder[ii];
+            cT.cguS=cT.cguE;
+            cT.cmmS=cT.cmmE;
+
+            collapseUMIperCB(icb, cT);
+
+            cbThread[icb]=iThread;
+            cbCguS[icb]=cT.cguS;
+            countCellGeneUMIindex[icb+1]=cT.cguE-cT.cguS; //number of records, converted to the index below
+            if (pSolo.multiMap.yes.multi) {
+                cbCmmS[icb]=cT.cmmS;
+                countMatMult.i[icb+1]=cT.cmmE-cT.cmmS;
+            };
+        };
+    };
+
+    for (uint32 icb=0; icb<nCB; icb++) {
+        countCellGeneUMIindex[icb+1] += countCellGeneUMIindex[icb];
+        if (pSolo.multiMap.yes.multi)
+            countMatMult.i[icb+1] += countMatMult.i[icb];
 
-    for (uint32 icb=0; icb<nCB; icb++) {//main collapse cycle
-        
-        collapseUMIperCB(icb, umiArray, gID, gReadS);
-        
         readFeatSum->stats.V[readFeatSum->stats.yesUMIs] += nUMIperCB[icb];
         if (nGenePerCB[icb]>0) //nGenePerCB contains only unique
             ++readFeatSum->stats.V[readFeatSum->stats.yesCellBarcodes];
@@ -25,10 +102,23 @@ void SoloFeature::collapseUMIall()
         readFeatSum->stats.V[readFeatSum->stats.yesWLmatch] += nReadPerCBtotal[icb];        
         readFeatSum->stats.V[readFeatSum->stats.yessubWLmatch_UniqueFeature ] += nReadPerCBunique[icb];        
     };
+
+    countCellGeneUMI.resize(countCellGeneUMIindex[nCB]);
+    if (pSolo.multiMap.yes.multi)
+        countMatMult.m.resize(countMatMult.i[nCB]);
+
+    #pragma omp parallel for num_threads(P.runThreadN) schedule(dynamic,1024)
+    for (uint32 icb=0; icb<nCB; icb++) {
+        collapseUMIthread &cT=cThr[cbThread[icb]];
+        std::copy(cT.cgu.begin()+cbCguS[icb], cT.cgu.begin()+cbCguS[icb]+(countCellGeneUMIindex[icb+1]-countCellGeneUMIindex[icb]), countCellGeneUMI.begin()+countCellGeneUMIindex[icb]);
+        if (pSolo.multiMap.yes.multi)
+            std::copy(cT.cmm.begin()+cbCmmS[icb], cT.cmm.begin()+cbCmmS[icb]+(countMatMult.i[icb+1]-countMatMult.i[icb]), countMatMult.m.begin()+countMatMult.i[icb]);
+    };
 };
 
-void SoloFeature::collapseUMIperCB(uint32 iCB, vector<uint32> &umiArray, vector<uint32> &gID,  vector<uint32> &gReadS)
+void SoloFeature::collapseUMIperCB(uint32 iCB, collapseUMIthread &cT)
 {
+    vector<uint32> &umiArray=cT.umiArray, &gID=cT.gID, &gReadS=cT.gReadS;
 
     uint32 *rGU=rCBp[iCB];
     uint32 rN=nReadPerCB[iCB]; //with multimappers, this is the number of all aligns, not reads
@@ -91,12 +181,12 @@ void SoloFeature::collapseUMIperCB(uint32 iCB, vector<uint32> &umiArray, vector<
     
     vector<unordered_map <uintUMI,uintUMI>> umiCorrected(nGenes);
 
-    if (countCellGeneUMI.size() < countCellGeneUMIindex[iCB] + nGenes*countMatStride)
-        countCellGeneUMI.resize((countCellGeneUMI.size() + nGenes*countMatStride )*2);//allocated vector too small
+    if (cT.cgu.size() < cT.cguS + nGenes*countMatStride)
+        cT.cgu.resize((cT.cgu.size() + nGenes*countMatStride )*2);//allocated vector too small
     
     nGenePerCB[iCB]=0;
     nUMIperCB[iCB]=0;
-    countCellGeneUMIindex[iCB+1]=countCellGeneUMIindex[iCB];
+    cT.cguE=cT.cguS;
     
     /////////////////////////////////////////////
     /////////// main cycle over genes with unique-gene-mappers
@@ -108,6 +198,11 @@ void SoloFeature::collapseUMIperCB(uint32 iCB, vector<uint32> &umiArray, vector<
             continue; //no reads - this should not happen?
             
         qsort(rGU1, nR0, rguStride*sizeof(uint32), funCompareTypeShift<uint32,rguU>);
+
+        if (umiArray.size() < nR0*umiArrayStride) {//grow the scratch arrays to the largest gene collapsed by this thread, not pre-sized for the largest CB
+            umiArray.resize(nR0*umiArrayStride);
+            cT.umiWork.resize(nR0*(umiArrayStride+2)); //see umiArrayCorrect_Graph for the layout
+        };
             
         //exact collapse
         uint32 iR1=-umiArrayStride; //number of distinct UMIs for this gene
@@ -139,7 +234,7 @@ void SoloFeature::collapseUMIperCB(uint32 iCB, vector<uint32> &umiArray, vector<
                 umiGeneMapCount0[umiArray[iu+0]][iG]+=umiArray[iu+1];//this sums read counts over UMIs that were collapsed
             };
                 
-            umiArrayCorrect_CR(nU0, umiArray.data(), readInfo.size()>0, false, umiCorrected[iG]);
+            umiArrayCorrect_CR(nU0, umiArray.data(), readInfo.size()>0, false, umiCorrected[iG], cT.umiWork.data());
                 
             for (uint64 iu=0; iu<nU0*umiArrayStride; iu+=umiArrayStride) {//just fill the umiGeneMapCount - will calculate UMI counts later
                 umiGeneMapCount[umiArray[iu+2]][iG]+=umiArray[iu+1];//this sums read counts over UMIs that were collapsed
@@ -150,40 +245,40 @@ void SoloFeature::collapseUMIperCB(uint32 iCB, vector<uint32> &umiArray, vector<
             
             
         if (pSolo.umiDedup.yes.NoDedup)
-            countCellGeneUMI[countCellGeneUMIindex[iCB+1] + pSolo.umiDedup.countInd.NoDedup] = nR0;
+            cT.cgu[cT.cguE + pSolo.umiDedup.countInd.NoDedup] = nR0;
 
         if (nU0>0) {//otherwise no need to count
             if (pSolo.umiDedup.yes.Exact)
-                countCellGeneUMI[countCellGeneUMIindex[iCB+1] + pSolo.umiDedup.countInd.Exact] = nU0;
+                cT.cgu[cT.cguE + pSolo.umiDedup.countInd.Exact] = nU0;
                 
             if (pSolo.umiDedup.yes.CR)
-                countCellGeneUMI[countCellGeneUMIindex[iCB+1] + pSolo.umiDedup.countInd.CR] = 
-                    umiArrayCorrect_CR(nU0, umiArray.data(), readInfo.size()>0 && pSolo.umiDedup.typeMain==UMIdedup::typeI::CR, true, umiCorrected[iG]);
+                cT.cgu[cT.cguE + pSolo.umiDedup.countInd.CR] = 
+                    umiArrayCorrect_CR(nU0, umiArray.data(), readInfo.size()>0 && pSolo.umiDedup.typeMain==UMIdedup::typeI::CR, true, umiCorrected[iG], cT.umiWork.data());
                 
             if (pSolo.umiDedup.yes.Directional)
-                countCellGeneUMI[countCellGeneUMIindex[iCB+1] + pSolo.umiDedup.countInd.Directional] = 
-                    umiArrayCorrect_Directional(nU0, umiArray.data(), readInfo.size()>0 && pSolo.umiDedup.typeMain==UMIdedup::typeI::Directional, true, umiCorrected[iG], 0);
+                cT.cgu[cT.cguE + pSolo.umiDedup.countInd.Directional] = 
+                    umiArrayCorrect_Directional(nU0, umiArray.data(), readInfo.size()>0 && pSolo.umiDedup.typeMain==UMIdedup::typeI::Directional, true, umiCorrected[iG], 0, cT.umiWork.data());
                     
             if (pSolo.umiDedup.yes.Directional_UMItools)
-                countCellGeneUMI[countCellGeneUMIindex[iCB+1] + pSolo.umiDedup.countInd.Directional_UMItools] = 
-                    umiArrayCorrect_Directional(nU0, umiArray.data(), readInfo.size()>0 && pSolo.umiDedup.typeMain==UMIdedup::typeI::Directional_UMItools, true, umiCorrected[iG], -1);                    
+                cT.cgu[cT.cguE + pSolo.umiDedup.countInd.Directional_UMItools] = 
+                    umiArrayCorrect_Directional(nU0, umiArray.data(), readInfo.size()>0 && pSolo.umiDedup.typeMain==UMIdedup::typeI::Directional_UMItools, true, umiCorrected[iG], -1, cT.umiWork.data());                    
                 
             //this changes umiArray, so it should be last call
             if (pSolo.umiDedup.yes.All)
-                countCellGeneUMI[countCellGeneUMIindex[iCB+1] + pSolo.umiDedup.countInd.All] = 
-                    umiArrayCorrect_Graph(nU0, umiArray.data(), readInfo.size()>0 && pSolo.umiDedup.typeMain==UMIdedup::typeI::All, true, umiCorrected[iG]);
+                cT.cgu[cT.cguE + pSolo.umiDedup.countInd.All] = 
+                    umiArrayCorrect_Graph(nU0, umiArray.data(), readInfo.size()>0 && pSolo.umiDedup.typeMain==UMIdedup::typeI::All, true, umiCorrected[iG], cT.umiWork.data());
         };//if (nU0>0)
         
         {//check any count>0 and finalize record for this gene
             uint32 totcount=0;
-            for (uint32 ii=countCellGeneUMIindex[iCB+1]+1; ii<countCellGeneUMIindex[iCB+1]+countMatStride; ii++) {
-                totcount += countCellGeneUMI[ii];
+            for (uint32 ii=cT.cguE+1; ii<cT.cguE+countMatStride; ii++) {
+                totcount += cT.cgu[ii];
             };
             if (totcount>0) {//at least one umiDedup type is non-0
-                countCellGeneUMI[countCellGeneUMIindex[iCB+1] + 0] = gID[iG];
+                cT.cgu[cT.cguE + 0] = gID[iG];
                 nGenePerCB[iCB]++;
-                nUMIperCB[iCB] += countCellGeneUMI[countCellGeneUMIindex[iCB+1] + pSolo.umiDedup.countInd.main];
-                countCellGeneUMIindex[iCB+1] = countCellGeneUMIindex[iCB+1] + countMatStride;//iCB+1 accumulates the index
+                nUMIperCB[iCB] += cT.cgu[cT.cguE + pSolo.umiDedup.countInd.main];
+                cT.cguE = cT.cguE + countMatStride;//iCB+1 accumulates the index
             };
         };        
         
@@ -242,9 +337,9 @@ void SoloFeature::collapseUMIperCB(uint32 iCB, vector<uint32> &umiArray, vector<
                 continue; //no counts for this gene
             nGenePerCB[iCB]++;
             nUMIperCB[iCB] += geneCounts[ig];
-            countCellGeneUMI[countCellGeneUMIindex[iCB+1] + 0] = gID[ig];
-            countCellGeneUMI[countCellGeneUMIindex[iCB+1] + pSolo.umiDedup.countInd.CR] = geneCounts[ig];
-            countCellGeneUMIindex[iCB+1] = countCellGeneUMIindex[iCB+1] + countMatStride;//iCB+1 accumulates the index
+            cT.cgu[cT.cguE + 0] = gID[ig];
+            cT.cgu[cT.cguE + pSolo.umiDedup.countInd.CR] = geneCounts[ig];
+            cT.cguE = cT.cguE + countMatStride;//iCB+1 accumulates the index
         };
         
         if (readInfo.size()>0) {//record cb/umi for each read
@@ -272,7 +367,7 @@ void SoloFeature::collapseUMIperCB(uint32 iCB, vector<uint32> &umiArray, vector<
     //////////////////////////////////////////multi-gene reads to the end of function
     //////////////////////////////////////////
     if (pSolo.multiMap.yes.multi)
-        countMatMult.i[iCB+1] = countMatMult.i[iCB];
+        cT.cmmE = cT.cmmS;
     
     if (nGenesMult>0) {//process multigene reads
         
@@ -373,10 +468,10 @@ void SoloFeature::collapseUMIperCB(uint32 iCB, vector<uint32> &umiArray, vector<
             for (uint32 indDedup=0; indDedup < pSolo.umiDedup.yes.N; indDedup++) {
                 vector<double> gEu(genesM.size(), 0);
                 {//collect unique gene counts
-                    for (uint32 igm=countCellGeneUMIindex[iCB]; igm<countCellGeneUMIindex[iCB+1]; igm+=countMatStride) {
-                        uint32 g1 = countCellGeneUMI[igm];
+                    for (uint32 igm=cT.cguS; igm<cT.cguE; igm+=countMatStride) {
+                        uint32 g1 = cT.cgu[igm];
                         if (genesM.count(g1)>0)
-                            gEu[genesM[g1]]=(double)countCellGeneUMI[igm+1+indDedup];
+                            gEu[genesM[g1]]=(double)cT.cgu[igm+1+indDedup];
                     };
                 };
                 
@@ -405,10 +500,10 @@ void SoloFeature::collapseUMIperCB(uint32 iCB, vector<uint32> &umiArray, vector<
             for (uint32 indDedup=0; indDedup < pSolo.umiDedup.yes.N; indDedup++) {
                 vector<double> gEu(genesM.size(), 0);
                 {//collect unique gene counts
-                    for (uint32 igm=countCellGeneUMIindex[iCB]; igm<countCellGeneUMIindex[iCB+1]; igm+=countMatStride) {
-                        uint32 g1 = countCellGeneUMI[igm];
+                    for (uint32 igm=cT.cguS; igm<cT.cguE; igm+=countMatStride) {
+                        uint32 g1 = cT.cgu[igm];
                         if (genesM.count(g1)>0)
-                            gEu[genesM[g1]]=(double)countCellGeneUMI[igm+1+indDedup];
+                            gEu[genesM[g1]]=(double)cT.cgu[igm+1+indDedup];
                     };
                 };
                 
@@ -438,10 +533,10 @@ void SoloFeature::collapseUMIperCB(uint32 iCB, vector<uint32> &umiArray, vector<
             for (uint32 indDedup=0; indDedup < pSolo.umiDedup.yes.N; indDedup++) {
                 vector<double> gEu(genesM.size(), 0);
                 {//collect unique gene counts
-                    for (uint32 igm=countCellGeneUMIindex[iCB]; igm<countCellGeneUMIindex[iCB+1]; igm+=countMatStride) {
-                        uint32 g1 = countCellGeneUMI[igm];
+                    for (uint32 igm=cT.cguS; igm<cT.cguE; igm+=countMatStride) {
+                        uint32 g1 = cT.cgu[igm];
                         if (genesM.count(g1)>0)
-                            gEu[genesM[g1]]=(double)countCellGeneUMI[igm+1+indDedup];
+                            gEu[genesM[g1]]=(double)cT.cgu[igm+1+indDedup];
                     };
                 };
                 
@@ -506,28 +601,28 @@ void SoloFeature::collapseUMIperCB(uint32 iCB, vector<uint32> &umiArray, vector<
         };        
         
         {//write to countMatMult
-            if (countMatMult.m.size() < countMatMult.i[iCB+1] + genesM.size()*countMatMult.s*pSolo.umiDedup.yes.N + 100) //+100 just in case
-                countMatMult.m.resize((countMatMult.i[iCB+1] + genesM.size()*countMatMult.s*pSolo.umiDedup.yes.N + 100)*2);
+            if (cT.cmm.size() < cT.cmmE + genesM.size()*countMatMult.s*pSolo.umiDedup.yes.N + 100) //+100 just in case
+                cT.cmm.resize((cT.cmmE + genesM.size()*countMatMult.s*pSolo.umiDedup.yes.N + 100)*2);
 
             for (const auto &gm: genesM) {
-                countMatMult.m[countMatMult.i[iCB+1] + 0] = gm.first;
+                cT.cmm[cT.cmmE + 0] = gm.first;
                     
                 for (uint32 indDedup=0; indDedup < pSolo.umiDedup.yes.N; indDedup++) {
-                    uint32 ind1 = countMatMult.i[iCB+1] + indDedup;
+                    uint32 ind1 = cT.cmmE + indDedup;
                     
                     if (pSolo.multiMap.yes.Uniform)
-                        countMatMult.m[ind1 + pSolo.multiMap.countInd.Uniform] = gEuniform[gm.second];
+                        cT.cmm[ind1 + pSolo.multiMap.countInd.Uniform] = gEuniform[gm.second];
                         
                     if (pSolo.multiMap.yes.Rescue)
-                        countMatMult.m[ind1 + pSolo.multiMap.countInd.Rescue] = gErescue[indDedup][gm.second];
+                        cT.cmm[ind1 + pSolo.multiMap.countInd.Rescue] = gErescue[indDedup][gm.second];
                         
                     if (pSolo.multiMap.yes.PropUnique)
-                        countMatMult.m[ind1 + pSolo.multiMap.countInd.PropUnique] = gEpropUnique[indDedup][gm.second];
+                        cT.cmm[ind1 + pSolo.multiMap.countInd.PropUnique] = gEpropUnique[indDedup][gm.second];
                         
                     if (pSolo.multiMap.yes.EM)
-                        countMatMult.m[ind1 + pSolo.multiMap.countInd.EM] = gEem[indDedup][gm.second];                    
+                        cT.cmm[ind1 + pSolo.multiMap.countInd.EM] = gEem[indDedup][gm.second];                    
                     
-                    countMatMult.i[iCB+1] += countMatMult.s;
+                    cT.cmmE += countMatMult.s;
                 };
             };
         };
@@ -537,23 +632,6 @@ void SoloFeature::collapseUMIperCB(uint32 iCB, vector<uint32> &umiArray, vector<
 
 ////////////////////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////// sorting functions
-inline int funCompareSolo1 (const void *a, const void *b) {
-    uint32 *va= (uint32*) a;
-    uint32 *vb= (uint32*) b;
-
-    if (va[1]>vb[1]) {
-        return 1;
-    } else if (va[1]<vb[1]) {
-        return -1;
-    } else if (va[0]>vb[0]){
-        return 1;
-    } else if (va[0]<vb[0]){
-        return -1;
-    } else {
-        return 0;
-    };
-};
-
 inline int funCompare_uint32_1_2_0 (const void *a, const void *b) {
     uint32 *va= (uint32*) a;
     uint32 *vb= (uint32*) b;
@@ -577,22 +655,24 @@ inline int funCompare_uint32_1_2_0 (const void *a, const void *b) {
 
 
 ////////////////////////////////////////////////////////////////////////////////////////////////
-uint32 SoloFeature::umiArrayCorrect_CR(const uint32 nU0, uintUMI *umiArr, const bool readInfoRec, const bool nUMIyes, unordered_map <uintUMI,uintUMI> &umiCorr)
+uint32 SoloFeature::umiArrayCorrect_CR(const uint32 nU0, uintUMI *umiArr, const bool readInfoRec, const bool nUMIyes, unordered_map <uintUMI,uintUMI> &umiCorr, uint32 *umiWork)
 {
-    qsort(umiArr, nU0, umiArrayStride*sizeof(uint32), funCompareSolo1);
-    
-    for (uint64 iu=0; iu<nU0*umiArrayStride; iu+=umiArrayStride) {
-        
-        umiArr[iu+2] = umiArr[iu+0]; //stores corrected UMI for 1MM_CR and 1MM_Directional
-        for (uint64 iuu=(nU0-1)*umiArrayStride; iuu>iu; iuu-=umiArrayStride) {
-
-            uint32 uuXor = umiArr[iu+0] ^ umiArr[iuu+0];
-
-            if ( (uuXor >> (__builtin_ctz(uuXor)/2)*2) <= 3 ) {//1MM                 
-                umiArr[iu+2]=umiArr[iuu+0];//replace iu with iuu
-                break;
-            };
-        };
+    //sort by count, then by UMI
+    radixSortUint32Stable(umiArr, nU0, umiArrayStride, 0, false, umiWork);
+    radixSortUint32Stable(umiArr, nU0, umiArrayStride, 1, false, umiWork);
+
+    uint32 *umiS=umiWork; //UMI sequences in a contiguous array for the 1MM scan
+    for (uint32 ii=0; ii<nU0; ii++)
+        umiS[ii]=umiArr[ii*umiArrayStride];
+
+    const uint32 bitTop=1<<31; //marks the UMIs that are the corrected UMIs, to count them
+    for (uint32 ii=0; ii<nU0; ii++) {
+        uint32 ii1=umi1MMlast(umiS, ii+1, nU0, umiS[ii]); //the last UMI with 1MM replaces ii
+        if (ii1==(uint32)-1)
+            ii1=ii;
+        umiArr[ii*umiArrayStride+2] = umiS[ii1]; //stores corrected UMI for 1MM_CR and 1MM_Directional
+        if (nUMIyes)
+            umiArr[ii1*umiArrayStride+1] |= bitTop;
     };
     
     if (readInfoRec) {//record corrections
@@ -604,35 +684,38 @@ uint32 SoloFeature::umiArrayCorrect_CR(const uint32 nU0, uintUMI *umiArr, const
     
     if (!nUMIyes) {
         return 0;
-    } else {
-        unordered_set<uintUMI> umiC;
+    } else {//the UMIs are all different, the number of corrected UMIs is the number of marked UMIs
+        uint32 nU1=0;
         for (uint64 iu=0; iu<nU0*umiArrayStride; iu+=umiArrayStride) {
-            umiC.insert(umiArr[iu+2]);
+            nU1 += umiArr[iu+1]>>31;
+            umiArr[iu+1] &= ~bitTop;
         };
-       return umiC.size();
+        return nU1;
     };
 };
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////
-uint32 SoloFeature::umiArrayCorrect_Directional(const uint32 nU0, uintUMI *umiArr, const bool readInfoRec, const bool nUMIyes, unordered_map <uintUMI,uintUMI> &umiCorr, const int32 dirCountAdd)
+uint32 SoloFeature::umiArrayCorrect_Directional(const uint32 nU0, uintUMI *umiArr, const bool readInfoRec, const bool nUMIyes, unordered_map <uintUMI,uintUMI> &umiCorr, const int32 dirCountAdd, uint32 *umiWork)
 {
-    qsort(umiArr, nU0, umiArrayStride*sizeof(uint32), funCompareNumbersReverseShift<uint32, 1>);//TODO no need to sort by sequence here, only by count. 
+    radixSortUint32Stable(umiArr, nU0, umiArrayStride, 1, true, umiWork);//by count, descending
     
-    for (uint64 iu=0; iu<nU0*umiArrayStride; iu+=umiArrayStride)
-        umiArr[iu+2] = umiArr[iu+0]; //initialized - it will store corrected UMI for 1MM_CR and 1MM_Directional
+    uint32 *umiS=umiWork; //UMI sequences in a contiguous array for the 1MM scan
+    for (uint32 ii=0; ii<nU0; ii++) {
+        umiS[ii]=umiArr[ii*umiArrayStride];
+        umiArr[ii*umiArrayStride+2] = umiArr[ii*umiArrayStride]; //initialized - it will store corrected UMI for 1MM_CR and 1MM_Directional
+    };
 
     uint32 nU1 = nU0;
-    for (uint64 iu=umiArrayStride; iu<nU0*umiArrayStride; iu+=umiArrayStride) {
-        
-        for (uint64 iuu=0; iuu<iu; iuu+=umiArrayStride) {
-
-            uint32 uuXor = umiArr[iu+0] ^ umiArr[iuu+0];
-
-            if ( (uuXor >> (__builtin_ctz(uuXor)/2)*2) <= 3 && umiArr[iuu+1] >= (2*umiArr[iu+1]+dirCountAdd) ) {//1MM && directional condition
-                umiArr[iu+2]=umiArr[iuu+2];//replace iuu with iu-corrected
-                nU1--;
-                break;
-            };
+    uint32 nDir = 0; //UMIs [0,nDir) satisfy the directional condition for ii: the counts are descending, so they are a prefix growing with ii
+    for (uint32 ii=1; ii<nU0; ii++) {
+        uint32 count1 = 2*umiArr[ii*umiArrayStride+1]+dirCountAdd;
+        while (nDir<ii && umiArr[nDir*umiArrayStride+1] >= count1)
+            ++nDir;
+
+        uint32 ii1=umi1MMfirst(umiS, nDir, umiS[ii]); //the first UMI with 1MM and directional condition
+        if (ii1!=(uint32)-1) {
+            umiArr[ii*umiArrayStride+2]=umiArr[ii1*umiArrayStride+2];//replace iuu with iu-corrected
+            nU1--;
         };
     };
     
@@ -643,16 +726,6 @@ uint32 SoloFeature::umiArrayCorrect_Directional(const uint32 nU0, uintUMI *umiAr
         };
     };
     
-    if (!nUMIyes) {
-        return 0;
-    } else {
-        unordered_set<uintUMI> umiC;
-        for (uint64 iu=0; iu<nU0*umiArrayStride; iu+=umiArrayStride) {
-            umiC.insert(umiArr[iu+2]);
-        };
-        if (umiC.size()!=nU1)
-            cout << nU1 <<" "<< umiC.size()<<endl;
-        return umiC.size();
-    };
+    //each UMI is corrected to one of the nU1 uncorrected UMIs
+    return nUMIyes ? nU1 : 0;
 };
-
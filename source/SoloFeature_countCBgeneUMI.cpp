@@ -3,6 +3,7 @@
 #include "TimeFunctions.h"
 #include "SequenceFuns.h"
 #include "systemFunctions.h"
+#include "serviceFuns.cpp"
 
 void SoloFeature::countCBgeneUMI()
 {    
@@ -20,18 +21,39 @@ void SoloFeature::countCBgeneUMI()
 
     rGeneUMI = new uint32[rguStride*nReadsMapped]; //big array for all CBs - each element is gene and UMI
     rCBp = new uint32*[nCB+1];
-    uint32 **rCBpa = new uint32*[pSolo.cbWLsize+1];
     
     rCBp[0]=rGeneUMI;
-    rCBpa[0]=rGeneUMI;
-    nCB=0;//will count it again below
-    for (uint32 ii=0; ii<pSolo.cbWLsize; ii++) {
-        if (readFeatSum->cbReadCount[ii]>0) {
-            rCBp[nCB+1] = rCBp[nCB] + rguStride*readFeatSum->cbReadCount[ii];
-            ++nCB;
+    for (uint32 icb=0; icb<nCB; icb++) {
+        rCBp[icb+1] = rCBp[icb] + rguStride*readFeatSum->cbReadCount[indCB[icb]];
+    };
+
+    //each thread's records of each CB are placed into their own part of the CB's space, sized by this thread's counts
+    vector<vector<uint32*>> rCBpThread(P.runThreadN, vector<uint32*>(nCB+1));
+    {
+        vector<vector<uint32>> cbReadCountThread(P.runThreadN);
+        for (int ii=0; ii<P.runThreadN; ii++) {
+            if (pSolo.cbWLyes) {
+                cbReadCountThread[ii].resize(nCB);
+                for (uint32 icb=0; icb<nCB; icb++)
+                    cbReadCountThread[ii][icb] = readFeatAll[ii]->cbReadCount[indCB[icb]];
+            } else {//no WL: CBs are recorded in the map, the WL was created from all CBs in sumThreads
+                cbReadCountThread[ii].resize(nCB,0);
+                for (auto &cbc : readFeatAll[ii]->cbReadCountMap) {
+                    uint64 cbInd = pSolo.cbWLhash.find(cbc.first, pSolo.cbWL.data());
+                    cbReadCountThread[ii][indCBwl[cbInd]] = cbc.second;
+                };
+            };
+        };
+        
+        for (uint32 icb=0; icb<nCB; icb++) {
+            uint32 *cbp1 = rCBp[icb];
+            for (int ii=0; ii<P.runThreadN; ii++) {
+                rCBpThread[ii][icb] = cbp1;
+                cbp1 += rguStride*cbReadCountThread[ii][icb];
+            };
         };
-        rCBpa[ii+1]=rCBp[nCB];
     };
+    vector<vector<uint32*>> rCBpThreadStart(rCBpThread);
 
     //read and store the CB/gene/UMI from files
     time(&rawTime);
@@ -41,13 +63,38 @@ void SoloFeature::countCBgeneUMI()
     ////////////// Input records
     readFlagCounts.flagCounts.reserve(nCB*3/2);
     readFlagCounts.flagCountsNoCB = {};
+    vector<SoloReadFlagClass> readFlagCountsThread(P.runThreadN);
     vector<uint32> nReadPerCBunique1(pSolo.cbWLsize), nReadPerCBmulti1(pSolo.cbWLsize); //temp arrays to record # of reads for all cells in the WL
-    for (int ii=0; ii<P.runThreadN; ii++) {//TODO: this can be parallelized
-        readFeatAll[ii]->inputRecords(rCBpa, rguStride, readBarSum->cbReadCountExact, readInfo, readFlagCounts, nReadPerCBunique1, nReadPerCBmulti1);
+    
+    #pragma omp parallel for num_threads(P.runThreadN) schedule(dynamic,1)
+    for (int ii=0; ii<P.runThreadN; ii++) {
+        readFeatAll[ii]->inputRecords(rCBpThread[ii].data(), rguStride, indCBwl, readBarSum->cbReadCountExact, readInfo, readFlagCountsThread[ii], nReadPerCBunique1, nReadPerCBmulti1);
+    };
+    
+    for (int ii=0; ii<P.runThreadN; ii++) {
+        readFlagCounts.countsAddAll(readFlagCountsThread[ii]);//CBs are inserted in the same order as the records were read
         readFeatSum->addStats(*readFeatAll[ii]);//sum stats: has to be done after inputRecords, since the stats values are updated there
     };
+    readFlagCountsThread.clear();
     readFlagCounts.countsAddNoCBarray(readFeatSum->readFlag.flagCountsNoCB);//add no-CB counts calculated in SoloReadFeature_record.cpp and not recorded to temp Solo files
 
+    //collect the records of each CB from all threads: the parts are moved to follow each other without gaps
+    nReadPerCB.resize(nCB);
+    #pragma omp parallel for num_threads(P.runThreadN) schedule(dynamic,1024)
+    for (uint32 icb=0; icb<nCB; icb++) {
+        uint32 *cbp1 = rCBp[icb];
+        for (int ii=0; ii<P.runThreadN; ii++) {
+            uint64 n1 = rCBpThread[ii][icb]-rCBpThreadStart[ii][icb];
+            if (cbp1 != rCBpThreadStart[ii][icb])
+                memmove(cbp1, rCBpThreadStart[ii][icb], n1*sizeof(uint32));
+            cbp1 += n1;
+        };
+        nReadPerCB[icb] = (cbp1-rCBp[icb])/rguStride;  //number of reads that were matched to WL
+                                                       //for multimappers this is the number of all alignments > number of reads
+    };
+    rCBpThread.clear();
+    rCBpThreadStart.clear();
+
     nReadPerCBtotal.resize(nCB);
     nReadPerCBunique.resize(nCB);
     for (uint32 icb=0; icb<nCB; icb++) {
@@ -69,11 +116,8 @@ void SoloFeature::countCBgeneUMI()
         cout << "n1,2=" << n1<<" "<<n2<<endl;
     };*/
 
-    nReadPerCB.resize(nCB);
     nReadPerCBmax=0;
     for (uint32 iCB=0; iCB<nCB; iCB++) {
-        nReadPerCB[iCB] = (rCBpa[indCB[iCB]]-rCBp[iCB])/rguStride;  //number of reads that were matched to WL, rCBpa accumulated reference to the last element+1
-                                                                    //for multimappers this is the number of all alignments > number of reads
         nReadPerCBmax=max(nReadPerCBmax,nReadPerCB[iCB]);
         //readFeatSum->stats.V[readFeatSum->stats.yesWLmatch] += nReadPerCB[iCB];
     };    
@@ -89,13 +133,11 @@ void SoloFeature::countCBgeneUMI()
     
                      //dedup options        //gene ID
     countMatStride = pSolo.umiDedup.yes.N + 1;
-    countCellGeneUMI.resize(nReadsMapped*countMatStride/5+16); //5 is heuristic, will be resized if needed
-    countCellGeneUMIindex.resize(nCB+1, 0);
+    countCellGeneUMIindex.resize(nCB+1, 0); //countCellGeneUMI is sized in collapseUMIall
     
     if (pSolo.multiMap.yes.multi) {
                     //gene   //uniform  //rescue
         countMatMult.s = 1 + pSolo.multiMap.yes.N * pSolo.umiDedup.yes.N;
-        countMatMult.m.resize(nReadsMapped*countMatMult.s/5+16);
         countMatMult.i.resize(nCB+1, 0);
     };
 
@@ -105,7 +147,6 @@ void SoloFeature::countCBgeneUMI()
                      <<  linuxProcMemory() << flush;        
     delete[] rGeneUMI;
     delete[] rCBp;
-    delete[] rCBpa;
     
     time(&rawTime);
     P.inOut->logMain << timeMonthDayTime(rawTime) << " ... Finished collapsing UMIs" <<endl;
@@ -3,7 +3,6 @@
 #include "TimeFunctions.h"
 #include "SequenceFuns.h"
 #include "serviceFuns.cpp"
-#include "soloInputFeatureUMI.h"
 
 
 void SoloFeature::countSmartSeq()
@@ -53,21 +52,13 @@ void SoloFeature::countSmartSeq()
         };        
         
         //input records
-        redistrFilesStreams[ired]->flush();
-        redistrFilesStreams[ired]->seekg(0,ios::beg);
+        redistrFilesStreams[ired]->rewind();
         
         uint32 feature;
-        uint64 umi, iread;
-        int32 cbmatch;
-        int64 cb;
-        vector<uint32> trIdDist; //not used
-        bool readInfoYes=false;
-        while (soloInputFeatureUMI(redistrFilesStreams[ired], featureType, readInfoYes, P.sjAll, iread, cbmatch, feature, umi, trIdDist, readFlagCounts)) {//cycle over file records
-            
-            *redistrFilesStreams[ired] >> cb;
-            
-            if (feature+1 == 0) 
-                continue;
+        uint64 umi, cb;
+        while (redistrFilesStreams[ired]->get(feature)) {//cycle over file records
+            redistrFilesStreams[ired]->getRequired(umi);
+            redistrFilesStreams[ired]->getRequired(cb);
 
             uint32 icb=indCBwl[cb];
             *( cbFeatUMI[icb] + nReadPerCB[icb] )={feature,umi};
@@ -24,16 +24,22 @@ void SoloFeature::countVelocyto()
     
     //////////// input records
     for (int iThread=0; iThread<P.runThreadN; iThread++) {//TODO: this can be parallelized
-        fstream *streamReads = readFeatAll[iThread]->streamReads;
-        streamReads->flush();
-        streamReads->seekg(0,ios::beg);
+        SoloReadRecords *streamReads = readFeatAll[iThread]->streamReads;
+        streamReads->rewind();
         
         uint64 iread;
-        while (*streamReads >> iread) {//until the end of file
+        while (streamReads->get(iread)) {//until the end of records
+            uint32 nTr;
+            streamReads->getRequired(nTr);
+            vector<trTypeStruct> trT(nTr);
+            for (auto & tt: trT) {
+                streamReads->getRequired(tt.tr);
+                streamReads->getRequired(tt.type);
+            };
+
             uintCB cb=soloFeatAll[pSolo.featureInd[SoloFeatureTypes::Gene]]->readInfo[iread].cb;
             uintUMI umi=soloFeatAll[pSolo.featureInd[SoloFeatureTypes::Gene]]->readInfo[iread].umi;
             if (cb == (uintCB)-1 || umi == (uintUMI)-1 ) {//CB and/or UMI undefined.   TODO: put a filter on CBs here, e.g. UMI threshold
-                streamReads->ignore((uint32)-1, '\n');
                 continue;
             };
 
@@ -41,19 +47,9 @@ void SoloFeature::countVelocyto()
             nReadPerCB[iCB]++;//simple estimate
             
             if (cuTrTypes[iCB].count(umi)>0 && cuTrTypes[iCB][umi].empty()) {//intersection is empty, no need to load this transcript
-                streamReads->ignore((uint32)-1, '\n');
                 continue;
             };
 
-            uint32 nTr;
-            *streamReads >> nTr;
-            vector<trTypeStruct> trT(nTr);
-            for (auto & tt: trT) {
-                uint32 ty;
-                *streamReads >> tt.tr >> ty;
-                tt.type=(uint8) ty;
-            };
-
             if (cuTrTypes[iCB].count(umi)==0) {//1st entry for this umi
                 cuTrTypes[iCB][umi]=trT;
                 continue;
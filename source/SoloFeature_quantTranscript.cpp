@@ -98,16 +98,20 @@ void SoloFeature::quantTranscript()
     
     //////////// input records
     for (int iThread=0; iThread<P.runThreadN; iThread++) {//TODO: this can be parallelized
-        fstream *streamReads = readFeatAll[iThread]->streamReads;
-        streamReads->flush();
-        streamReads->seekg(0,ios::beg);    
+        SoloReadRecords *streamReads = readFeatAll[iThread]->streamReads;
+        streamReads->rewind();
         
-        string line1;
-        while (std::getline(*streamReads, line1)) {//until the end of file
-            stringstream lineStream(line1);
-            uint32 cb, cbCl, nTr;
-            uint64 umi;
-            lineStream >> cb >> umi >> nTr;
+        uint64 cb64, umi, iread;
+        while (streamReads->get(cb64)) {//until the end of records
+            uint32 cb=cb64, cbCl, nTr;
+            streamReads->getRequired(umi);
+            streamReads->getRequired(nTr);
+            vector<array<uint32,2>> trDist(nTr);
+            for (auto &td : trDist) {
+                streamReads->getRequired(td[0]);
+                streamReads->getRequired(td[1]);
+            };
+            streamReads->getRequired(iread);
 
             if (clusterCBind.count(cb)==0) //this cb is not in the clusters
                 continue;
@@ -119,8 +123,7 @@ void SoloFeature::quantTranscript()
             vector<transcriptDistProbStruct> tD;
             tD.reserve(nTr);
             for (uint32 ii=0; ii<nTr; ii++) {
-                uint32 tr1,d1;
-                lineStream >> tr1 >> d1;
+                uint32 tr1=trDist[ii][0], d1=trDist[ii][1];
                 if (d1>=trDistFun.size())
                     continue; //do not record such outlier
                 
@@ -1,5 +1,6 @@
 #include "SoloFeature.h"
 #include "streamFuns.h"
+#include "soloInputFeatureUMI.h"
 //#include "TimeFunctions.h"
 //#include "SequenceFuns.h"
 //#include "Stats.h"
@@ -45,30 +46,25 @@ void SoloFeature::redistributeReadsByCB()
     redistrFilesStreams.resize(redistrFilesNreads.size());
     for (uint32 ii=0; ii<redistrFilesNreads.size(); ii++) {
         //open file with flagDelete=true
-        redistrFilesStreams[ii] = &fstrOpen(P.outFileTmp + "solo"+SoloFeatureTypes::Names[featureType]+"_redistr_"+std::to_string(ii), ERROR_OUT, P, true);
+        redistrFilesStreams[ii] = new SoloReadRecords(P.outFileTmp + "solo"+SoloFeatureTypes::Names[featureType]+"_redistr_"+std::to_string(ii), true, P);
     };
 
     //main cycle
     for (int ii=0; ii<P.runThreadN; ii++) {
-        readFeatAll[ii]->streamReads->clear();//this is needed if eof was reached before
-        readFeatAll[ii]->streamReads->seekg(0,ios::beg);
+        readFeatAll[ii]->streamReads->rewind();
         
-        while ( true ) {
-            string line1;
-            getline(*readFeatAll[ii]->streamReads,line1);
-            if (line1.empty()) {
-                break;
-            };
-            
-            istringstream line1stream(line1);
-            uint64 cb1, umi;            
-            line1stream >> umi >> cb1 >> cb1;
-            if (featureType==SoloFeatureTypes::SJ)
-                line1stream >> cb1;
-            line1stream >> cb1;
-            
-            *redistrFilesStreams[redistrFilesCBindex[indCBwl[cb1]]] << line1 <<'\n';
+        uint32 feature;
+        uint64 umi, iread, cb1;
+        int32 cbmatch;
+        vector<pair<uint32,char>> cbMult;
+        while (soloInputFeatureUMI(readFeatAll[ii]->streamReads, featureType, readFeatAll[ii]->readIndexYes, P.sjAll, iread, cbmatch, feature, umi, cb1, cbMult, readFlagCounts)) {
+            if (feature+1 == 0 || cbmatch>1) //only the reads with features and one CB are counted
+                continue;
             
+            SoloReadRecords *redistr1 = redistrFilesStreams[redistrFilesCBindex[indCBwl[cb1]]];
+            redistr1->put<uint32>(feature);
+            redistr1->put<uint64>(umi);
+            redistr1->put<uint64>(cb1);
         };
         //TODO: delete streamReads files one by one to save disk space
     };
@@ -4,6 +4,7 @@
 #include "SequenceFuns.h"
 #include "Stats.h"
 #include "GlobalVariables.h"
+#include "soloInputFeatureUMI.h"
 
 void SoloFeature::sumThreads()
 {   
@@ -13,7 +14,6 @@ void SoloFeature::sumThreads()
     ///////////////////////////// collect RAchunk->RA->soloRead->readFeat            
     for (int ii=0; ii<P.runThreadN; ii++) {//point to
         readFeatAll[ii]= RAchunk[ii]->RA->soloRead->readFeat[pSolo.featureInd[featureType]];
-        readFeatAll[ii]->streamReads->flush();
         readFeatSum->addCounts(*readFeatAll[ii]);        
     };       
     
@@ -48,6 +48,7 @@ void SoloFeature::sumThreads()
                 icb++;
             };
         };
+        pSolo.cbWLhash.build(pSolo.cbWL);
 
         //pseudocounts
         if (pSolo.CBmatchWL.mm1_multi_pc) {
@@ -60,19 +61,19 @@ void SoloFeature::sumThreads()
     // if restarting from _STARtmp/solo* file
     if (P.runRestart.type==1) {//this could happen if the run is restarted. Would be better to save/load cbReadCount, or recalculate it from
         for (int ii=0; ii<P.runThreadN; ii++) {
-            readFeatAll[ii]->streamReads->clear(); //just in case EOF was reached in previous reading
-            readFeatAll[ii]->streamReads->seekg(0,ios::beg);
-            string line1;
-            while (std::getline(*readFeatAll[ii]->streamReads, line1)) {
-                istringstream line1stream(line1);
-                uint64 cb1;            
-                line1stream >> cb1 >> cb1 >> cb1;
-                if (featureType==SoloFeatureTypes::SJ)
-                    line1stream >> cb1;
-                line1stream >> cb1;
+            readFeatAll[ii]->streamReads->rewind();
+            uint32 feature;
+            uint64 umi, iread, cb1;
+            int32 cbmatch;
+            vector<pair<uint32,char>> cbMult;
+            while (soloInputFeatureUMI(readFeatAll[ii]->streamReads, featureType, readFeatAll[ii]->readIndexYes, P.sjAll, iread, cbmatch, feature, umi, cb1, cbMult, readFlagCounts)) {
+                if (cbmatch>1)
+                    continue;
                 //if (cb1>readFeatSum->cbReadCount.size())
                 //    continue;//this should not happen!
                 readFeatSum->cbReadCount[cb1]++;
+                if (pSolo.cbWLyes)
+                    readFeatAll[ii]->cbReadCount[cb1]++;//per-thread counts are used to place the records in countCBgeneUMI
             };
         };
     };    
@@ -21,7 +21,7 @@ public:
     //int64  cbI;
     int32 cbMatch;//-1: no match, 0: exact, 1: 1 match with 1MM, >1: # of matches with 1MM
     int32 umiCheck;//umi check status
-    string cbMatchString;//CB matches and qualities
+    string cbMatchQual;//qualities of the corrected bases for multiple CB matches
     vector<uint64> cbMatchInd;//matches
     vector<uint32> cbReadCountExact;
     //map <uint32,uint32> cbReadCountMap;//count read per CB for no WL
@@ -34,7 +34,7 @@ public:
     void addCounts(const SoloReadBarcode &rfIn);
     void addStats(const SoloReadBarcode &rfIn);
     void statsOut(ofstream &streamOut);
-    void matchCBtoWL(string &cbSeq1, string &cbQual1, vector<uint64> &cbWL, int32 &cbMatch1, vector<uint64> &cbMatchInd1, string &cbMatchString1);
+    void matchCBtoWL(string &cbSeq1, string &cbQual1, vector<uint64> &cbWL, SoloCBhash &cbWLhash, int32 &cbMatch1, vector<uint64> &cbMatchInd1, string &cbMatchQual1);
     bool convertCheckUMI();
     void addStats(const int32 cbMatch1);
     
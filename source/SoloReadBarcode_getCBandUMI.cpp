@@ -6,10 +6,10 @@
 #include <chrono>
 #include <thread>
 
-void SoloReadBarcode::matchCBtoWL(string &cbSeq1, string &cbQual1, vector<uint64> &cbWL, int32 &cbMatch1, vector<uint64> &cbMatchInd1, string &cbMatchString1)
+void SoloReadBarcode::matchCBtoWL(string &cbSeq1, string &cbQual1, vector<uint64> &cbWL, SoloCBhash &cbWLhash, int32 &cbMatch1, vector<uint64> &cbMatchInd1, string &cbMatchQual1)
 {
     cbMatch1=-1;
-    cbMatchString1="";
+    cbMatchQual1.clear();
     cbMatchInd1.clear();
     //convert CB and check for Ns
     uint64 cbB1;
@@ -22,7 +22,6 @@ void SoloReadBarcode::matchCBtoWL(string &cbSeq1, string &cbQual1, vector<uint64
         } else {//no Ns
             //cbI=(int64) cbB1;
             cbMatchInd1.push_back(cbB1);//all possible barcodes are accepted. This will overflow if CB is longer than 31b
-            cbMatchString1 = to_string(cbB1);
             cbMatch1=0;
         };
         return;
@@ -33,10 +32,9 @@ void SoloReadBarcode::matchCBtoWL(string &cbSeq1, string &cbQual1, vector<uint64
         //stats.V[stats.nNinBarcode]++;
         return;
     } else if (posN==-1) {//no Ns, count only for featureType==gene
-        int64 cbI=binarySearchExact<uint64>(cbB1,cbWL.data(),cbWL.size());
+        int64 cbI=cbWLhash.find(cbB1,cbWL.data());
         if (cbI>=0) {//exact match
             cbMatchInd1.push_back((uint64) cbI);
-            cbMatchString1 = to_string(cbMatchInd1[0]);
             cbMatch1=0;
             return;
         };
@@ -51,7 +49,7 @@ void SoloReadBarcode::matchCBtoWL(string &cbSeq1, string &cbQual1, vector<uint64
         bool matched = false;
         for (uint32 jj=0; jj<4; jj++) {
             uint64 cbB11=cbB1^(jj<<posNshift);
-            int64 cbI1=binarySearchExact<uint64>(cbB11,cbWL.data(),cbWL.size());
+            int64 cbI1=cbWLhash.find(cbB11,cbWL.data());
             if (cbI1>=0) {//found match
                 if (!pSolo.CBmatchWL.mm1_multi_Nbase && matched) {
                     cbMatchInd1.clear();
@@ -62,18 +60,18 @@ void SoloReadBarcode::matchCBtoWL(string &cbSeq1, string &cbQual1, vector<uint64
                 //output all
                 cbMatchInd1.push_back(cbI1);
                 ++cbMatch1;
-                cbMatchString1 += ' ' +to_string(cbI1) + ' ' + cbQual1[posN];
+                cbMatchQual1 += cbQual1[posN];
             };
         };
     } else {//look for 1MM; posN==-1, no Ns
         for (uint32 ii=0; ii<cbSeq1.size(); ii++) {
             for (uint32 jj=1; jj<4; jj++) {
-                int64 cbI1=binarySearchExact<uint64>(cbB1^(jj<<(ii*2)),cbWL.data(),cbWL.size());
+                int64 cbI1=cbWLhash.find(cbB1^(jj<<(ii*2)),cbWL.data());
                 if (cbI1>=0) {//found match
                     //output all
                     cbMatchInd1.push_back(cbI1);
                     ++cbMatch1;
-                    cbMatchString1 += ' ' +to_string(cbI1) + ' ' + cbQual1.at(cbSeq1.size()-1-ii);
+                    cbMatchQual1 += cbQual1.at(cbSeq1.size()-1-ii);
                 };
             };
         };
@@ -82,12 +80,12 @@ void SoloReadBarcode::matchCBtoWL(string &cbSeq1, string &cbQual1, vector<uint64
         //stats.V[stats.noNoWLmatch]++;
         cbMatch1=-1;
     } else if (cbMatch1==1) {//1 match, no need to record the quality
-        cbMatchString1 = to_string(cbMatchInd1[0]);
+        cbMatchQual1.clear();
     } else if (!pSolo.CBmatchWL.mm1_multi) {//>1 matches, but this is not allowed
         cbMatch1=-3;
         cbMatchInd1.clear();
-        cbMatchString1="";
-    };// else cbMatch contains number of matches, and cbMatchString has CBs and qualities
+        cbMatchQual1.clear();
+    };// else cbMatch contains number of matches, cbMatchInd1 has CBs and cbMatchQual1 has qualities
 };
 
 void SoloReadBarcode::addStats(const int32 cbMatch1)
@@ -154,13 +152,12 @@ void SoloReadBarcode::getCBandUMI(char **readSeq, char **readQual, uint64 *readL
         cbSeq=cbQual=cbSeqCorrected=""; //TODO make cbSeq=file label
         cbMatch=0;
         cbMatchInd={readFilesIndex};
-        cbMatchString=to_string(cbMatchInd[0]);
         addStats(cbMatch);
         return;
     };    
     
     cbMatch=-1;
-    cbMatchString="";
+    cbMatchQual.clear();
     cbMatchInd.clear();
     
     ///////////////////////////////////////////////////////////////////////////////////////////////////////    
@@ -265,7 +262,7 @@ void SoloReadBarcode::getCBandUMI(char **readSeq, char **readQual, uint64 *readL
                 qualHist[(uint8)umiQual[ix]]++;
             };               
             
-            matchCBtoWL(cbSeq, cbQual, pSolo.cbWL, cbMatch, cbMatchInd, cbMatchString);
+            matchCBtoWL(cbSeq, cbQual, pSolo.cbWL, pSolo.cbWLhash, cbMatch, cbMatchInd, cbMatchQual);
         } else if (pSolo.CBtype.type==2) {//string cb
             /* this seg-faults
             while (pSolo.CBtype.strMap.count(cbSeq)==0) {
@@ -290,7 +287,6 @@ void SoloReadBarcode::getCBandUMI(char **readSeq, char **readQual, uint64 *readL
             pSolo.CBtype.strMtx->unlock();
             
             cbMatchInd.push_back(cb1);//all possible barcodes are accepted. This will overflow if CB is longer than 31b
-            cbMatchString = std::to_string(cb1);
             cbMatch=0;
         };
 
@@ -302,7 +298,7 @@ void SoloReadBarcode::getCBandUMI(char **readSeq, char **readQual, uint64 *readL
                 cbReadCountExact[cbMatchInd[0]]++; //still need to count it as exact before return, even if UMI is not good
             #endif
             cbMatch=umiCheck;
-            cbMatchString="";
+            cbMatchQual.clear();
             cbMatchInd.clear();
             addStats(cbMatch);
             return;
@@ -315,7 +311,7 @@ void SoloReadBarcode::getCBandUMI(char **readSeq, char **readQual, uint64 *readL
         cbQual=bQual.substr(pSolo.cbS-1,pSolo.cbL);
         umiQual=bQual.substr(pSolo.umiS-1,pSolo.umiL);
 
-        matchCBtoWL(cbSeq, cbQual, pSolo.cbWL, cbMatch, cbMatchInd, cbMatchString);
+        matchCBtoWL(cbSeq, cbQual, pSolo.cbWL, pSolo.cbWLhash, cbMatch, cbMatchInd, cbMatchQual);
 
         if ( cbMatch==0 || cbMatch==1 ) {
             if (pSolo.cbWLyes) {
@@ -386,11 +382,11 @@ void SoloReadBarcode::getCBandUMI(char **readSeq, char **readQual, uint64 *readL
                     cbMatch = -2;
                     cbMatchGood = false;
                 } else {
-                    int64 cbI=binarySearchExact<uint64>(cbB1,cb.wl[cbSeq1.size()].data(),cb.wl[cbLen1].size());
+                    int64 cbI=cb.wlHash[cbLen1].find(cbB1,cb.wl[cbLen1].data());
                     if (cbI>=0) {//exact match
                         cbMatchInd[0] += cb.wlFactor*(cbI+cb.wlAdd[cbLen1]);
                     } else {//no exact match
-                        cbI=binarySearchExact<uint64>(cbB1,cb.wlEd[cbLen1].data(),cb.wlEd[cbLen1].size());
+                        cbI=cb.wlEdHash[cbLen1].find(cbB1,cb.wlEd[cbLen1].data());
                         if (cbI>=0) {//find match in the edited list
                             cbMatch = 1; //>=1MM
                             cbI = cb.wlEdInd[cbLen1][cbI];
@@ -404,7 +400,7 @@ void SoloReadBarcode::getCBandUMI(char **readSeq, char **readQual, uint64 *readL
             } else {// Exact or 1MM
                 int32 cbMatch1;
                 vector<uint64> cbMatchInd1;
-                matchCBtoWL(cbSeq1, cbQual1, cb.wl[cbLen1], cbMatch1, cbMatchInd1, cbMatchString); //cbMatchString is not used for now, multiple matches are not allowed
+                matchCBtoWL(cbSeq1, cbQual1, cb.wl[cbLen1], cb.wlHash[cbLen1], cbMatch1, cbMatchInd1, cbMatchQual); //cbMatchQual is not used for now, multiple matches are not allowed
                 if (cbMatch1<0) {//no match
                     cbMatchGood=false;
                     cbMatch = cbMatch1;
@@ -419,10 +415,6 @@ void SoloReadBarcode::getCBandUMI(char **readSeq, char **readQual, uint64 *readL
         };
         cbSeq.pop_back();//remove last "_" from file
         cbQual.pop_back();
-        
-        if (cbMatchGood) {
-            cbMatchString=to_string(cbMatchInd[0]);
-        };
     };
     
     addStats(cbMatch);
@@ -19,7 +19,7 @@ SoloReadFeature::SoloReadFeature(int32 feTy, Parameters &Pin, int iChunk)
 
     if (iChunk>=0) {
         //open with flagDelete=false, i.e. try to keep file if it exists
-        streamReads = &fstrOpen(P.outFileTmp+"/solo"+SoloFeatureTypes::Names[featureType]+'_'+std::to_string(iChunk), ERROR_OUT, P, false);
+        streamReads = new SoloReadRecords(P.outFileTmp+"/solo"+SoloFeatureTypes::Names[featureType]+'_'+std::to_string(iChunk), false, P);
     };
     
     if (featureType==SoloFeatureTypes::Transcript3p)
@@ -9,6 +9,7 @@
 #include "SoloCommon.h"
 #include "SoloReadFeatureStats.h"
 #include "ReadAnnotations.h"
+#include "SoloReadRecords.h"
 
 class SoloFeature;
 
@@ -24,7 +25,7 @@ public:
     
     bool readInfoYes ,readIndexYes;
 
-    fstream *streamReads;
+    SoloReadRecords *streamReads;
 
     string cbSeq, umiSeq, cbQual, umiQual;
 
@@ -37,7 +38,7 @@ public:
     void addCounts(const SoloReadFeature &soloCBin);
     void addStats(const SoloReadFeature &soloCBin);
     void statsOut(ofstream &streamOut);
-    void inputRecords(uint32 **cbP, uint32 cbPstride, vector<uint32> &cbReadCountTotal, vector<readInfoStruct> &readInfo, SoloReadFlagClass &readFlagCounts,
+    void inputRecords(uint32 **cbP, uint32 cbPstride, const vector<uint32> &indCBwl, vector<uint32> &cbReadCountTotal, vector<readInfoStruct> &readInfo, SoloReadFlagClass &readFlagCounts,
                       vector<uint32> &nReadPerCBunique1, vector<uint32> &nReadPerCBmulti1);
 
 private:
@@ -5,24 +5,23 @@
 #include "soloInputFeatureUMI.h"
 #include "serviceFuns.cpp"
 
-void SoloReadFeature::inputRecords(uint32 **cbP, uint32 cbPstride, vector<uint32> &cbReadCountTotal, vector<readInfoStruct> &readInfo, SoloReadFlagClass &readFlagCounts,
+void SoloReadFeature::inputRecords(uint32 **cbP, uint32 cbPstride, const vector<uint32> &indCBwl, vector<uint32> &cbReadCountTotal, vector<readInfoStruct> &readInfo, SoloReadFlagClass &readFlagCounts,
                                    vector<uint32> &nReadPerCBunique1, vector<uint32> &nReadPerCBmulti1)
-{   
-    streamReads->flush();
-    streamReads->seekg(0,std::ios::beg);
+{//cbP[iCB] points to the space for this thread's records of each detected CB. Can be called for several threads in parallel: readInfo elements are different for each read, nReadPerCB* are updated atomically
+
+    streamReads->rewind();
 
     //////////////////////////////////////////// standard features
     uint32 feature;
-    uint64 umi, iread, prevIread=(uint64)-1;
+    uint64 umi, iread, prevIread=(uint64)-1, cbIn;
     int32 cbmatch;
-    int64 cb;
-    vector<uint32> trIdDist;
+    int64 cb=-1;
+    vector<pair<uint32,char>> cbMult;
     
     uint64 nReadsIn = 0;
 
-    while (soloInputFeatureUMI(streamReads, featureType, readIndexYes, P.sjAll, iread, cbmatch, feature, umi, trIdDist, readFlagCounts)) {
+    while (soloInputFeatureUMI(streamReads, featureType, readIndexYes, P.sjAll, iread, cbmatch, feature, umi, cbIn, cbMult, readFlagCounts)) {
         if (feature == (uint32)(-1) && !readIndexYes) {//no feature => no record, this can happen for SJs
-            streamReads->ignore((uint32)-1, '\n');
             //stats.V[stats.noNoFeature]++; //need separate category for this
             continue;
         };
@@ -33,7 +32,7 @@ void SoloReadFeature::inputRecords(uint32 **cbP, uint32 cbPstride, vector<uint32
         bool noTooManyWLmatches = false;
 
         if (cbmatch<=1) {//single match
-            *streamReads >> cb;
+            cb=cbIn;
 
             if ( pSolo.CBmatchWL.oneExact && cbmatch==1 && cbReadCountTotal[cb]==0 ) {//single 1MM match, no exact matches to this CB
                 noMMtoWLwithoutExact = true;
@@ -41,7 +40,7 @@ void SoloReadFeature::inputRecords(uint32 **cbP, uint32 cbPstride, vector<uint32
             } else {
 
                 if (!pSolo.cbWLyes) {//if no-WL, the full cbInteger was recorded - now has to be placed in order
-                    cb=binarySearchExact<uintCB>(cb, pSolo.cbWL.data(), pSolo.cbWLsize);
+                    cb=pSolo.cbWLhash.find(cb, pSolo.cbWL.data());
                     if (cb+1 == 0)
                         continue; //this cb was not in the tentative WL
                 };
@@ -50,14 +49,14 @@ void SoloReadFeature::inputRecords(uint32 **cbP, uint32 cbPstride, vector<uint32
                 if (featGood) {//good feature, will be counted
                     readIsCounted = true;
 
-                    cbP[cb][0]=feature;
-                    cbP[cb][1]=umi;
+                    cbP[indCBwl[cb]][0]=feature;
+                    cbP[indCBwl[cb]][1]=umi;
 
                     if (readIndexYes) {
-                        cbP[cb][2]=iread;
+                        cbP[indCBwl[cb]][2]=iread;
                     };
 
-                    cbP[cb]+=cbPstride;
+                    cbP[indCBwl[cb]]+=cbPstride;
 
                 } else if (readInfoYes) {//no feature - record readInfo
                     readInfo[iread].cb=cb;
@@ -73,9 +72,8 @@ void SoloReadFeature::inputRecords(uint32 **cbP, uint32 cbPstride, vector<uint32
             #endif
 
             for (uint32 ii=0; ii<(uint32)cbmatch; ii++) {
-                uint32 cbin;
-                char  qin;
-                *streamReads >> cbin >> qin;
+                uint32 cbin=cbMult[ii].first;
+                char  qin=cbMult[ii].second;
                 if (cbReadCountTotal[cbin]>0) {//otherwise this cbin does not work
                     qin -= pSolo.QSbase;
                     qin = qin < pSolo.QSmax ? qin : pSolo.QSmax;
@@ -91,12 +89,12 @@ void SoloReadFeature::inputRecords(uint32 **cbP, uint32 cbPstride, vector<uint32
                 //record feature single-number feature
                 if (featGood) {
                     readIsCounted = true;
-                    cbP[cb][0]=feature;
-                    cbP[cb][1]=umi;
+                    cbP[indCBwl[cb]][0]=feature;
+                    cbP[indCBwl[cb]][1]=umi;
                     if (readIndexYes) {
-                        cbP[cb][2]=iread;
+                        cbP[indCBwl[cb]][2]=iread;
                     };
-                    cbP[cb]+=cbPstride;
+                    cbP[indCBwl[cb]]+=cbPstride;
                 } else if (readInfoYes) {//no feature - record readInfo
                     readInfo[iread].cb=cb;
                     readInfo[iread].umi=umi;
@@ -120,8 +118,10 @@ void SoloReadFeature::inputRecords(uint32 **cbP, uint32 cbPstride, vector<uint32
 
             if (readIsCounted) {
                 if (feature<geneMultMark) {
+                    #pragma omp atomic
                     nReadPerCBunique1[cb]++;
                 } else {
+                    #pragma omp atomic
                     nReadPerCBmulti1[cb]++;
                 };
             };
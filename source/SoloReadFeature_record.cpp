@@ -14,7 +14,7 @@ public:
     Transcript **alignOut;
 };
 
-uint32 outputReadCB(fstream *streamOut, const uint64 iRead, const int32 featureType, SoloReadBarcode &soloBar, 
+uint32 outputReadCB(SoloReadRecords *streamOut, const uint64 iRead, const int32 featureType, SoloReadBarcode &soloBar, 
                     const ReadSoloFeatures &reFe, const ReadAnnotations &readAnnot, const SoloReadFlagClass &readFlag);
 
 void SoloReadFeature::record(SoloReadBarcode &soloBar, uint nTr, Transcript **alignOut, uint64 iRead, ReadAnnotations &readAnnot)
@@ -165,10 +165,12 @@ void SoloReadFeature::record(SoloReadBarcode &soloBar, uint nTr, Transcript **al
                     sort(readAnnot.trVelocytoType.begin(), readAnnot.trVelocytoType.end(),
                          [](const trTypeStruct &t1, const trTypeStruct &t2) {return t1.tr < t2.tr;});
 
-                    *streamReads << iRead <<' '<< readAnnot.trVelocytoType.size();
-                    for (auto &tt: readAnnot.trVelocytoType)
-                         *streamReads <<' '<< tt.tr <<' '<< (uint32) tt.type;
-                    *streamReads <<'\n';
+                    streamReads->put<uint64>(iRead);
+                    streamReads->put<uint32>(readAnnot.trVelocytoType.size());
+                    for (auto &tt: readAnnot.trVelocytoType) {
+                         streamReads->put<uint32>(tt.tr);
+                         streamReads->put<uint8>(tt.type);
+                    };
                     nFeat=1;
                 } else {
                     stats.V[stats.noNoFeature]++;
@@ -204,14 +206,27 @@ void SoloReadFeature::record(SoloReadBarcode &soloBar, uint nTr, Transcript **al
     return;
 };
 
-uint32 outputReadCB(fstream *streamOut, const uint64 iRead, const int32 featureType, SoloReadBarcode &soloBar, 
+static void outputCB(SoloReadRecords *streamOut, const SoloReadBarcode &soloBar)
+{//cbMatch, then CB for one match, or CBs and qualities for multiple matches
+    streamOut->put<int32>(soloBar.cbMatch);
+    if (soloBar.cbMatch<=1) {
+        streamOut->put<uint64>(soloBar.cbMatchInd[0]);
+    } else {
+        for (uint32 ii=0; ii<soloBar.cbMatchInd.size(); ii++) {
+            streamOut->put<uint32>(soloBar.cbMatchInd[ii]);
+            streamOut->put<char>(soloBar.cbMatchQual[ii]);
+        };
+    };
+};
+
+uint32 outputReadCB(SoloReadRecords *streamOut, const uint64 iRead, const int32 featureType, SoloReadBarcode &soloBar, 
                     const ReadSoloFeatures &reFe, const ReadAnnotations &readAnnot, const SoloReadFlagClass &readFlag)
 {   
-    /*format of the temp output file
-     * UMI [iRead] type feature* cbMatchString
-     *             0=exact match, 1=one non-exact match, 2=multipe non-exact matches
-     *                   gene or sj[0] sj[1]
-     *                         CB or nCB {CB Qual, ...}
+    /*format of the binary records, fixed-width values
+     * uint64 UMI, [uint64 iRead, uint32 readFlag], feature, int32 cbMatch, CB
+     *                                              uint32 gene, or uint64 sj[0] and sj[1]
+     *                                                            0=exact match, 1=one non-exact match, >1=number of non-exact matches
+     *                                                                          uint64 CB, or {uint32 CB, char Qual} for each match
      */
     
     if (soloBar.pSolo.type==soloBar.pSolo.SoloTypes::SmartSeq && featureType!=-1) {//need to calculate "UMI" from align start/end
@@ -223,7 +238,11 @@ uint32 outputReadCB(fstream *streamOut, const uint64 iRead, const int32 featureT
     switch (featureType) {
         case -1 :
             //no feature, output for readInfo
-            *streamOut << soloBar.umiB <<' '<< iRead <<' '<< readFlag.flag <<' '<< -1 <<' '<< soloBar.cbMatch <<' '<< soloBar.cbMatchString <<'\n';
+            streamOut->put<uint64>(soloBar.umiB);
+            streamOut->put<uint64>(iRead);
+            streamOut->put<uint32>(readFlag.flag);
+            streamOut->put<uint32>((uint32)-1);//no-feature records are only output for the gene features that need readInfo or read stats
+            outputCB(streamOut, soloBar);
             break;
             
         case SoloFeatureTypes::Gene :
@@ -232,15 +251,20 @@ uint32 outputReadCB(fstream *streamOut, const uint64 iRead, const int32 featureT
         case SoloFeatureTypes::GeneFull_ExonOverIntron :
             if (reFe.geneMult.size()==0) {
                 //just gene id
-                *streamOut << soloBar.umiB <<' ';//UMI
-                if ( iRead != (uint64)-1 )
-                    *streamOut << iRead <<' '<< readFlag.flag <<' ';//iRead
-                *streamOut << reFe.gene <<' '<< soloBar.cbMatch <<' '<< soloBar.cbMatchString <<'\n';;
+                streamOut->put<uint64>(soloBar.umiB);//UMI
+                if ( iRead != (uint64)-1 ) {
+                    streamOut->put<uint64>(iRead);
+                    streamOut->put<uint32>(readFlag.flag);
+                };
+                streamOut->put<uint32>(reFe.gene);
+                outputCB(streamOut, soloBar);
             } else {
                 for (auto &g : reFe.geneMult) {
-                    *streamOut << soloBar.umiB <<' ';//UMI
-                    *streamOut << iRead <<' '<< readFlag.flag <<' ';//iRead is always output for multiGene
-                    *streamOut << g <<' '<< soloBar.cbMatch <<' '<< soloBar.cbMatchString <<'\n';;
+                    streamOut->put<uint64>(soloBar.umiB);//UMI
+                    streamOut->put<uint64>(iRead);//iRead is always output for multiGene
+                    streamOut->put<uint32>(readFlag.flag);
+                    streamOut->put<uint32>(g);
+                    outputCB(streamOut, soloBar);
                 };
                 nout = reFe.geneMult.size();
             };
@@ -249,29 +273,32 @@ uint32 outputReadCB(fstream *streamOut, const uint64 iRead, const int32 featureT
         case SoloFeatureTypes::SJ :
             //sj - two numbers, multiple sjs per read
             for (auto &sj : reFe.sj) {
-                *streamOut << soloBar.umiB <<' ';//UMI
-                if ( iRead != (uint64)-1 )
-                    *streamOut << iRead <<' '<< readFlag.flag <<' ';//iRead            
-                *streamOut << sj[0] <<' '<< sj[1] <<' '<< soloBar.cbMatch <<' '<< soloBar.cbMatchString <<'\n' << flush;
+                streamOut->put<uint64>(soloBar.umiB);//UMI
+                if ( iRead != (uint64)-1 ) {
+                    streamOut->put<uint64>(iRead);
+                    streamOut->put<uint32>(readFlag.flag);
+                };
+                streamOut->put<uint64>(sj[0]);
+                streamOut->put<uint64>(sj[1]);
+                outputCB(streamOut, soloBar);
             };
             nout=reFe.sj.size();
             break;
             
         case SoloFeatureTypes::Transcript3p :
-            //transcript,distToTTS structure    
-            *streamOut << soloBar.cbMatchString <<' ';            
-            *streamOut << soloBar.umiB <<' ';
-            *streamOut << readAnnot.transcriptConcordant.size();
+            //uint64 CB, uint64 UMI, uint32 nTr, {uint32 transcript, uint32 distToTTS} for each transcript, uint64 iRead
+            streamOut->put<uint64>(soloBar.cbMatchInd[0]);
+            streamOut->put<uint64>(soloBar.umiB);
+            streamOut->put<uint32>(readAnnot.transcriptConcordant.size());
             for (auto &tt: readAnnot.transcriptConcordant) {
-                *streamOut <<' '<< tt[0] <<' '<< tt[1];
+                streamOut->put<uint32>(tt[0]);
+                streamOut->put<uint32>(tt[1]);
             };
-            if ( iRead != (uint64)-1 )
-                *streamOut  <<' '<< iRead;//iRead
-            *streamOut  <<'\n';
+            streamOut->put<uint64>(iRead);
             nout=1;
 
             break;
     }; //switch (featureType)
     
     return nout;
-};
+};
\ No newline at end of file
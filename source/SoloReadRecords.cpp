@@ -0,0 +1,124 @@
+#include "SoloReadRecords.h"
+#include "streamFuns.h"
+#include "ErrorWarning.h"
+
+std::atomic<uint64> SoloReadRecords::blockMemTotal(0);
+
+SoloReadRecords::SoloReadRecords(string fileNameIn, bool flagDelete, Parameters &Pin) : P(Pin), fileName(fileNameIn)
+{
+    stream = &fstrOpen(fileName, ERROR_OUT, P, flagDelete);
+    block = new char [SOLO_READ_BLOCK_SIZE];
+    blockN = 0;
+    spill = false;
+    fileBytes = 0;
+
+    if (!flagDelete && P.runRestart.type==1) {//restarted run: the records were written to the file by the previous run
+        stream->seekg(0,ios::end);
+        fileBytes = stream->tellg();
+        spill = true;
+    };
+
+    readP = readEnd = NULL;
+    readBlockInd = readFileBytes = 0;
+    readBlockLast = false;
+};
+
+SoloReadRecords::~SoloReadRecords()
+{
+    for (auto &bm : blockMem) {
+        blockMemTotal -= bm.second;
+        delete [] bm.first;
+    };
+    delete [] block;
+    stream->close();
+    delete stream;
+};
+
+void SoloReadRecords::blockWrite()
+{//keep the full block in memory if it fits into --limitSoloReadsRAM, otherwise write it to the temporary file
+    if (blockN==0)
+        return;
+
+    if (!spill) {
+        if (blockMemTotal.fetch_add(blockN) + blockN <= P.limitSoloReadsRAM) {
+            blockMem.push_back({block, blockN});
+            block = new char [SOLO_READ_BLOCK_SIZE];
+            blockN = 0;
+            return;
+        };
+        blockMemTotal -= blockN;
+        spill = true;//the order of the records is preserved: the file follows the in-memory blocks
+    };
+
+    stream->seekp(fileBytes, ios::beg);
+    stream->write(block, blockN);
+    if (stream->fail()) {
+        ostringstream errOut;
+        errOut << "EXITING because of FATAL ERROR: could not write the Solo read records to the temporary file "<< fileName <<"\n";
+        errOut << "SOLUTION: check that the disk is not full, or increase --limitSoloReadsRAM\n";
+        exitWithError(errOut.str(), std::cerr, P.inOut->logMain, EXIT_CODE_FILE_WRITE, P);
+    };
+    fileBytes += blockN;
+    blockN = 0;
+};
+
+void SoloReadRecords::rewind()
+{
+    readP = readEnd = NULL;
+    readBlockInd = readFileBytes = 0;
+    readBlockLast = false;
+
+    if (fileBytes>0) {
+        stream->flush();
+        stream->clear(); //this is needed if eof was reached before
+        stream->seekg(0, ios::beg);
+        readBuf.resize(SOLO_READ_BLOCK_SIZE);
+    };
+};
+
+bool SoloReadRecords::readNext(uint64 nBytes)
+{//the next value does not fit into the readable bytes: go to the next in-memory block, the next part of the file, or the block being filled
+    while (true) {
+        uint64 nLeft = readEnd-readP;
+
+        if (readBlockInd < blockMem.size()) {//the values are not split between the blocks
+            readP = blockMem[readBlockInd].first;
+            readEnd = readP + blockMem[readBlockInd].second;
+            ++readBlockInd;
+
+        } else if (readFileBytes < fileBytes) {//the file is read in parts, the values can be split between the parts
+            if (nLeft>0)
+                memmove(readBuf.data(), readP, nLeft);
+            uint64 nRead = min(fileBytes-readFileBytes, (uint64) readBuf.size()-nLeft);
+            stream->read(readBuf.data()+nLeft, nRead);
+            if ((uint64) stream->gcount() != nRead) {
+                ostringstream errOut;
+                errOut << "EXITING because of FATAL ERROR: could not read the Solo read records from the temporary file "<< fileName <<"\n";
+                errOut << "SOLUTION: check that the temporary file was not modified or deleted during the run\n";
+                exitWithError(errOut.str(), std::cerr, P.inOut->logMain, EXIT_CODE_INPUT_FILES, P);
+            };
+            readFileBytes += nRead;
+            readP = readBuf.data();
+            readEnd = readP + nLeft + nRead;
+
+        } else if (!readBlockLast) {
+            readP = block;
+            readEnd = block + blockN;
+            readBlockLast = true;
+
+        } else {
+            return false;
+        };
+
+        if (readP+nBytes <= readEnd)
+            return true;
+    };
+};
+
+void SoloReadRecords::recordTruncated()
+{
+    ostringstream errOut;
+    errOut << "EXITING because of FATAL ERROR: truncated Solo read record in " << (fileBytes>0 ? "the temporary file " : "the records of ") << fileName <<"\n";
+    errOut << "SOLUTION: check that the temporary file was not modified or deleted during the run. If the run was restarted, re-run it from the start\n";
+    exitWithError(errOut.str(), std::cerr, P.inOut->logMain, EXIT_CODE_INCONSISTENT_DATA, P);
+};
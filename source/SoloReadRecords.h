@@ -0,0 +1,65 @@
+#ifndef H_SoloReadRecords
+#define H_SoloReadRecords
+
+#include "IncludeDefine.h"
+#include "Parameters.h"
+#include <atomic>
+#include <cstring>
+
+#define SOLO_READ_BLOCK_SIZE 1048576 //bytes of records in one block
+
+class SoloReadRecords {//binary records of the Solo reads of one thread: full blocks are kept in memory within --limitSoloReadsRAM, the rest is written to the temporary file
+public:
+    SoloReadRecords(string fileNameIn, bool flagDelete, Parameters &Pin);
+    ~SoloReadRecords();
+
+    template <typename T> void put(const T &v)
+    {//append one fixed-width value, values are never split between the blocks
+        if (blockN+sizeof(T) > SOLO_READ_BLOCK_SIZE)
+            blockWrite();
+        memcpy(block+blockN, &v, sizeof(T));
+        blockN += sizeof(T);
+    };
+
+    void rewind(); //start reading from the first record
+
+    template <typename T> bool get(T &v)
+    {//read one fixed-width value, returns false at the end of the records
+        if (readP+sizeof(T) > readEnd && !readNext(sizeof(T)))
+            return false;
+        memcpy(&v, readP, sizeof(T));
+        readP += sizeof(T);
+        return true;
+    };
+
+    template <typename T> void getRequired(T &v)
+    {//read one fixed-width value inside a record, the record cannot end here
+        if (!get(v))
+            recordTruncated();
+    };
+
+private:
+    Parameters &P;
+    string fileName;
+    fstream *stream; //records that did not fit into memory
+
+    char *block; //the block being filled
+    uint64 blockN; //bytes in the block
+    vector <pair<char*,uint64>> blockMem; //full blocks kept in memory, in the order they were written
+    bool spill; //blocks did not fit into memory, all further blocks are written to the file
+    uint64 fileBytes; //bytes written to the file
+    static std::atomic<uint64> blockMemTotal; //memory used by the in-memory blocks of all threads
+
+    //reading
+    char *readP, *readEnd; //current position and the end of the readable bytes
+    uint64 readBlockInd; //next in-memory block
+    uint64 readFileBytes; //bytes read from the file
+    bool readBlockLast; //the block being filled was reached
+    vector <char> readBuf; //buffer for reading the file
+
+    void blockWrite();
+    bool readNext(uint64 nBytes);
+    [[noreturn]] void recordTruncated();
+};
+
+#endif
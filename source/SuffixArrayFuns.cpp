@@ -1,5 +1,6 @@
 #include "SuffixArrayFuns.h"
 #include "PackedArray.h"
+#include "seqMatchLength.h"
 
 inline uint medianUint2(uint a, uint b)
 {
@@ -8,16 +9,21 @@ inline uint medianUint2(uint a, uint b)
 };
 
 uint compareSeqToGenome(Genome &mapGen, char** s2, uint S, uint N, uint L, uint iSA, bool dirR, bool& compRes)
+{
+    return compareSeqToGenomeSAstr(mapGen, s2, S, N, L, mapGen.SA[iSA], dirR, compRes);
+};
+
+uint compareSeqToGenomeSAstr(Genome &mapGen, char** s2, uint S, uint N, uint L, uint SAstr, bool dirR, bool& compRes)
 {
     /* compare s to g, find the maximum identity length
      * s2[0] read sequence; s2[1] complementary sequence
      * S position to start search from in s2[0],s2[1]
+     * SAstr suffix array value (genome position and strand) to compare with
      * dirR forward or reverse direction search on read sequence
      */
 
-    register int64 ii;
+    uint64 ii;
 
-    uint SAstr=mapGen.SA[iSA];
     bool dirG = (SAstr>>mapGen.GstrandBit) == 0; //forward or reverse strand of the genome
     SAstr &= mapGen.GstrandMask;
 
@@ -26,80 +32,35 @@ uint compareSeqToGenome(Genome &mapGen, char** s2, uint S, uint N, uint L, uint
     if (dirR && dirG) {//forward on read, forward on genome
         char* s  = s2[0] + S + L;
         g += SAstr + L;
-        for (ii=0;(uint) ii < N-L; ii++)
-        {
-            if (s[ii]!=g[ii])
-            {
-                if (s[ii]>g[ii])
-                {
-                    compRes=true;
-                    return ii+L;
-                } else
-                {
-                    compRes=false;
-                    return ii+L;
-                };
-            };
-        };
-//         if (s[ii]>g[ii]) {compRes=true;} else {compRes=false;};
-        return N; //exact match
+        ii=seqMatchLength(s, 1, g, 1, N-L, false);
+        if (ii==N-L)
+            return N; //exact match
+        compRes = s[ii]>g[ii];
+        return ii+L;
     } else if (dirR && !dirG) {
         char* s  = s2[1] + S + L;
         g += mapGen.nGenome-1-SAstr - L;
-        for (ii=0; (uint) ii < N-L; ii++)
-        {
-            if (s[ii]!=g[-ii])
-            {
-                if (s[ii]>g[-ii] || g[-ii]>3)
-                {
-                    compRes=false;
-                    return ii+L;
-                } else
-                {
-                    compRes=true;
-                    return ii+L;
-                };
-            };
-        };
-        return N;
+        ii=seqMatchLength(s, 1, g, -1, N-L, false);
+        if (ii==N-L)
+            return N;
+        compRes = !(s[ii]>g[-(int64)ii] || g[-(int64)ii]>3);
+        return ii+L;
     } else if (!dirR && dirG) {
         char* s  = s2[1] + S - L;
         g += SAstr + L;
-        for (ii=0; (uint) ii < N-L; ii++)
-        {
-            if (s[-ii]!=g[ii])
-            {
-                if (s[-ii]>g[ii]) {
-                    compRes=true;
-                    return ii+L;
-
-                } else
-                {
-                    compRes=false;
-                    return ii+L;
-                };
-            };
-        };
-        return N;
+        ii=seqMatchLength(s, -1, g, 1, N-L, false);
+        if (ii==N-L)
+            return N;
+        compRes = s[-(int64)ii]>g[ii];
+        return ii+L;
     } else {//if (!dirR && !dirG)
         char* s  = s2[0] + S - L;
         g += mapGen.nGenome-1-SAstr - L;
-        for (ii=0; (uint) ii < N-L; ii++)
-        {
-            if (s[-ii]!=g[-ii])
-            {
-                if (s[-ii]>g[-ii] || g[-ii]>3)
-                {
-                    compRes=false;
-                    return ii+L;
-                } else
-                {
-                    compRes=true;
-                    return ii+L;
-                };
-            };
-        };
-        return N;
+        ii=seqMatchLength(s, -1, g, -1, N-L, false);
+        if (ii==N-L)
+            return N;
+        compRes = !(s[-(int64)ii]>g[-(int64)ii] || g[-(int64)ii]>3);
+        return ii+L;
     };
 };
 
@@ -8,6 +8,7 @@
 
 uint medianUint2(uint, uint);
 uint compareSeqToGenome(Genome &mapGen, char** s2, uint S, uint N, uint L, uint iSA, bool dirR, bool& comparRes);
+uint compareSeqToGenomeSAstr(Genome &mapGen, char** s2, uint S, uint N, uint L, uint SAstr, bool dirR, bool& comparRes);
 uint findMultRange(Genome &mapGen, uint i3, uint L3, uint i1, uint L1, uint i1a, uint L1a, uint i1b, uint L1b, char** s, bool dirR, uint S);
 uint maxMappableLength(Genome &mapGen, char** s, uint S, uint N, uint i1, uint i2, bool dirR, uint& L, uint* indStartEnd);
 void writePacked(Genome &mapGen, char* a, uint jj, uint x);
@@ -0,0 +1,208 @@
+#include "SuffixArraySearchBatch.h"
+#include "SuffixArrayFuns.h"
+
+/* The binary search of maxMappableLength (including the two findMultRange searches) is split into probes.
+ * Each probe is performed in 3 stages: prefetch the SA element; read it and prefetch the genome sequence; compare the read to the genome.
+ * One stage of each active search is executed in turn, so that the memory accesses of different searches overlap.
+ * The sequence of probes is the same as in maxMappableLength, so the results are identical.
+ */
+
+static inline uint medianIndex(uint a, uint b)
+{//same as medianUint2
+    return a/2 + b/2 + (a%2 + b%2)/2;
+};
+
+SuffixArraySearchBatch::SuffixArraySearchBatch(Genome &mapGenIn) : mapGen(mapGenIn)
+{
+};
+
+void SuffixArraySearchBatch::searchOne(Genome &mapGen, Search &sa)
+{
+    if (sa.unique) {
+        bool compRes;
+        sa.L=compareSeqToGenome(mapGen, sa.s, sa.S, sa.N, sa.L, sa.i1, sa.dirR, compRes);
+        sa.indStartEnd[0]=sa.indStartEnd[1]=sa.i1;
+        sa.Nrep=1;
+    } else {
+        sa.Nrep=maxMappableLength(mapGen, sa.s, sa.S, sa.N, sa.i1, sa.i2, sa.dirR, sa.L, sa.indStartEnd);
+    };
+    sa.done=true;
+};
+
+void SuffixArraySearchBatch::searchAll(vector <Search> &searches, uint searchStart)
+{
+    searchActive.clear();
+    for (uint ii=searchStart; ii<searches.size(); ii++) {
+        if (searches[ii].done)
+            continue;
+        Search &sa=searches[ii];
+        if (sa.unique) {
+            probe(sa, sa.i1, sa.L, sa.N, phaseUnique);
+        } else {
+            probe(sa, sa.i1, sa.L, sa.N, phaseL1);
+        };
+        searchActive.push_back(ii);
+    };
+
+    while (searchActive.size()>0) {
+        for (uint ia=0; ia<searchActive.size(); ) {
+            Search &sa=searches[searchActive[ia]];
+            step(sa);
+            if (sa.done) {//remove from the active list
+                searchActive[ia]=searchActive.back();
+                searchActive.pop_back();
+            } else {
+                ++ia;
+            };
+        };
+    };
+};
+
+void SuffixArraySearchBatch::probe(Search &sa, uint iSA, uint L, uint N, int phase)
+{//next comparison of the read with the genome at SA index iSA
+    sa.probeInd=iSA;
+    sa.probeL=L;
+    sa.probeN=N;
+    sa.phase=phase;
+    sa.probeStage=0;
+};
+
+void SuffixArraySearchBatch::step(Search &sa)
+{
+    switch (sa.probeStage) {
+        case 0: {//prefetch SA element
+            char *saByte=mapGen.SA.charArray + sa.probeInd*mapGen.SA.wordLength/8;
+            __builtin_prefetch(saByte);
+            __builtin_prefetch(saByte+sizeof(uint)-1);//the element may cross the cache line boundary
+            sa.probeStage=1;
+            break;
+        };
+        case 1: {//read SA element, prefetch genome
+            sa.probeSAstr=mapGen.SA[sa.probeInd];
+            uint gPos=sa.probeSAstr & mapGen.GstrandMask;
+            if ( (sa.probeSAstr>>mapGen.GstrandBit) == 0 ) {
+                __builtin_prefetch(mapGen.G+gPos+sa.probeL);
+            } else {
+                __builtin_prefetch(mapGen.G+mapGen.nGenome-1-gPos-sa.probeL);
+            };
+            sa.probeStage=2;
+            break;
+        };
+        default: {//compare
+            uint Lprobe=compareSeqToGenomeSAstr(mapGen, sa.s, sa.S, sa.probeN, sa.probeL, sa.probeSAstr, sa.dirR, sa.compRes);
+            advance(sa, Lprobe);
+        };
+    };
+};
+
+void SuffixArraySearchBatch::advance(Search &sa, uint Lprobe)
+{//continue the search after a probe
+    switch (sa.phase) {
+        case phaseUnique:
+            sa.L=Lprobe;
+            sa.indStartEnd[0]=sa.indStartEnd[1]=sa.i1;
+            sa.Nrep=1;
+            sa.done=true;
+            break;
+
+        case phaseL1:
+            sa.L1=Lprobe;
+            probe(sa, sa.i2, sa.L, sa.N, phaseL2);
+            break;
+
+        case phaseL2:
+            sa.L2=Lprobe;
+            sa.L=min(sa.L1,sa.L2);
+            sa.L1a=sa.L1; sa.L1b=sa.L1; sa.i1a=sa.i1; sa.i1b=sa.i1;
+            sa.L2a=sa.L2; sa.L2b=sa.L2; sa.i2a=sa.i2; sa.i2b=sa.i2;
+            sa.i3=sa.i1; sa.L3=sa.L1;
+            loopNext(sa);
+            break;
+
+        case phaseLoop:
+            sa.L3=Lprobe;
+            if (sa.L3==sa.N) {//found exact match, exit the binary search
+                loopEnd(sa);
+                break;
+            };
+            if (sa.compRes) {//move 1 to 3
+                if (sa.L3>sa.L1) {
+                   sa.L1b=sa.L1a; sa.L1a=sa.L1; sa.i1b=sa.i1a; sa.i1a=sa.i1;
+                };
+                sa.i1=sa.i3; sa.L1=sa.L3;
+            } else {
+                if (sa.L3>sa.L2) {//move 2 to 3
+                   sa.L2b=sa.L2a; sa.L2a=sa.L2; sa.i2b=sa.i2a; sa.i2a=sa.i2;
+                };
+                sa.i2=sa.i3; sa.L2=sa.L3;
+            };
+            sa.L=min(sa.L1,sa.L2);
+            loopNext(sa);
+            break;
+
+        default: //phaseRange1, phaseRange2
+            if (Lprobe==sa.L3) {
+                sa.fa=sa.fc;
+            } else {
+                sa.fb=sa.fc; sa.fLb=Lprobe;
+            };
+            rangeNext(sa);
+    };
+};
+
+void SuffixArraySearchBatch::loopNext(Search &sa)
+{//main binary search loop
+    if (sa.i1+1<sa.i2) {
+        sa.i3=medianIndex(sa.i1,sa.i2);
+        probe(sa, sa.i3, sa.L, sa.N, phaseLoop);
+    } else {
+        loopEnd(sa);
+    };
+};
+
+void SuffixArraySearchBatch::loopEnd(Search &sa)
+{//choose the longest alignment, start findMultRange for the 1st boundary
+    if (sa.L3<sa.N) {
+        if (sa.L1>sa.L2) {
+            sa.i3=sa.i1; sa.L3=sa.L1;
+        } else {
+            sa.i3=sa.i2; sa.L3=sa.L2;
+        };
+    };
+
+    sa.fa=sa.i1a; sa.fb=sa.i1b; sa.fLb=sa.L1b;
+    if (sa.L1<sa.L3) {
+        sa.fLb=sa.L1; sa.fb=sa.i1; sa.fa=sa.i3;
+    } else if (sa.L1a<sa.L1) {
+        sa.fLb=sa.L1a; sa.fb=sa.i1a; sa.fa=sa.i1;
+    };
+    sa.phase=phaseRange1;
+    rangeNext(sa);
+};
+
+void SuffixArraySearchBatch::rangeNext(Search &sa)
+{//findMultRange loop
+    if ( (sa.fb+1<sa.fa) | (sa.fb>sa.fa+1) ) {
+        sa.fc=medianIndex(sa.fa,sa.fb);
+        probe(sa, sa.fc, sa.fLb, sa.L3, sa.phase);
+        return;
+    };
+
+    if (sa.phase==phaseRange1) {//1st boundary is found, start the 2nd
+        sa.indStartEnd[0]=sa.fa;
+
+        sa.fa=sa.i2a; sa.fb=sa.i2b; sa.fLb=sa.L2b;
+        if (sa.L2<sa.L3) {
+            sa.fLb=sa.L2; sa.fb=sa.i2; sa.fa=sa.i3;
+        } else if (sa.L2a<sa.L2) {
+            sa.fLb=sa.L2a; sa.fb=sa.i2a; sa.fa=sa.i2;
+        };
+        sa.phase=phaseRange2;
+        rangeNext(sa);
+    } else {
+        sa.indStartEnd[1]=sa.fa;
+        sa.L=sa.L3;
+        sa.Nrep=sa.indStartEnd[1]-sa.indStartEnd[0]+1;
+        sa.done=true;
+    };
+};
@@ -0,0 +1,48 @@
+#ifndef CODE_SuffixArraySearchBatch
+#define CODE_SuffixArraySearchBatch
+
+#include "IncludeDefine.h"
+#include "Genome.h"
+
+class SuffixArraySearchBatch {//interleaved binary searches of several seeds in the suffix array, to overlap the memory latency of the SA and genome accesses
+public:
+    struct Search {//one maximum mappable length search
+        //input
+        char **s; //read sequence and its complement
+        uint S, N; //start in the read, length
+        bool dirR; //forward/reverse direction in the read
+        bool unique; //i1==i2: only find the mappable length at i1
+        uint i1, i2; //initial SA range
+
+        //L: input: number of bases already matched; output: max mappable length
+        uint L, Nrep, indStartEnd[2];
+        bool done; //search is completed, output is ready
+
+        //batch search state
+        int phase, probeStage;
+        uint probeInd, probeL, probeN, probeSAstr;
+        bool compRes;
+        uint L1, L2, L3, i3, L1a, L1b, L2a, L2b, i1a, i1b, i2a, i2b; //same as in maxMappableLength
+        uint fa, fb, fc, fLb; //findMultRange bounds
+    };
+
+    SuffixArraySearchBatch(Genome &mapGenIn);
+
+    static void searchOne(Genome &mapGen, Search &sa); //one search at a time, standard SA search functions
+    void searchAll(vector <Search> &searches, uint searchStart); //interleave all searches from searchStart to the end of the vector
+
+private:
+    Genome &mapGen;
+    vector <uint> searchActive; //searches that are not done
+
+    enum {phaseUnique, phaseL1, phaseL2, phaseLoop, phaseRange1, phaseRange2};
+
+    void probe(Search &sa, uint iSA, uint L, uint N, int phase);
+    void step(Search &sa);
+    void advance(Search &sa, uint Lprobe);
+    void loopNext(Search &sa);
+    void loopEnd(Search &sa);
+    void rangeNext(Search &sa);
+};
+
+#endif
@@ -3,5 +3,6 @@
 ThreadControl::ThreadControl() {
     chunkInN=0;
     chunkOutN=0;
+    chunkInReader=NULL;
 //     chunkOutBAMposition=new uint [MAX_chunkOutBAMposition];
 };
\ No newline at end of file
@@ -6,15 +6,18 @@
 
 #define MAX_chunkOutBAMposition 100000
 
+class ChunkInReader;
+
 class ThreadControl {
 public:
     bool threadBool;
 
     pthread_t *threadArray;
-    pthread_mutex_t mutexInRead, mutexOutSAM, mutexOutBAM1, mutexOutChimSAM, mutexOutChimJunction, mutexOutUnmappedFastx, mutexOutFilterBySJout;
+    pthread_mutex_t mutexOutSAM, mutexOutBAM1, mutexOutChimSAM, mutexOutChimJunction, mutexOutUnmappedFastx, mutexOutFilterBySJout;
     pthread_mutex_t mutexStats, mutexLogMain, mutexBAMsortBins, mutexError;
 
     uint chunkInN,chunkOutN;
+    ChunkInReader *chunkInReader; //loads input reads in a separate thread
 
     ThreadControl();
 
@@ -2,8 +2,16 @@
 #include "BAMfunctions.h"
 #include "BAMbinSortByCoordinate.h"
 #include "BAMbinSortUnmapped.h"
+#include "BAMbinSplit.h"
+#include "radixSort.h"
+#include "BAMindex.h"
 #include "ErrorWarning.h"
-#include "bam_cat.h"
+#include "BAMbinWrite.h"
+#include <fcntl.h>
+#include <omp.h>
+#include <unistd.h>
+
+#define BGZF_EOF_SIZE 28
 
 void bamSortByCoordinate (Parameters &P, ReadAlignChunk **RAchunk, Genome &genome, Solo &solo) {
     if (P.outBAMcoord) {//sort BAM if needed
@@ -11,27 +19,75 @@ void bamSortByCoordinate (Parameters &P, ReadAlignChunk **RAchunk, Genome &genom
         P.inOut->logMain << timeMonthDayTime() << " ..... started sorting BAM\n" <<flush;
         uint32 nBins=P.outBAMcoordNbins;
 
-        //check max size needed for sorting
-        uint maxMem=0;
-        for (uint32 ibin=0; ibin<nBins-1; ibin++) {//check all bins
-            uint binS=0;
+        //coordinates sketch from all threads
+        vector <uint64> coordSketch;
+        for (int it=0; it<P.runThreadN; it++)
+            coordSketch.insert(coordSketch.end(), RAchunk[it]->chunkOutBAMcoord->coordSketch.begin(), RAchunk[it]->chunkOutBAMcoord->coordSketch.end());
+        radixSortUint64(coordSketch.data(), coordSketch.size(), 1, P.outBAMsortingThreadNactual);
+
+        //collect the bins, the bins that do not fit into the per-thread share of the sorting RAM are split into parts
+        uint64 partMemMax=P.limitBAMsortRAM/P.outBAMsortingThreadNactual;
+        vector <vector <BAMsortBin>> binParts(nBins);
+        uint64 binsMem=0;//memory used by the in-memory bins before splitting
+        #pragma omp parallel for num_threads(P.outBAMsortingThreadNactual) schedule (dynamic,1) reduction(+:binsMem)
+        for (uint32 ibin=0; ibin<nBins; ibin++) {
+            uint binN=0, binS=0, binM=0;
             for (int it=0; it<P.runThreadN; it++) {//collect sizes from threads
-                binS += RAchunk[it]->chunkOutBAMcoord->binTotalBytes[ibin]+24*RAchunk[it]->chunkOutBAMcoord->binTotalN[ibin];
+                binN += RAchunk[it]->chunkOutBAMcoord->binTotalN[ibin];
+                binS += RAchunk[it]->chunkOutBAMcoord->binTotalBytes[ibin];
+                binM += RAchunk[it]->chunkOutBAMcoord->binMemBytes[ibin];
             };
-            if (binS>maxMem) maxMem=binS;
+            binsMem += binM;
+            if (binS==0) continue; //empty bin
+
+            if (ibin<nBins-1 && binS+24*binN > partMemMax) {//split at the quantiles of the sketch coordinates inside the bin
+                auto sk1=std::lower_bound(coordSketch.begin(), coordSketch.end(), P.outBAMsortingBinStart[ibin]);
+                auto sk2=(ibin<nBins-2 ? std::lower_bound(coordSketch.begin(), coordSketch.end(), P.outBAMsortingBinStart[ibin+1]) : coordSketch.end());
+                uint64 partSketchN=max((uint64) 1, (uint64) (sk2-sk1)*partMemMax/(binS+24*binN));//number of sketch coordinates per part
+                vector <uint64> partStart;
+                for (auto sk=sk1+partSketchN; sk<sk2; sk+=partSketchN) {
+                    if (*sk>(partStart.size()>0 ? partStart.back() : P.outBAMsortingBinStart[ibin])) //equal coordinates cannot be split
+                        partStart.push_back(*sk);
+                };
+                if (partStart.size()>0) {
+                    BAMbinSplit(ibin, partStart, P.runThreadN, P.outBAMsortTmpDir, P, RAchunk, binParts[ibin]);
+                    #pragma omp critical
+                    P.inOut->logMain << "BAM sorting: bin " << ibin << " of size " << binS+24*binN << " was split into " << binParts[ibin].size() << " parts\n";
+                    continue;
+                };
+            };
+            binParts[ibin].push_back({ibin, -1, binN, binS, binM, {}, NULL});
         };
+        vector <BAMsortBin> sortBins;//in the order of the output
+        for (auto &bp : binParts)
+            sortBins.insert(sortBins.end(), bp.begin(), bp.end());
 
-        uint64 unmappedReadsN = 0;
-        for (int it=0; it<P.runThreadN; it++)
-            unmappedReadsN += RAchunk[it]->chunkOutBAMcoord->binTotalN[nBins-1];
+        BAMindex *bamIndex=NULL;//the index is built from the pieces of the sorted bins
+        vector <BAMindexPiece*> indexPieces;
+        if (P.outBAMsortingIndex.yes) {
+            bamIndex=new BAMindex(P, genome);
+            for (auto &sb : sortBins) {
+                sb.index=bamIndex->newPiece();
+                indexPieces.push_back(sb.index);
+            };
+        };
+
+        //check max size needed for sorting
+        uint maxMem=0;
+        for (auto &sb : sortBins) {
+            if (sb.iBin<nBins-1 && sb.binS+24*sb.binN>maxMem)
+                maxMem=sb.binS+24*sb.binN;
+        };
 
         P.inOut->logMain << "Max memory needed for sorting = "<<maxMem<<endl;
+        if (P.limitBAMsortBinsRAM>0)
+            P.inOut->logMain << "BAM sorting bins kept in memory: "<<binsMem<<" bytes, the rest is in the temporary files"<<endl;
         if (maxMem>P.limitBAMsortRAM) {
             ostringstream errOut;
             errOut <<"EXITING because of fatal ERROR: not enough memory for BAM sorting: \n";
             errOut <<"SOLUTION: re-run STAR with at least --limitBAMsortRAM " <<maxMem+1000000000;
             exitWithError(errOut.str(), std::cerr, P.inOut->logMain, EXIT_CODE_PARAMETER, P);
-        } else if(maxMem==0 && unmappedReadsN==0) {//both mapped and unmapped reads are absent
+        } else if(sortBins.size()==0) {//both mapped and unmapped reads are absent
             P.inOut->logMain << "WARNING: nothing to sort - no output alignments" <<endl;
             BGZF *bgzfOut;
             bgzfOut=bgzf_open(P.outBAMfileCoordName.c_str(),("w"+to_string((long long) P.outBAMcompression)).c_str());
@@ -43,55 +99,135 @@ void bamSortByCoordinate (Parameters &P, ReadAlignChunk **RAchunk, Genome &genom
             };
             outBAMwriteHeader(bgzfOut,P.samHeaderSortedCoord,genome.chrNameAll,genome.chrLengthAll);
             bgzf_close(bgzfOut);
+            if (bamIndex!=NULL) {
+                vector <uint64> pieceOffset;
+                bamIndex->write(indexPieces, pieceOffset, P.outBAMfileCoordName+(bamIndex->csi ? ".csi" : ".bai"));
+            };
         } else {//sort
-            uint totalMem=0;
-            #pragma omp parallel num_threads(P.outBAMsortingThreadNactual)
-            #pragma omp for schedule (dynamic,1)
-            for (uint32 ibin1=0; ibin1<nBins; ibin1++) {
-                uint32 ibin=nBins-1-ibin1;//reverse order to start with the last bin - unmapped reads
+            //the BAM header is written first, the sorted bins are compressed into BGZF blocks of the same level and placed after it
+            BGZF *bgzfOut;
+            bgzfOut=bgzf_open(P.outBAMfileCoordName.c_str(),("w"+to_string((long long) P.outBAMcompression)).c_str());
+            if (bgzfOut==NULL) {
+                ostringstream errOut;
+                errOut <<"EXITING because of fatal ERROR: could not open output bam file: " << P.outBAMfileCoordName << "\n";
+                errOut <<"SOLUTION: check that the disk is not full, increase the max number of open files with Linux command ulimit -n before running STAR";
+                exitWithError(errOut.str(), std::cerr, P.inOut->logMain, EXIT_CODE_PARAMETER, P);
+            };
+            outBAMwriteHeader(bgzfOut,P.samHeaderSortedCoord,genome.chrNameAll,genome.chrLengthAll);
+            int compressLevel=bgzfOut->compress_level;
+            bgzf_close(bgzfOut);
 
-                uint binN=0, binS=0;
-                for (int it=0; it<P.runThreadN; it++) {//collect sizes from threads
-                    binN += RAchunk[it]->chunkOutBAMcoord->binTotalN[ibin];
-                    binS += RAchunk[it]->chunkOutBAMcoord->binTotalBytes[ibin];
-                };
+            BAMsortThreads sortThreads;
+            sortThreads.nThreads=P.outBAMsortingThreadNactual;
+            sortThreads.binsWaiting=sortBins.size()-(sortBins.back().iBin==nBins-1 ? 1 : 0);//mapped bins that have not started sorting yet
+            sortThreads.binsSorting=0;
 
-                if (binS==0) continue; //empty bin
+            uint totalMem=0;//memory already used by the in-memory bins, the split bins were released
+            for (auto &sb : sortBins)
+                totalMem += sb.binM;
+            int ompMaxActiveLevels=omp_get_max_active_levels();
+            omp_set_max_active_levels(2);//bins that are still sorting when no bins are waiting use several threads
+            #pragma omp parallel num_threads(P.outBAMsortingThreadNactual)
+            #pragma omp for schedule (dynamic,1)
+            for (uint32 isb1=0; isb1<sortBins.size(); isb1++) {
+                BAMsortBin &sortBin=sortBins[sortBins.size()-1-isb1];//reverse order to start with the last bin - unmapped reads
 
-                if (ibin == nBins-1) {//last bin for unmapped reads
-                    BAMbinSortUnmapped(ibin,P.runThreadN,P.outBAMsortTmpDir, P, genome, solo);
+                if (sortBin.iBin == nBins-1) {//last bin for unmapped reads
+                    BAMbinSortUnmapped(sortBin.iBin,P.runThreadN,P.outBAMsortTmpDir, P, solo, compressLevel, sortThreads, sortBin.index);
                 } else {
-                    uint newMem=binS+binN*24;
+                    uint newMem=sortBin.binS+sortBin.binN*24-sortBin.binM;//in-memory part of the bin is already counted
                     bool boolWait=true;
                     while (boolWait) {
                         #pragma omp critical
-                        if (totalMem+newMem < P.limitBAMsortRAM) {
+                        if (totalMem+newMem < P.limitBAMsortRAM || sortThreads.binsSorting==0) {//if no other bins are being sorted, this bin has to proceed
                             boolWait=false;
                             totalMem+=newMem;
+                            ++sortThreads.binsSorting;
+                            --sortThreads.binsWaiting;
                         };
                         sleep(0.1);
                     };
-                    BAMbinSortByCoordinate(ibin,binN,binS,P.runThreadN,P.outBAMsortTmpDir, P, genome, solo);
+                    BAMbinSortByCoordinate(sortBin,P.runThreadN,P.outBAMsortTmpDir, P, solo, RAchunk, compressLevel, sortThreads);
                     #pragma omp critical
-                    totalMem-=newMem;//"release" RAM
+                    {
+                        totalMem-=newMem+sortBin.binM;//"release" RAM
+                        --sortThreads.binsSorting;
+                    };
+                };
+            };
+            omp_set_max_active_levels(ompMaxActiveLevels);
+
+            //concatenate the bins: each bin is copied to its offset in the output file in parallel
+            uint32 nSortBins=sortBins.size();
+            vector <string> binFileName(nSortBins);
+            vector <uint64> binOffset(nSortBins+1, 0);
+            struct stat statBuf;
+            if (stat(P.outBAMfileCoordName.c_str(), &statBuf) != 0) {
+                ostringstream errOut;
+                errOut <<"EXITING because of fatal ERROR: could not stat output bam file: " << P.outBAMfileCoordName << "\n";
+                errOut <<"SOLUTION: check that the disk is not full";
+                exitWithError(errOut.str(), std::cerr, P.inOut->logMain, EXIT_CODE_FILE_WRITE, P);
+            };
+            binOffset[0]=statBuf.st_size-BGZF_EOF_SIZE;//overwrite the EOF block after the header
+            for (uint32 ibin=0; ibin<nSortBins; ibin++) {
+                binFileName[ibin]=P.outBAMsortTmpDir+"/b"+sortBins[ibin].name();
+                binOffset[ibin+1]=binOffset[ibin];
+                if (stat(binFileName[ibin].c_str(), &statBuf) == 0) {//empty bins have no files
+                    binOffset[ibin+1]+=statBuf.st_size;
+                } else {
+                    binFileName[ibin]="";
                 };
             };
 
-            //concatenate all BAM files, using bam_cat
-            char **bamBinNames = new char* [nBins];
-            vector <string> bamBinNamesV;
-            for (uint32 ibin=0; ibin<nBins; ibin++) {
+            int fdOut=open(P.outBAMfileCoordName.c_str(), O_WRONLY);
+            if (fdOut<0) {
+                ostringstream errOut;
+                errOut <<"EXITING because of fatal ERROR: could not open output bam file: " << P.outBAMfileCoordName << "\n";
+                errOut <<"SOLUTION: check that the disk is not full, increase the max number of open files with Linux command ulimit -n before running STAR";
+                exitWithError(errOut.str(), std::cerr, P.inOut->logMain, EXIT_CODE_PARAMETER, P);
+            };
 
-                bamBinNamesV.push_back(P.outBAMsortTmpDir+"/b"+std::to_string((uint) ibin));
-                struct stat buffer;
-                if (stat (bamBinNamesV.back().c_str(), &buffer) != 0) {//check if file exists
-                    bamBinNamesV.pop_back();
+            const uint64 copyBufferSize=8*1024*1024;
+            bool copyError=false;
+            #pragma omp parallel num_threads(P.outBAMsortingThreadNactual) reduction(||:copyError)
+            {
+                char *copyBuffer=new char[copyBufferSize];
+                #pragma omp for schedule (dynamic,1)
+                for (uint32 ibin=0; ibin<nSortBins; ibin++) {
+                    if (binFileName[ibin].empty())
+                        continue;
+                    int fdBin=open(binFileName[ibin].c_str(), O_RDONLY);
+                    if (fdBin<0) {
+                        copyError=true;
+                        continue;
+                    };
+                    for (uint64 offset=binOffset[ibin]; offset<binOffset[ibin+1]; ) {
+                        ssize_t readN=read(fdBin, copyBuffer, min(copyBufferSize, binOffset[ibin+1]-offset));
+                        if (readN<=0 || pwrite(fdOut, copyBuffer, readN, offset)!=readN) {
+                            copyError=true;
+                            break;
+                        };
+                        offset+=readN;
+                    };
+                    close(fdBin);
+                    remove(binFileName[ibin].c_str());
                 };
+                delete [] copyBuffer;
+            };
+
+            const uint8 bgzfEOF[BGZF_EOF_SIZE]={0x1f,0x8b,0x08,0x04,0x00,0x00,0x00,0x00,0x00,0xff,0x06,0x00,0x42,0x43,0x02,0x00,0x1b,0x00,0x03,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00};
+            if (copyError || pwrite(fdOut, bgzfEOF, BGZF_EOF_SIZE, binOffset[nSortBins])!=BGZF_EOF_SIZE || ftruncate(fdOut, binOffset[nSortBins]+BGZF_EOF_SIZE)!=0 || close(fdOut)!=0) {
+                ostringstream errOut;
+                errOut <<"EXITING because of fatal ERROR: could not write sorted BAM bins into the output bam file: " << P.outBAMfileCoordName << "\n";
+                errOut <<"SOLUTION: check that the disk is not full";
+                exitWithError(errOut.str(), std::cerr, P.inOut->logMain, EXIT_CODE_FILE_WRITE, P);
             };
-            for (uint32 ibin=0; ibin<bamBinNamesV.size(); ibin++) {
-                    bamBinNames[ibin] = (char*) bamBinNamesV.at(ibin).c_str();
+
+            if (bamIndex!=NULL) {
+                bamIndex->write(indexPieces, binOffset, P.outBAMfileCoordName+(bamIndex->csi ? ".csi" : ".bai"));
+                P.inOut->logMain << timeMonthDayTime() << " ..... finished indexing sorted BAM\n" <<flush;
             };
-            bam_cat(bamBinNamesV.size(), bamBinNames, 0, P.outBAMfileCoordName.c_str());
         };
-    };    
+        delete bamIndex;
+    };
 };
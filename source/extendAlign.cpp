@@ -2,6 +2,7 @@
 #include "Parameters.h"
 #include "Transcript.h"
 #include "extendAlign.h"
+#include "seqMatchLength.h"
 
 bool extendAlign( char* R, char* G, uint rStart, uint gStart, int dR, int dG, uint L, uint Lprev, uint nMMprev, uint nMMmax, double pMMmax, bool extendToEnd, Transcript* trA ) {
 
@@ -15,10 +16,22 @@ trA->maxScore=0;
 R=R+rStart;
 G=G+gStart;
 
+//runs of matches are skipped with the vectorized comparison, they cannot extend past the chr boundary at the genome start
+uint Lrun = dG<0 ? min(L, gStart+1) : L;
+
 if (extendToEnd) {//end to end extension
 
     int iExt;
     for (iExt=0;iExt<(int) L;iExt++) {
+        if (iExt<(int) Lrun) {//run of matches
+            int nRun=(int) seqMatchLength(R+dR*iExt, dR, G+dG*iExt, dG, Lrun-iExt, true);
+            nMatch += nRun;
+            Score += scoreMatch*nRun;
+            iExt += nRun;
+            if (iExt==(int) L)
+                break;
+        };
+
         iS=dR*iExt;
         iG=dG*iExt;
 
@@ -57,6 +70,23 @@ if (extendToEnd) {//end to end extension
 
 
 for (int i=0;i<(int) L;i++) {
+    if (i<(int) Lrun) {//run of matches: Score increases, only the last match of the run can be the new maximum
+        int nRun=(int) seqMatchLength(R+dR*i, dR, G+dG*i, dG, Lrun-i, true);
+        if (nRun>0) {
+            nMatch += nRun;
+            Score += scoreMatch*nRun;
+            i += nRun;
+            if (Score>trA->maxScore && nMM+nMMprev <= min(pMMmax*double(Lprev+i), double(nMMmax)) ) {//same as for a single match below, at the last match i-1
+                trA->extendL=i;
+                trA->maxScore=Score;
+                trA->nMatch=nMatch;
+                trA->nMM=nMM;
+            };
+            if (i==(int) L)
+                break;
+        };
+    };
+
     iS=dR*i;
     iG=dG*i;
 
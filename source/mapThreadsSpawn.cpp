@@ -2,10 +2,41 @@
 #include "ThreadControl.h"
 #include "GlobalVariables.h"
 #include "ErrorWarning.h"
+#include "ChunkInReader.h"
+
+#ifdef __linux__
+static void threadCPUset(const vector <int> &cpus, cpu_set_t &cpuSet)
+{
+    CPU_ZERO(&cpuSet);
+    for (auto &cpu1 : cpus)
+        CPU_SET(cpu1, &cpuSet);
+};
+#endif
 
 void mapThreadsSpawn (Parameters &P, ReadAlignChunk** RAchunk) {
+    pthread_t threadReader;
+    if (P.outFilterBySJoutStage<2) {//reads are loaded from the input files by a dedicated thread
+        g_threadChunks.chunkInReader = new ChunkInReader(P);
+        int threadStatus=pthread_create(&threadReader, NULL, &ChunkInReader::threadReadChunks, (void *) g_threadChunks.chunkInReader);
+        if (threadStatus>0) {//something went wrong with the thread
+                ostringstream errOut;
+                errOut << "EXITING because of FATAL ERROR: phtread error while creating input reader thread, error code: "<<threadStatus ;
+                exitWithError(errOut.str(),std::cerr, P.inOut->logMain, 1, P);
+        };
+    };
+
     for (int ithread=1;ithread<P.runThreadN;ithread++) {//spawn threads
-        int threadStatus=pthread_create(&g_threadChunks.threadArray[ithread], NULL, &g_threadChunks.threadRAprocessChunks, (void *) RAchunk[ithread]);
+        pthread_attr_t threadAttr;
+        pthread_attr_init(&threadAttr);
+        #ifdef __linux__
+        if (!RAchunk[ithread]->threadCPUs.empty()) {//pin the thread to the NUMA node of its genome
+            cpu_set_t cpuSet;
+            threadCPUset(RAchunk[ithread]->threadCPUs, cpuSet);
+            pthread_attr_setaffinity_np(&threadAttr, sizeof(cpuSet), &cpuSet);
+        };
+        #endif
+        int threadStatus=pthread_create(&g_threadChunks.threadArray[ithread], &threadAttr, &g_threadChunks.threadRAprocessChunks, (void *) RAchunk[ithread]);
+        pthread_attr_destroy(&threadAttr);
         if (threadStatus>0) {//something went wrong with one of threads
                 ostringstream errOut;
                 errOut << "EXITING because of FATAL ERROR: phtread error while creating thread # " << ithread <<", error code: "<<threadStatus ;
@@ -16,8 +47,23 @@ void mapThreadsSpawn (Parameters &P, ReadAlignChunk** RAchunk) {
         pthread_mutex_unlock(&g_threadChunks.mutexLogMain);
     };
 
+    #ifdef __linux__
+    cpu_set_t cpuSetMain; //main thread processes chunk 0, its affinity is restored after mapping
+    bool pinMain = !RAchunk[0]->threadCPUs.empty() && pthread_getaffinity_np(pthread_self(), sizeof(cpuSetMain), &cpuSetMain)==0;
+    if (pinMain) {
+        cpu_set_t cpuSet;
+        threadCPUset(RAchunk[0]->threadCPUs, cpuSet);
+        pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet);
+    };
+    #endif
+
     RAchunk[0]->processChunks(); //start main thread
 
+    #ifdef __linux__
+    if (pinMain)
+        pthread_setaffinity_np(pthread_self(), sizeof(cpuSetMain), &cpuSetMain);
+    #endif
+
     for (int ithread=1;ithread<P.runThreadN;ithread++) {//wait for all threads to complete
         int threadStatus = pthread_join(g_threadChunks.threadArray[ithread], NULL);
         if (threadStatus>0) {//something went wrong with one of threads
@@ -29,5 +75,16 @@ void mapThreadsSpawn (Parameters &P, ReadAlignChunk** RAchunk) {
         P.inOut->logMain << "Joined thread # " <<ithread <<"\n"<<flush;
         pthread_mutex_unlock(&g_threadChunks.mutexLogMain);
     };
+
+    if (g_threadChunks.chunkInReader != NULL) {
+        int threadStatus = pthread_join(threadReader, NULL);
+        if (threadStatus>0) {//something went wrong with the thread
+                ostringstream errOut;
+                errOut << "EXITING because of FATAL ERROR: phtread error while joining input reader thread, error code: "<<threadStatus ;
+                exitWithError(errOut.str(),std::cerr, P.inOut->logMain, 1, P);
+        };
+        delete g_threadChunks.chunkInReader;
+        g_threadChunks.chunkInReader=NULL;
+    };
 };
 
@@ -1,7 +1,6 @@
 #include "ReadAlignChunk.h"
 #include "Parameters.h"
 #include "OutSJ.h"
-#include <limits.h>
 #include "ErrorWarning.h"
 
 int compareUint(const void* i1, const void* i2) {//compare uint arrays
@@ -20,42 +19,16 @@ int compareUint(const void* i1, const void* i2) {//compare uint arrays
 void outputSJ(ReadAlignChunk** RAchunk, Parameters& P) {//collapses junctions from all therads/chunks; outputs junctions to file
 
     Junction oneSJ(RAchunk[0]->RA->genOut);
-    char** sjChunks = new char* [P.runThreadN+1];
     #define OUTSJ_limitScale 2
     OutSJ allSJ (P.limitOutSJcollapsed*OUTSJ_limitScale, P, RAchunk[0]->RA->genOut);
 
-    if (P.outFilterBySJoutStage!=1) {//chunkOutSJ
-        for (int ic=0;ic<P.runThreadN;ic++) {//populate sjChunks with links to data
-            sjChunks[ic]=RAchunk[ic]->chunkOutSJ->data;
-            memset(sjChunks[ic]+RAchunk[ic]->chunkOutSJ->N*oneSJ.dataSize,255,oneSJ.dataSize);//mark the junction after last with big number
-        };
-    } else {//chunkOutSJ1
-        for (int ic=0;ic<P.runThreadN;ic++) {//populate sjChunks with links to data
-            sjChunks[ic]=RAchunk[ic]->chunkOutSJ1->data;
-            memset(sjChunks[ic]+RAchunk[ic]->chunkOutSJ1->N*oneSJ.dataSize,255,oneSJ.dataSize);//mark the junction after last with big number
-        };
-    };
-
-    while (true) {
-        int icOut=-1;//chunk from which the junction is output
-        for (int ic=0;ic<P.runThreadN;ic++) {//scan through all chunks, find the "smallest" junction
-            if ( *(uint*)(sjChunks[ic])<ULONG_MAX && (icOut==-1 ||compareSJ((void*) sjChunks[ic], (void*) sjChunks[icOut])<0 ) ) {
-                    icOut=ic;
-                };
-        };
+    //junctions from all threads/chunks were collected in the shared table while mapping
+    OutSJtable *sjTable = P.outFilterBySJoutStage!=1 ? RAchunk[0]->sjTable : RAchunk[0]->sjTable1;
+    sjTable->collect(allSJ);
 
-        if (icOut<0) break; //no more junctions to output
-
-        for (int ic=0;ic<P.runThreadN;ic++) {//scan through all chunks, find the junctions equal to icOut-junction
-            if (ic!=icOut && compareSJ((void*) sjChunks[ic], (void*) sjChunks[icOut])==0) {
-                oneSJ.collapseOneSJ(sjChunks[icOut],sjChunks[ic],P);//collapse ic-junction into icOut
-                sjChunks[ic] += oneSJ.dataSize;//shift ic-chunk by one junction
-            };
-        };
-
-        //write out the junction
-        oneSJ.junctionPointer(sjChunks[icOut],0);//point to the icOut junction
-        //filter the junction
+    uint64 nSJpass=0, nSJcollapsedPass=0;
+    for (uint64 ii=0; ii<allSJ.N; ii++) {//filter the junctions
+        oneSJ.junctionPointer(allSJ.data,ii);
         bool sjFilter;
         sjFilter=*oneSJ.annot>0 \
                 || ( ( *oneSJ.countUnique>=(uint) P.outSJfilterCountUniqueMin[(*oneSJ.motif+1)/2] \
@@ -64,23 +37,16 @@ void outputSJ(ReadAlignChunk** RAchunk, Parameters& P) {//collapses junctions fr
                 && *oneSJ.overhangRight >= (uint) P.outSJfilterOverhangMin[(*oneSJ.motif+1)/2] \
                 && ( (*oneSJ.countMultiple+*oneSJ.countUnique)>P.outSJfilterIntronMaxVsReadN.size() || *oneSJ.gap<=(uint) P.outSJfilterIntronMaxVsReadN[*oneSJ.countMultiple+*oneSJ.countUnique-1]) );
 
-        if (sjFilter) {//record the junction in all SJ
-            memcpy(allSJ.data+allSJ.N*oneSJ.dataSize,sjChunks[icOut],oneSJ.dataSize);
-            allSJ.N++;
-            if (allSJ.N == allSJ.Nstore-1 ) {
-                /*
-                ostringstream errOut;
-                errOut <<"EXITING because of fatal error: buffer size for SJ output is too small\n";
-                errOut <<"Solution: increase input parameter --limitOutSJcollapsed\n";
-                exitWithError(errOut.str(),std::cerr, P.inOut->logMain, EXIT_CODE_INPUT_FILES, P);
-                */
-                allSJ.dataSizeIncrease();
-                P.inOut->logMain << "Increased the size of chunkOutSJ to " << allSJ.Nstore <<'\n';
-            };
+        if (sjFilter) {//keep the junction in all SJ
+            if (nSJpass<ii)
+                memcpy(allSJ.data+nSJpass*oneSJ.dataSize, allSJ.data+ii*oneSJ.dataSize, oneSJ.dataSize);
+            nSJpass++;
+            if (ii<allSJ.Ncollapsed)
+                nSJcollapsedPass++;
         };
-
-        sjChunks[icOut] += oneSJ.dataSize;//shift icOut-chunk by one junction
     };
+    allSJ.N=nSJpass;
+    allSJ.Ncollapsed=nSJcollapsedPass;//the passed junctions of the collapsed part stay sorted and collapsed, Ncollapsed<=N for collapseSJ
 
     bool* sjFilter=new bool[allSJ.N];
     if (P.outFilterBySJoutStage!=2) {
@@ -0,0 +1,162 @@
+#include "radixSort.h"
+
+#define RADIX_SORT_SMALL 32 //insertion sort for smaller buckets
+#define RADIX_SORT_WORDS_MAX 4
+
+static inline uint32 recordByte(const uint64 *rec, uint32 digit)
+{//digit=0 is the most significant byte of the 1st word
+    return (uint32) ( (rec[digit/8] >> (56-8*(digit%8))) & 255LLU );
+};
+
+static inline bool recordLess(const uint64 *ra, const uint64 *rb, uint32 word1, uint32 nWords)
+{//words before word1 are equal
+    for (uint32 iw=word1; iw<nWords; iw++) {
+        if (ra[iw]!=rb[iw])
+            return ra[iw]<rb[iw];
+    };
+    return false;
+};
+
+static void insertionSort(uint64 *a, uint64 n, uint32 nWords, uint32 word1)
+{
+    uint64 rec[RADIX_SORT_WORDS_MAX];
+    for (uint64 ii=1; ii<n; ii++) {
+        uint64 jj=ii;
+        if (!recordLess(a+ii*nWords, a+(jj-1)*nWords, word1, nWords))
+            continue;
+        memcpy(rec, a+ii*nWords, nWords*sizeof(uint64));
+        do {
+            memcpy(a+jj*nWords, a+(jj-1)*nWords, nWords*sizeof(uint64));
+            --jj;
+        } while (jj>0 && recordLess(rec, a+(jj-1)*nWords, word1, nWords));
+        memcpy(a+jj*nWords, rec, nWords*sizeof(uint64));
+    };
+};
+
+static bool partition(uint64 *a, uint64 n, uint32 nWords, uint32 &digit, uint64 *bucketStart)
+{//partition the records by the first byte (starting from digit) that is not the same for all records, bucketStart[257]
+ //returns false if all the records are identical
+    uint32 nDigits=8*nWords;
+
+    uint64 diff[RADIX_SORT_WORDS_MAX]={0}; //bits that differ from the 1st record
+    for (uint64 ii=1; ii<n; ii++) {
+        for (uint32 iw=digit/8; iw<nWords; iw++)
+            diff[iw] |= a[ii*nWords+iw] ^ a[iw];
+    };
+    for ( ; digit<nDigits; digit++) {
+        if (recordByte(diff, digit)!=0)
+            break;
+    };
+    if (digit==nDigits)
+        return false;
+
+    uint64 count[256]={0};
+    for (uint64 ii=0; ii<n; ii++)
+        count[recordByte(a+ii*nWords, digit)]++;
+
+    bucketStart[0]=0;
+    for (uint32 ib=0; ib<256; ib++)
+        bucketStart[ib+1]=bucketStart[ib]+count[ib];
+
+    //American flag sort: move each record into its bucket
+    uint64 next[256];
+    memcpy(next, bucketStart, sizeof(next));
+    uint64 rec[RADIX_SORT_WORDS_MAX];
+    for (uint32 ib=0; ib<256; ib++) {
+        while (next[ib]<bucketStart[ib+1]) {
+            uint32 b1=recordByte(a+next[ib]*nWords, digit);
+            if (b1==ib) {
+                ++next[ib];
+            } else {//swap with the next free place in its bucket
+                uint64 *r1=a+next[ib]*nWords, *r2=a+next[b1]*nWords;
+                memcpy(rec, r1, nWords*sizeof(uint64));
+                memcpy(r1, r2, nWords*sizeof(uint64));
+                memcpy(r2, rec, nWords*sizeof(uint64));
+                ++next[b1];
+            };
+        };
+    };
+    return true;
+};
+
+static void radixSortRecursive(uint64 *a, uint64 n, uint32 nWords, uint32 digit)
+{
+    if (n<=RADIX_SORT_SMALL) {
+        insertionSort(a, n, nWords, digit/8);
+        return;
+    };
+
+    uint64 bucketStart[257];
+    if (!partition(a, n, nWords, digit, bucketStart))
+        return;
+
+    for (uint32 ib=0; ib<256; ib++) {
+        if (bucketStart[ib+1]-bucketStart[ib]>1)
+            radixSortRecursive(a+bucketStart[ib]*nWords, bucketStart[ib+1]-bucketStart[ib], nWords, digit+1);
+    };
+};
+
+void radixSortUint64(uint64 *a, uint64 n, uint32 nWords, int nThreads)
+{
+    if (n<=RADIX_SORT_SMALL || nThreads<=1) {
+        radixSortRecursive(a, n, nWords, 0);
+        return;
+    };
+
+    uint32 digit=0;
+    uint64 bucketStart[257];
+    if (!partition(a, n, nWords, digit, bucketStart))
+        return;
+
+    #pragma omp parallel for num_threads(nThreads) schedule(dynamic,1)
+    for (uint32 ib=0; ib<256; ib++) {
+        if (bucketStart[ib+1]-bucketStart[ib]>1)
+            radixSortRecursive(a+bucketStart[ib]*nWords, bucketStart[ib+1]-bucketStart[ib], nWords, digit+1);
+    };
+};
+
+void radixSortUint32Stable(uint32 *a, uint64 n, uint32 nWords, uint32 keyW, bool keyDescending, uint32 *buf)
+{
+    uint32 keyFlip = keyDescending ? (uint32)-1 : 0; //descending order is the ascending order of the inverted key
+
+    if (n<=RADIX_SORT_SMALL) {//insertion sort, stable
+        for (uint64 ii=1; ii<n; ii++) {
+            uint32 key1=a[ii*nWords+keyW]^keyFlip;
+            uint64 jj=ii;
+            while (jj>0 && (a[(jj-1)*nWords+keyW]^keyFlip)>key1)
+                --jj;
+            if (jj==ii)
+                continue;
+            memcpy(buf, a+ii*nWords, nWords*sizeof(uint32));
+            memmove(a+(jj+1)*nWords, a+jj*nWords, (ii-jj)*nWords*sizeof(uint32));
+            memcpy(a+jj*nWords, buf, nWords*sizeof(uint32));
+        };
+        return;
+    };
+
+    uint32 diff=0; //bits of the key that differ from the 1st record
+    for (uint64 ii=1; ii<n; ii++)
+        diff |= a[ii*nWords+keyW]^a[keyW];
+
+    uint32 *src=a, *dst=buf;
+    for (uint32 shift=0; shift<32; shift+=8) {//least significant byte first
+        if (((diff>>shift) & 255)==0)
+            continue; //this byte is the same for all records
+
+        uint64 count[257]={0};
+        for (uint64 ii=0; ii<n; ii++)
+            count[(((src[ii*nWords+keyW]^keyFlip)>>shift) & 255)+1]++;
+        for (uint32 ib=1; ib<257; ib++)
+            count[ib] += count[ib-1];
+
+        for (uint64 ii=0; ii<n; ii++) {
+            uint32 b1=((src[ii*nWords+keyW]^keyFlip)>>shift) & 255;
+            memcpy(dst+count[b1]*nWords, src+ii*nWords, nWords*sizeof(uint32));
+            ++count[b1];
+        };
+        swap(src,dst);
+    };
+
+    if (src!=a)
+        memcpy(a, src, n*nWords*sizeof(uint32));
+};
@@ -0,0 +1,15 @@
+#ifndef CODE_radixSort
+#define CODE_radixSort
+
+#include "IncludeDefine.h"
+
+//in-place MSD radix sort of n records of nWords uint64 words each, in the lexicographic order of the words, nWords<=4
+//gives the same order as qsort with funCompareArrays<uint64,nWords> (identical records are indistinguishable)
+//buckets of the first non-trivial byte are sorted in parallel by nThreads threads
+void radixSortUint64(uint64 *a, uint64 n, uint32 nWords, int nThreads);
+
+//stable LSD radix sort of n records of nWords uint32 words each by the key word keyW, ascending or descending
+//gives the same order as the stable qsort (glibc merge sort) with funCompareTypeShift<uint32,keyW>, buf: n*nWords words
+void radixSortUint32Stable(uint32 *a, uint64 n, uint32 nWords, uint32 keyW, bool keyDescending, uint32 *buf);
+
+#endif
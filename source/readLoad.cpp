@@ -1,6 +1,45 @@
 #include "readLoad.h"
 #include "ErrorWarning.h"
 
+inline void readLengthCheck(uint Lread, const char *readName, const char *Seq, Parameters &P)
+{
+    if (Lread<1) {
+        ostringstream errOut;
+        errOut << "EXITING because of FATAL ERROR in reads input: short read sequence line: " << Lread <<"\n";
+        errOut << "Read Name="<< readName <<'\n'<< "Read Sequence=\"" << Seq <<"\"\nDEF_readNameLengthMax="<< DEF_readNameLengthMax <<'\n'<< "DEF_readSeqLengthMax="<<DEF_readSeqLengthMax<<'\n';
+        exitWithError(errOut.str(),std::cerr, P.inOut->logMain, EXIT_CODE_INPUT_FILES, P);
+    };
+    if (Lread>DEF_readSeqLengthMax) {
+        ostringstream errOut;
+        errOut << "EXITING because of FATAL ERROR in reads input: Lread>=" << Lread << "   while DEF_readSeqLengthMax=" << DEF_readSeqLengthMax <<'\n'<< "Read Name="<<readName<<'\n';
+        errOut << "SOLUTION: increase DEF_readSeqLengthMax in IncludeDefine.h and re-compile STAR\n";
+        exitWithError(errOut.str(),std::cerr, P.inOut->logMain, EXIT_CODE_INPUT_FILES, P);
+    };
+};
+
+inline void qualityConvert(char *Qual, uint LreadOriginal, Parameters &P)
+{
+    if (P.outQSconversionAdd!=0) {
+        for (uint ii=0;ii<LreadOriginal;ii++) {
+            int qs=int(Qual[ii])+P.outQSconversionAdd;
+            if (qs<33) {
+                qs=33;
+            } else if (qs>126) {
+                qs=126;
+            };
+            Qual[ii]=qs;
+        };
+    };
+};
+
+inline void readNameTrim(char *readName, Parameters &P)
+{//trim read name TODO this is needed only for one mate
+    for (uint ii=0; ii<P.readNameSeparatorChar.size(); ii++) {
+        char* pSlash=strchr(readName,P.readNameSeparatorChar.at(ii)); //trim everything after ' '
+        if (pSlash!=NULL) *pSlash=0;
+    };
+};
+
 int readLoad(istream& readInStream, Parameters& P, uint& Lread, uint& LreadOriginal, \
             char* readName, char* Seq, char* SeqNum, char* Qual, vector<ClipMate> &clipOneMate, \
             uint &iReadAll, uint32 &readFilesIndex, char &readFilter, string &readNameExtra)
@@ -32,18 +71,7 @@ int readLoad(istream& readInStream, Parameters& P, uint& Lread, uint& LreadOrigi
 
     Lread=readInStream.gcount()-1;
 
-    if (Lread<1) {
-        ostringstream errOut;
-        errOut << "EXITING because of FATAL ERROR in reads input: short read sequence line: " << Lread <<"\n";
-        errOut << "Read Name="<< readName <<'\n'<< "Read Sequence=\"" << Seq <<"\"\nDEF_readNameLengthMax="<< DEF_readNameLengthMax <<'\n'<< "DEF_readSeqLengthMax="<<DEF_readSeqLengthMax<<'\n';
-        exitWithError(errOut.str(),std::cerr, P.inOut->logMain, EXIT_CODE_INPUT_FILES, P);
-    };
-    if (Lread>DEF_readSeqLengthMax) {
-        ostringstream errOut;
-        errOut << "EXITING because of FATAL ERROR in reads input: Lread>=" << Lread << "   while DEF_readSeqLengthMax=" << DEF_readSeqLengthMax <<'\n'<< "Read Name="<<readName<<'\n';
-        errOut << "SOLUTION: increase DEF_readSeqLengthMax in IncludeDefine.h and re-compile STAR\n";
-        exitWithError(errOut.str(),std::cerr, P.inOut->logMain, EXIT_CODE_INPUT_FILES, P);
-    };
+    readLengthCheck(Lread, readName, Seq, P);
 
     LreadOriginal=Lread;
 
@@ -68,17 +96,7 @@ int readLoad(istream& readInStream, Parameters& P, uint& Lread, uint& LreadOrigi
             errOut << readName <<'\n'<< Seq <<'\n'<< Qual <<'\n'<< "SOLUTION: fix your fastq file\n";
             exitWithError(errOut.str(),std::cerr, P.inOut->logMain, EXIT_CODE_INPUT_FILES, P);
         };
-        if (P.outQSconversionAdd!=0) {
-            for (uint ii=0;ii<LreadOriginal;ii++) {
-                int qs=int(Qual[ii])+P.outQSconversionAdd;
-                if (qs<33) {
-                    qs=33;
-                } else if (qs>126) {
-                    qs=126;
-                };
-                Qual[ii]=qs;
-            };
-        };
+        qualityConvert(Qual, LreadOriginal, P);
     
     } else if (readName[0]=='>') {//fasta format, assign Qtop to all qualities
         readFileType=1;
@@ -91,10 +109,62 @@ int readLoad(istream& readInStream, Parameters& P, uint& Lread, uint& LreadOrigi
         exitWithError(errOut.str(),std::cerr, P.inOut->logMain, EXIT_CODE_INPUT_FILES, P);
     };
 
-    //trim read name TODO this is needed only for one mate
-    for (uint ii=0; ii<P.readNameSeparatorChar.size(); ii++) {
-        char* pSlash=strchr(readName,P.readNameSeparatorChar.at(ii)); //trim everything after ' '
-        if (pSlash!=NULL) *pSlash=0;
-    };
+    readNameTrim(readName, P);
     return readFileType;
 };
+
+int readLoad(const char *chunkIn, const ChunkInRead &readIn, Parameters& P, uint& Lread, uint& LreadOriginal, \
+            char* readName, char* Seq, char* SeqNum, char* Qual, vector<ClipMate> &clipOneMate, \
+            uint &iReadAll, uint32 &readFilesIndex, char &readFilter, string &readNameExtra)
+{//load one read from the chunk array, using the positions and metadata recorded by the chunk reader
+    if (readIn.nameLen>=DEF_readNameLengthMax-1) {
+        ostringstream errOut;
+        errOut << "EXITING because of FATAL ERROR in reads input: read name is too long:" << readIn.nameLen <<"\nRead Name="<<string(chunkIn+readIn.nameStart, readIn.nameLen)<<"\nDEF_readNameLengthMax="<<DEF_readNameLengthMax<<'\n';
+        errOut << "SOLUTION: increase DEF_readNameLengthMax in IncludeDefine.h and re-compile STAR\n";
+        exitWithError(errOut.str(),std::cerr, P.inOut->logMain, EXIT_CODE_INPUT_FILES, P);
+    };
+    memcpy(readName, chunkIn+readIn.nameStart, readIn.nameLen);
+    readName[readIn.nameLen]=0;
+
+    iReadAll=readIn.iReadAll;
+    readFilter=readIn.readFilter;
+    readFilesIndex=readIn.readFilesIndex;
+    readNameExtra.assign(chunkIn+readIn.extraStart, readIn.extraLen);
+
+    Lread=readIn.seqLen;
+    if (Lread>DEF_readSeqLengthMax) {//check before copying
+        Seq[0]=0;
+        readLengthCheck(Lread, readName, Seq, P);
+    };
+    memcpy(Seq, chunkIn+readIn.seqStart, Lread);
+    Seq[Lread]=0;
+    readLengthCheck(Lread, readName, Seq, P);
+
+    LreadOriginal=Lread;
+
+    convertNucleotidesToNumbers(Seq,SeqNum,Lread);
+
+    if (readIn.fileType==2) //fastq: the '+' line is used if clipChunk is activated, only 5' for now
+        clipOneMate[0].clippedInfo=chunkIn[readIn.seqStart+readIn.seqLen+1];
+
+    clipOneMate[0].clip(Lread, SeqNum); //5p clip
+    clipOneMate[1].clip(Lread, SeqNum); //3p clip
+
+    if (readIn.fileType==2) {//fastq format, read qualities
+        if (readIn.qualLen != LreadOriginal) {//inconsistent read sequence and quality
+            ostringstream errOut;
+            errOut << "EXITING because of FATAL ERROR in reads input: quality string length is not equal to sequence length\n";
+            errOut << readName <<'\n'<< Seq <<'\n'<< string(chunkIn+readIn.qualStart, readIn.qualLen) <<'\n'<< "SOLUTION: fix your fastq file\n";
+            exitWithError(errOut.str(),std::cerr, P.inOut->logMain, EXIT_CODE_INPUT_FILES, P);
+        };
+        memcpy(Qual, chunkIn+readIn.qualStart, LreadOriginal);
+        Qual[LreadOriginal]=0;
+        qualityConvert(Qual, LreadOriginal, P);
+    } else {//fasta format, assign Qtop to all qualities
+        memset(Qual, 'A', LreadOriginal);
+        Qual[LreadOriginal]=0;
+    };
+
+    readNameTrim(readName, P);
+    return readIn.fileType;
+};
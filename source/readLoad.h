@@ -4,9 +4,13 @@
 #include "IncludeDefine.h"
 #include "Parameters.h"
 #include "SequenceFuns.h"
+#include "ChunkInQueue.h"
 
 int readLoad(istream& readInStream, Parameters& P, uint& Lread, uint& LreadOriginal, \
 		     char* readName, char* Seq, char* SeqNum, char* Qual, vector<ClipMate> &clipOneMate, \
 			 uint &iReadAll, uint32 &readFilesIndex, char &readFilter, string &readNameExtra);
+int readLoad(const char *chunkIn, const ChunkInRead &readIn, Parameters& P, uint& Lread, uint& LreadOriginal, \
+		     char* readName, char* Seq, char* SeqNum, char* Qual, vector<ClipMate> &clipOneMate, \
+			 uint &iReadAll, uint32 &readFilesIndex, char &readFilter, string &readNameExtra);
 
 #endif
@@ -0,0 +1,95 @@
+#include "seqMatchLength.h"
+
+/* Comparison of the read and genome sequences: number of matching bases before the first mismatch.
+ * The vector kernels compare 16 (SSE4.2) or 32 (AVX2) bases at once, the first mismatch is found from the movemask of the comparison.
+ * Reverse direction is loaded backwards and reversed with a byte shuffle.
+ * No page-boundary checks are needed for the vector loads: a load is issued only while it is within N, and the callers bound N
+ * by the compared length (N-L in compareSeqToGenome, Lrun<=L in extendAlign). Hence a load reaches at most 31 bytes past the first
+ * stop byte (mismatch, N, spacer), which stays inside the L=200 padding before and after the genome G, and inside the read buffer.
+ */
+
+#if defined(__x86_64__) && defined(__GNUC__)
+    #define SEQ_MATCH_X86
+    #include <immintrin.h>
+#endif
+
+static uint64 seqMatchLengthScalar(const char *s, int ds, const char *g, int dg, uint64 N, bool stopN)
+{
+    uint64 ii;
+    for (ii=0; ii<N; ii++) {
+        char s1=s[ds*(int64)ii];
+        if (s1!=g[dg*(int64)ii] || (stopN && s1>3))
+            break;
+    };
+    return ii;
+};
+
+#ifdef SEQ_MATCH_X86
+
+__attribute__((target("sse4.2")))
+static uint64 seqMatchLengthSSE(const char *s, int ds, const char *g, int dg, uint64 N, bool stopN)
+{
+    const __m128i rev=_mm_setr_epi8(15,14,13,12,11,10,9,8,7,6,5,4,3,2,1,0);
+    const __m128i n4=_mm_set1_epi8(4);
+
+    uint64 ii=0;
+    while (ii+16<=N) {
+        const char *s1=s+ds*(int64)ii, *g1=g+dg*(int64)ii;
+        __m128i vs = ds>0 ? _mm_loadu_si128((const __m128i*) s1) : _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*) (s1-15)), rev);
+        __m128i vg = dg>0 ? _mm_loadu_si128((const __m128i*) g1) : _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*) (g1-15)), rev);
+        __m128i m=_mm_cmpeq_epi8(vs,vg);
+        if (stopN)
+            m=_mm_and_si128(m, _mm_cmpgt_epi8(n4,vs));
+        uint32 mm=(uint32) _mm_movemask_epi8(m);
+        if (mm!=0xFFFF)
+            return ii+__builtin_ctz(~mm);
+        ii+=16;
+    };
+    return ii+seqMatchLengthScalar(s+ds*(int64)ii, ds, g+dg*(int64)ii, dg, N-ii, stopN);
+};
+
+__attribute__((target("avx2")))
+static inline __m256i loadDir32(const char *p, int d)
+{//32 bytes in the direction d from p
+    if (d>0)
+        return _mm256_loadu_si256((const __m256i*) p);
+    const __m256i rev=_mm256_setr_epi8(15,14,13,12,11,10,9,8,7,6,5,4,3,2,1,0,15,14,13,12,11,10,9,8,7,6,5,4,3,2,1,0);
+    __m256i v=_mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*) (p-31)), rev);//reverse within 128-bit lanes
+    return _mm256_permute4x64_epi64(v, 0x4E);//swap lanes
+};
+
+__attribute__((target("avx2")))
+static uint64 seqMatchLengthAVX2(const char *s, int ds, const char *g, int dg, uint64 N, bool stopN)
+{
+    const __m256i n4=_mm256_set1_epi8(4);
+
+    uint64 ii=0;
+    while (ii+32<=N) {
+        const char *s1=s+ds*(int64)ii, *g1=g+dg*(int64)ii;
+        __m256i vs=loadDir32(s1,ds);
+        __m256i m=_mm256_cmpeq_epi8(vs,loadDir32(g1,dg));
+        if (stopN)
+            m=_mm256_and_si256(m, _mm256_cmpgt_epi8(n4,vs));
+        uint32 mm=(uint32) _mm256_movemask_epi8(m);
+        if (mm!=0xFFFFFFFF)
+            return ii+__builtin_ctz(~mm);
+        ii+=32;
+    };
+    return ii+seqMatchLengthSSE(s+ds*(int64)ii, ds, g+dg*(int64)ii, dg, N-ii, stopN);
+};
+
+#endif
+
+static seqMatchLengthFun seqMatchLengthSelect()
+{//choose the kernel for this CPU
+#ifdef SEQ_MATCH_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return seqMatchLengthAVX2;
+    if (__builtin_cpu_supports("sse4.2"))
+        return seqMatchLengthSSE;
+#endif
+    return seqMatchLengthScalar;
+};
+
+seqMatchLengthFun seqMatchLength=seqMatchLengthSelect();
@@ -0,0 +1,12 @@
+#ifndef CODE_seqMatchLength
+#define CODE_seqMatchLength
+
+#include "IncludeDefine.h"
+
+//number of leading positions ii<N where s[ds*ii]==g[dg*ii], ds,dg=+1 or -1 (forward or reverse)
+//stopN: also stop at the positions with s[ds*ii]>3 (Ns, spacers, chr padding)
+//vectorized with SSE4.2/AVX2 if the CPU supports it, selected at run time
+typedef uint64 (*seqMatchLengthFun)(const char *s, int ds, const char *g, int dg, uint64 N, bool stopN);
+extern seqMatchLengthFun seqMatchLength;
+
+#endif
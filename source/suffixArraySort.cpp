@@ -0,0 +1,149 @@
+#include "suffixArraySort.h"
+#include "radixSort.h"
+#include <algorithm>
+#include <functional>
+
+#define SA_SORT_SMALL 8 //comparison sort for smaller partitions
+#define SA_SORT_TASK_MIN 16384 //smallest partition sorted as a separate task
+#define SA_SORT_RADIX_MIN 256 //partitions of this size are radix-sorted by the cached words
+
+static inline uint suffixWordRaw(const char *G, uint ind, uint64 depth)
+{//8 bytes of the suffix starting at depth*8, the most significant byte first
+    return *(uint*)(G-7LLU+ind-8LLU*depth);
+};
+
+static inline uint spacerBytes(uint v)
+{//0x80 in each byte equal to the spacer
+    uint x=v^0x0505050505050505LLU;
+    return ~( ( (x & 0x7F7F7F7F7F7F7F7FLLU) + 0x7F7F7F7F7F7F7F7FLLU ) | x | 0x7F7F7F7F7F7F7F7FLLU );
+};
+
+static inline uint spacerMask(uint v, bool &spacer)
+{//zero the bytes after the first spacer
+    uint z=spacerBytes(v);
+    spacer = z!=0;
+    if (spacer)
+        v &= ~0LLU << ( (63-__builtin_clzll(z)) & ~7 );
+    return v;
+};
+
+static inline uint suffixWord(const char *G, uint ind, uint64 depth, bool &spacer)
+{//suffix word with the bytes after the first spacer zeroed
+    return spacerMask(suffixWordRaw(G, ind, depth), spacer);
+};
+
+static inline bool suffixLess(const char *G, uint64 L, uint64 depth, uint a, uint b)
+{//suffixes are equal before depth
+    for (uint64 d=depth; d<L; d++) {
+        uint va=suffixWordRaw(G, a, d), vb=suffixWordRaw(G, b, d);
+        if (va==vb) {
+            if (spacerBytes(va)!=0) //equal up to the spacer
+                break;
+            continue;
+        };
+        bool spacerA, spacerB;
+        va=spacerMask(va, spacerA);
+        vb=spacerMask(vb, spacerB);
+        if (va!=vb)
+            return va<vb;
+        break; //equal up to the spacer
+    };
+    return a>b;
+};
+
+static void suffixSortPart(uint *sa, uint64 n, const char *G, uint64 L, uint64 depth);
+
+static void suffixSortRadix(uint *sa, uint64 n, const char *G, uint64 L, uint64 depth)
+{//sort by the words at depth cached together with the inverted indexes, then sort the groups with equal words at the next depth
+    vector <uint64> rec(2*n);
+    for (uint64 ii=0; ii<n; ii++) {
+        bool spacer;
+        rec[2*ii]=suffixWord(G, sa[ii], depth, spacer);
+        rec[2*ii+1]=~sa[ii]; //equal suffixes: decreasing index
+    };
+    radixSortUint64(rec.data(), n, 2, 1);
+    for (uint64 ii=0; ii<n; ii++)
+        sa[ii]=~rec[2*ii+1];
+    vector<uint64>().swap(rec); //release before sorting the groups, the words are re-read from the genome
+
+    bool spacer1, spacer2=false;
+    uint v1=suffixWord(G, sa[0], depth, spacer1), v2=0;
+    for (uint64 i1=0; i1<n;) {
+        uint64 i2=i1+1;
+        while (i2<n && (v2=suffixWord(G, sa[i2], depth, spacer2))==v1)
+            ++i2;
+        if (i2-i1>1 && !spacer1) {//equal up to the spacer: already in the order of decreasing index
+            #pragma omp task if(i2-i1>=SA_SORT_TASK_MIN)
+            suffixSortPart(sa+i1, i2-i1, G, L, depth+1);
+        };
+        i1=i2;
+        v1=v2;
+        spacer1=spacer2;
+    };
+};
+
+static void suffixSortPart(uint *sa, uint64 n, const char *G, uint64 L, uint64 depth)
+{//suffixes in sa are equal before depth
+    while (true) {
+        if (depth>=L) {
+            std::sort(sa, sa+n, std::greater<uint>());
+            return;
+        };
+        if (n<SA_SORT_SMALL) {
+            std::sort(sa, sa+n, [G, L, depth](uint a, uint b) {return suffixLess(G, L, depth, a, b);});
+            return;
+        };
+        if (n>=SA_SORT_RADIX_MIN && n<=SA_SORT_RADIX_MAX) {
+            suffixSortRadix(sa, n, G, L, depth);
+            return;
+        };
+
+        //median of 3 pivot
+        bool spacer;
+        uint v[3]={suffixWord(G, sa[0], depth, spacer), suffixWord(G, sa[n/2], depth, spacer), suffixWord(G, sa[n-1], depth, spacer)};
+        uint pivot=max(min(v[0],v[1]), min(max(v[0],v[1]),v[2]));
+
+        //3-way partition: [0,lt) < pivot, [lt,gt) == pivot, [gt,n) > pivot
+        uint64 lt=0, gt=n;
+        bool pivotSpacer=false;
+        for (uint64 ii=0; ii<gt;) {
+            uint v1=suffixWord(G, sa[ii], depth, spacer);
+            if (v1<pivot) {
+                swap(sa[lt++], sa[ii++]);
+            } else if (v1>pivot) {
+                swap(sa[ii], sa[--gt]);
+            } else {
+                pivotSpacer=spacer;
+                ++ii;
+            };
+        };
+
+        if (lt>1) {
+            #pragma omp task if(lt>=SA_SORT_TASK_MIN)
+            suffixSortPart(sa, lt, G, L, depth);
+        };
+        if (n-gt>1) {
+            #pragma omp task if(n-gt>=SA_SORT_TASK_MIN)
+            suffixSortPart(sa+gt, n-gt, G, L, depth);
+        };
+
+        //suffixes equal to the pivot continue with the next word, or are equal up to the spacer
+        sa += lt;
+        n = gt-lt;
+        if (pivotSpacer) {
+            std::sort(sa, sa+n, std::greater<uint>());
+            return;
+        };
+        if (n<2)
+            return;
+        ++depth;
+    };
+};
+
+void suffixArraySort(uint *sa, uint64 n, const char *G, uint64 L)
+{
+    #pragma omp taskgroup
+    {
+        suffixSortPart(sa, n, G, L, 0);
+    };
+};
@@ -0,0 +1,14 @@
+#ifndef CODE_suffixArraySort
+#define CODE_suffixArraySort
+
+#include "IncludeDefine.h"
+
+//sort n suffixes of the reversed genome G (the suffix of index i is G[i],G[i-1],...) in the suffix array order of genomeGenerate:
+//suffixes are compared up to and including the first GENOME_spacingChar, and up to L 8-byte words;
+//the suffixes that are equal are placed in the order of decreasing index
+//multikey quicksort on 8-byte words, the partitions are sorted in parallel as OpenMP tasks if called inside a parallel region
+//each sorting thread uses up to 16*SA_SORT_RADIX_MAX bytes of temporary memory
+#define SA_SORT_RADIX_MAX 1048576
+void suffixArraySort(uint *sa, uint64 n, const char *G, uint64 L);
+
+#endif
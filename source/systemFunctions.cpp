@@ -2,6 +2,13 @@
 #include <string>
 #include <fstream>
 #include <sstream>
+#include <algorithm>
+#include <vector>
+#include <unistd.h>
+#ifdef __linux__
+    #include <sched.h>
+    #include <sys/syscall.h>
+#endif
 
 std::string linuxProcMemory()
 {
@@ -24,4 +31,182 @@ std::string linuxProcMemory()
     outString += '\n';
 
     return outString;
-};
\ No newline at end of file
+};
+
+std::string linuxProcMemoryPages(const void *addrStart, unsigned long long addrLength)
+{//page sizes of the memory mappings that overlap with the address range
+    unsigned long long a1=(unsigned long long) addrStart, a2=a1+addrLength;
+    unsigned long long kernelPageSize=0, rssKb=0, hugeKb=0;
+
+    std::ifstream smaps("/proc/self/smaps");
+    bool overlap=false;
+    std::string str1;
+    while (std::getline(smaps,str1)) {
+        unsigned long long m1, m2;
+        char dash;
+        std::istringstream line1(str1);
+        line1 >> std::hex >> m1 >> dash >> m2;
+        if (!line1.fail() && dash=='-') {//new mapping header line
+            overlap = m1<a2 && m2>a1;
+            continue;
+        };
+        if (!overlap)
+            continue;
+
+        std::string field1;
+        unsigned long long valueKb=0;
+        line1.clear();
+        line1.str(str1);
+        line1 >> std::dec >> field1 >> valueKb;
+        if (field1=="KernelPageSize:") {
+            kernelPageSize=std::max(kernelPageSize, valueKb);
+        } else if (field1=="Rss:") {
+            rssKb+=valueKb;
+        } else if (field1=="AnonHugePages:" || field1=="ShmemPmdMapped:" || field1=="FilePmdMapped:") {
+            hugeKb+=valueKb;
+        };
+    };
+
+    if (kernelPageSize==0)
+        return "page size information is not available\n";
+
+    std::ostringstream outStream;
+    outStream << "KernelPageSize=" << kernelPageSize << " kB; resident " << rssKb << " kB, of which in transparent huge pages " << hugeKb << " kB\n";
+    return outStream.str();
+};
+
+unsigned long long linuxHugePageSize()
+{//default huge page size in bytes, 0 if unknown
+    std::ifstream meminfo("/proc/meminfo");
+    std::string str1;
+    while (meminfo >> str1) {
+        if (str1=="Hugepagesize:") {
+            unsigned long long sizeKb=0;
+            meminfo >> sizeKb;
+            return sizeKb*1024;
+        };
+    };
+    return 0;
+};
+
+static std::vector<int> linuxParseList(const std::string &listString)
+{//parse kernel lists like 0-3,8,10-11
+    std::vector<int> listOut;
+    std::istringstream listStream(listString);
+    std::string range1;
+    while (std::getline(listStream, range1, ',')) {
+        int r1=-1, r2=-1;
+        char dash='-';
+        std::istringstream rangeStream(range1);
+        rangeStream >> r1;
+        if (rangeStream.fail())
+            continue;
+        if (!(rangeStream >> dash >> r2))
+            r2=r1;
+        for (int ii=r1; ii<=r2; ii++)
+            listOut.push_back(ii);
+    };
+    return listOut;
+};
+
+static std::string linuxReadLine(const std::string &fileName)
+{
+    std::ifstream file1(fileName);
+    std::string line1;
+    std::getline(file1, line1);
+    return line1;
+};
+
+void linuxNumaNodes(std::vector<int> &nodes, std::vector<std::vector<int>> &nodeCPUs)
+{
+    nodes.clear();
+    nodeCPUs.clear();
+#ifdef __linux__
+    cpu_set_t cpuAllowed;
+    CPU_ZERO(&cpuAllowed);
+    if (sched_getaffinity(0, sizeof(cpuAllowed), &cpuAllowed)!=0)
+        return;
+
+    std::vector<int> memsAllowed;
+    {//nodes allowed by cpuset
+        std::ifstream status1("/proc/self/status");
+        std::string str1;
+        while (std::getline(status1,str1)) {
+            if (str1.rfind("Mems_allowed_list:",0) == 0) {
+                std::istringstream line1(str1);
+                line1 >> str1 >> str1;
+                memsAllowed=linuxParseList(str1);
+            };
+        };
+    };
+
+    for (auto &node1 : linuxParseList(linuxReadLine("/sys/devices/system/node/has_memory"))) {
+        if (std::find(memsAllowed.begin(), memsAllowed.end(), node1) == memsAllowed.end())
+            continue;
+        std::vector<int> cpus1;
+        for (auto &cpu1 : linuxParseList(linuxReadLine("/sys/devices/system/node/node"+std::to_string(node1)+"/cpulist"))) {
+            if (cpu1<CPU_SETSIZE && CPU_ISSET(cpu1, &cpuAllowed))
+                cpus1.push_back(cpu1);
+        };
+        nodes.push_back(node1);
+        nodeCPUs.push_back(cpus1);
+    };
+#endif
+};
+
+#ifdef __linux__
+//memory policies from linux/mempolicy.h, numaif.h is not used to avoid dependency on libnuma
+#define LINUX_MPOL_DEFAULT 0
+#define LINUX_MPOL_BIND 2
+#define LINUX_MPOL_INTERLEAVE 3
+#define LINUX_MPOL_F_NODE 1
+#define LINUX_MPOL_F_ADDR 2
+#define LINUX_NODEMASK_WORDS 16 //up to 1024 nodes
+
+static unsigned long linuxNodeMask(const std::vector<int> &nodes, unsigned long *nodeMask)
+{
+    for (int ii=0; ii<LINUX_NODEMASK_WORDS; ii++)
+        nodeMask[ii]=0;
+    for (auto &node1 : nodes) {
+        if (node1 < LINUX_NODEMASK_WORDS*64)
+            nodeMask[node1/64] |= 1LU << (node1%64);
+    };
+    return LINUX_NODEMASK_WORDS*64;
+};
+#endif
+
+int linuxNumaBind(void *addrStart, unsigned long long addrLength, const std::vector<int> &nodes, bool interleave)
+{
+#ifdef __linux__
+    unsigned long nodeMask[LINUX_NODEMASK_WORDS];
+    unsigned long maxNode=linuxNodeMask(nodes, nodeMask);
+    return (int) syscall(SYS_mbind, addrStart, (unsigned long) addrLength, interleave ? LINUX_MPOL_INTERLEAVE : LINUX_MPOL_BIND, nodeMask, maxNode, 0);
+#else
+    return -1;
+#endif
+};
+
+int linuxNumaThreadInterleave(const std::vector<int> &nodes)
+{
+#ifdef __linux__
+    if (nodes.empty())
+        return (int) syscall(SYS_set_mempolicy, LINUX_MPOL_DEFAULT, NULL, 0);
+    unsigned long nodeMask[LINUX_NODEMASK_WORDS];
+    unsigned long maxNode=linuxNodeMask(nodes, nodeMask);
+    return (int) syscall(SYS_set_mempolicy, LINUX_MPOL_INTERLEAVE, nodeMask, maxNode);
+#else
+    return -1;
+#endif
+};
+
+int linuxNumaPageNode(const void *addr)
+{
+#ifdef __linux__
+    int node1=-1;
+    if (syscall(SYS_get_mempolicy, &node1, NULL, 0, addr, LINUX_MPOL_F_NODE | LINUX_MPOL_F_ADDR) != 0)
+        return -1;
+    return node1;
+#else
+    return -1;
+#endif
+};
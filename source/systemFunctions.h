@@ -2,5 +2,14 @@
 #include <string>
 
 std::string linuxProcMemory();
+std::string linuxProcMemoryPages(const void *addrStart, unsigned long long addrLength);
+unsigned long long linuxHugePageSize();
+
+#include <vector>
+//NUMA nodes with memory that can be used by this process, and CPUs of each node allowed for this process
+void linuxNumaNodes(std::vector<int> &nodes, std::vector<std::vector<int>> &nodeCPUs);
+int linuxNumaBind(void *addrStart, unsigned long long addrLength, const std::vector<int> &nodes, bool interleave); //mbind(), returns 0 on success
+int linuxNumaThreadInterleave(const std::vector<int> &nodes); //set_mempolicy() for the calling thread, empty nodes: default policy
+int linuxNumaPageNode(const void *addr); //node of the page, -1 if not known
 
 #endif
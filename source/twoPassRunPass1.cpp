@@ -70,6 +70,11 @@ void twoPassRunPass1(Parameters &P, Genome &genomeMain, Transcriptome *transcrip
     for (int ii=0;ii<P1.runThreadN;ii++) {
         RAchunk1[ii]=new ReadAlignChunk(P1, genomeMain, transcriptomeMain, ii);
     };
+    OutSJtable sjTable1(P1, RAchunk1[0]->RA->genOut); //junctions from all chunks
+    for (int ii=0;ii<P1.runThreadN;ii++) {
+        RAchunk1[ii]->sjTable=&sjTable1;
+        RAchunk1[ii]->sjTable1=NULL;
+    };
     mapThreadsSpawn(P1, RAchunk1);
     outputSJ(RAchunk1,P1); //collapse and output junctions
 //         for (int ii=0;ii<P1.runThreadN;ii++) {